@@ -37,6 +37,8 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/lexical_cast/try_lexical_convert.hpp>
 
+#include <boost/scope/scope_exit.hpp>
+
 #include "app_version.hpp"
 
 #include "binsrv/basic_logger.hpp"
@@ -78,6 +80,7 @@
 #include "util/byte_span_fwd.hpp"
 #include "util/command_line_helpers.hpp"
 #include "util/common_optional_types.hpp"
+#include "util/crc_helpers.hpp"
 #include "util/ct_string.hpp"
 #include "util/ctime_timestamp.hpp"
 #include "util/exception_location_helpers.hpp"
@@ -248,6 +251,53 @@ void log_replication_config_info(
   }
 }
 
+void log_s3_storage_config_info(
+    binsrv::basic_logger &logger,
+    const binsrv::s3_storage_config &s3_storage_config) {
+  log_config_param<"throughput_target_gbps">(
+      logger, s3_storage_config, "S3 client target throughput (Gbps)");
+  log_config_param<"part_size">(logger, s3_storage_config,
+                                "S3 client part size");
+  log_config_param<"max_connections">(logger, s3_storage_config,
+                                      "S3 client max connections");
+  log_config_param<"memory_limit">(logger, s3_storage_config,
+                                   "S3 client memory limit");
+  log_config_param<"staging_memory_limit">(logger, s3_storage_config,
+                                           "S3 staging memory limit");
+  log_config_param<"write_ahead_journal">(logger, s3_storage_config,
+                                          "S3 write-ahead journal");
+}
+
+void log_tiered_storage_config_info(
+    binsrv::basic_logger &logger,
+    const binsrv::tiered_storage_config &tiered_storage_config) {
+  logger.log(binsrv::log_severity::info,
+             "tiered storage cold tier URI (masked): " +
+                 tiered_storage_config.get_masked_cold_uri());
+  log_config_param<"max_local_size">(logger, tiered_storage_config,
+                                     "tiered storage max local size");
+  log_config_param<"max_local_age">(logger, tiered_storage_config,
+                                    "tiered storage max local age");
+}
+
+void log_storage_mirror_config_info(
+    binsrv::basic_logger &logger,
+    const binsrv::storage_mirror_config &storage_mirror_config) {
+  log_config_param<"backend">(logger, storage_mirror_config,
+                              "binlog storage mirror backend type");
+  logger.log(binsrv::log_severity::info,
+             "binlog storage mirror backend URI (masked): " +
+                 storage_mirror_config.get_masked_uri());
+  log_config_param<"queue_size">(logger, storage_mirror_config,
+                                 "binlog storage mirror queue size");
+  log_config_param<"required">(logger, storage_mirror_config,
+                               "binlog storage mirror required");
+  const auto &optional_s3_storage_config{storage_mirror_config.get<"s3">()};
+  if (optional_s3_storage_config.has_value()) {
+    log_s3_storage_config_info(logger, *optional_s3_storage_config);
+  }
+}
+
 void log_storage_config_info(binsrv::basic_logger &logger,
                              const binsrv::storage_config &storage_config) {
 
@@ -263,6 +313,46 @@ void log_storage_config_info(binsrv::basic_logger &logger,
       logger, storage_config, "binlog storage backend checkpointing size");
   log_config_param<"checkpoint_interval">(
       logger, storage_config, "binlog storage backend checkpointing interval");
+  log_config_param<"checkpoint_batching_window_ms">(
+      logger, storage_config,
+      "binlog storage backend checkpoint batching window (ms)");
+  log_config_param<"checkpoint_queue_size">(
+      logger, storage_config,
+      "binlog storage backend asynchronous checkpoint queue size");
+  log_config_param<"manifest_update_rotations">(
+      logger, storage_config,
+      "binlog storage manifest update frequency (rotations)");
+  log_config_param<"metadata_load_concurrency">(
+      logger, storage_config,
+      "binlog storage metadata loading concurrency");
+  log_config_param<"metadata_journal_snapshot_interval">(
+      logger, storage_config,
+      "binlog storage metadata journal snapshot interval (checkpoints)");
+  log_config_param<"preallocate_binlog_files">(
+      logger, storage_config, "binlog storage binlog file preallocation");
+  log_config_param<"event_buffer_memory_limit">(
+      logger, storage_config, "binlog storage event buffer memory limit");
+  const auto &optional_s3_storage_config{storage_config.get<"s3">()};
+  if (optional_s3_storage_config.has_value()) {
+    log_s3_storage_config_info(logger, *optional_s3_storage_config);
+  }
+  const auto &optional_tiered_storage_config{storage_config.get<"tiered">()};
+  if (optional_tiered_storage_config.has_value()) {
+    log_tiered_storage_config_info(logger, *optional_tiered_storage_config);
+  }
+  const auto &optional_storage_mirror_configs{storage_config.get<"mirrors">()};
+  if (optional_storage_mirror_configs.has_value()) {
+    for (const auto &storage_mirror_config : *optional_storage_mirror_configs) {
+      log_storage_mirror_config_info(logger, storage_mirror_config);
+    }
+  }
+}
+
+void log_storage_warnings(binsrv::basic_logger &logger,
+                          binsrv::storage &storage) {
+  for (const auto &warning : storage.extract_backend_warnings()) {
+    logger.log(binsrv::log_severity::warning, warning);
+  }
 }
 
 void log_storage_info(binsrv::basic_logger &logger,
@@ -295,6 +385,10 @@ void log_library_info(binsrv::basic_logger &logger,
   msg = "mysql client version: ";
   msg += mysql_lib.get_readable_client_version();
   logger.log(binsrv::log_severity::info, msg);
+
+  msg = "CRC32 implementation: ";
+  msg += util::get_crc32_kernel_name(util::get_active_crc32_kernel());
+  logger.log(binsrv::log_severity::info, msg);
 }
 
 void log_connection_info(binsrv::basic_logger &logger,
@@ -490,10 +584,14 @@ void process_rotate_or_stop_event(binsrv::basic_logger &logger,
              "storage: closed binlog file: " + old_binlog_name);
 }
 
+// 'reserved_in_storage' means that 'current_event_v' refers to the space
+// reserved by 'storage.reserve_event()', which is then either committed or
+// cancelled here instead of copying the event data into the storage
 void process_binlog_event(const binsrv::events::event_view &current_event_v,
                           binsrv::basic_logger &logger,
                           binsrv::events::reader_context &context,
-                          binsrv::storage &storage) {
+                          binsrv::storage &storage,
+                          bool reserved_in_storage = false) {
   const auto current_common_header_v{current_event_v.get_common_header_view()};
   const auto readable_flags{current_common_header_v.get_readable_flags()};
   logger.log(binsrv::log_severity::info,
@@ -538,7 +636,16 @@ void process_binlog_event(const binsrv::events::event_view &current_event_v,
   }
 
   // checking if the event needs to be written to the binlog
-  if (!info_only) {
+  if (info_only) {
+    if (reserved_in_storage) {
+      storage.cancel_reserved_event();
+    }
+  } else if (reserved_in_storage) {
+    storage.commit_event(context.is_at_transaction_boundary(),
+                         context.get_transaction_gtid(),
+                         current_common_header_v.get_timestamp(),
+                         context.get_transaction_sequence_number());
+  } else {
     storage.write_event(
         current_event_v.get_portion(), context.is_at_transaction_boundary(),
         context.get_transaction_gtid(), current_common_header_v.get_timestamp(),
@@ -782,12 +889,23 @@ void rewrite_and_process_binlog_event(
   }
 
   // in rewrite mode we need to update next_event_position (and optional
-  // checksum in the footer) in the received event data portion
-  binsrv::events::event_storage buffer{};
-  const auto event_copy_uv{binsrv::events::rewriter::rewrite(
-      storage.get_last_transaction_sequence_number(), current_event_v, buffer,
-      storage.get_current_position())};
-  process_binlog_event(event_copy_uv, logger, context, storage);
+  // checksum in the footer) in the received event data portion - the event
+  // is rewritten directly into the space reserved in the storage event
+  // buffer to avoid an intermediate copy
+  const auto last_sequence_number{
+      storage.get_last_transaction_sequence_number()};
+  const auto destination{storage.reserve_event(
+      binsrv::events::rewriter::get_rewritten_size(last_sequence_number,
+                                                   current_event_v))};
+  try {
+    const auto event_copy_uv{binsrv::events::rewriter::rewrite(
+        last_sequence_number, current_event_v, destination,
+        storage.get_current_position())};
+    process_binlog_event(event_copy_uv, logger, context, storage, true);
+  } catch (...) {
+    storage.cancel_reserved_event();
+    throw;
+  }
 }
 
 bool open_connection_and_switch_to_replication(
@@ -865,6 +983,17 @@ bool open_connection_and_switch_to_replication(
   return true;
 }
 
+bool fetch_binlog_event(easymysql::connection &connection,
+                        binsrv::storage &storage,
+                        util::const_byte_span &portion) {
+  // while waiting for the next event, the storage is allowed to perform
+  // interval-based checkpoints on its own
+  storage.begin_idle();
+  const boost::scope::scope_exit idle_guard{
+      [&storage]() noexcept { storage.end_idle(); }};
+  return connection.fetch_binlog_event(portion);
+}
+
 void receive_binlog_events(
     binsrv::operation_mode_type operation_mode,
     const volatile std::atomic_flag &termination_flag,
@@ -893,7 +1022,8 @@ void receive_binlog_events(
   bool fetch_result{};
 
   while (!termination_flag.test() &&
-         (fetch_result = connection.fetch_binlog_event(portion)) &&
+         (fetch_result =
+              fetch_binlog_event(connection, storage, portion)) &&
          !portion.empty()) {
     if (portion[0] != expected_event_packet_prefix) {
       util::exception_location().raise<std::runtime_error>(
@@ -915,6 +1045,7 @@ void receive_binlog_events(
     } else {
       process_binlog_event(current_event_v, logger, context, storage);
     }
+    log_storage_warnings(logger, storage);
   }
   if (termination_flag.test()) {
     logger.log(binsrv::log_severity::info,
@@ -941,6 +1072,7 @@ void receive_binlog_events(
   // in the event buffer - this can be considered the third kind of
   // checkpointing (in addition to size-based and time-based ones)
   storage.flush_event_buffer();
+  log_storage_warnings(logger, storage);
 
   logger.log(binsrv::log_severity::info,
              "timed out waiting for events and disconnected");
@@ -1314,7 +1446,12 @@ int main(int argc, char *argv[]) {
     binsrv::storage storage{storage_config,
                             binsrv::storage_construction_mode_type::streaming,
                             replication_mode};
+    if (optional_rewrite_config.has_value()) {
+      storage.set_expected_binlog_file_size(
+          optional_rewrite_config->get<"file_size">().get_value());
+    }
     log_storage_info(*logger, storage);
+    log_storage_warnings(*logger, storage);
 
     const easymysql::library mysql_lib;
     logger->log(binsrv::log_severity::info, "initialized mysql client library");
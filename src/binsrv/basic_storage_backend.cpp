@@ -17,12 +17,17 @@
 
 #include <cstdint>
 #include <exception>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <vector>
 
-#include "util/byte_span_fwd.hpp"
+#include "util/byte_span.hpp"
 #include "util/exception_location_helpers.hpp"
 
 namespace binsrv {
@@ -42,17 +47,82 @@ void basic_storage_backend::put_object(std::string_view name,
   do_put_object(name, content);
 }
 
+void basic_storage_backend::append_to_object(std::string_view name,
+                                             util::const_byte_span content) {
+  do_append_to_object(name, content);
+}
+
+void basic_storage_backend::put_object_from_file(
+    std::string_view name, const std::filesystem::path &source_path) {
+  do_put_object_from_file(name, source_path);
+}
+
+void basic_storage_backend::get_object_into_file(
+    std::string_view name, const std::filesystem::path &destination_path) {
+  do_get_object_into_file(name, destination_path);
+}
+
+void basic_storage_backend::do_put_object_from_file(
+    std::string_view name, const std::filesystem::path &source_path) {
+  std::ifstream source_ifs{source_path,
+                           std::ios_base::in | std::ios_base::binary};
+  if (!source_ifs.is_open()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot open source file for putting object");
+  }
+  const std::string content{std::istreambuf_iterator<char>{source_ifs},
+                            std::istreambuf_iterator<char>{}};
+  if (source_ifs.bad()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot read source file for putting object");
+  }
+  do_put_object(name, util::as_const_byte_span(content));
+}
+
+void basic_storage_backend::do_get_object_into_file(
+    std::string_view name, const std::filesystem::path &destination_path) {
+  const auto content{do_get_object(name)};
+  std::ofstream destination_ofs{destination_path, std::ios_base::out |
+                                                      std::ios_base::binary |
+                                                      std::ios_base::trunc};
+  if (!destination_ofs.is_open()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot open destination file for getting object");
+  }
+  const auto content_size{static_cast<std::streamsize>(std::size(content))};
+  if (!destination_ofs.write(std::data(content), content_size) ||
+      !destination_ofs.flush()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot write object content into destination file");
+  }
+}
+
 void basic_storage_backend::remove_object(std::string_view name) {
   do_remove_object(name);
   do_fsync();
 }
 
 void basic_storage_backend::remove_objects(std::span<const std::string> names) {
-  // Best-effort batch with delayed failure reporting: try every
-  // 'do_remove_object', remember the first failure (if any), always
+  // Best-effort batch with delayed failure reporting: let the backend
+  // try to remove every object, remember the failure (if any), always
   // run the single 'do_fsync' barrier so the partial cleanup we did
   // achieve is durable, and finally re-raise the captured failure
   // so the caller can decide what to do.
+  std::exception_ptr remove_error;
+  try {
+    do_remove_objects(names);
+  } catch (...) {
+    remove_error = std::current_exception();
+  }
+  do_fsync();
+  if (remove_error) {
+    std::rethrow_exception(remove_error);
+  }
+}
+
+void basic_storage_backend::do_remove_objects(
+    std::span<const std::string> names) {
+  // try every 'do_remove_object' and remember the first failure (if any)
   std::exception_ptr first_error;
   for (const auto &name : names) {
     try {
@@ -63,7 +133,6 @@ void basic_storage_backend::remove_objects(std::span<const std::string> names) {
       }
     }
   }
-  do_fsync();
   if (first_error) {
     std::rethrow_exception(first_error);
   }
@@ -90,6 +159,40 @@ void basic_storage_backend::write_data_to_stream(util::const_byte_span data) {
   do_write_data_to_stream(data);
 }
 
+void basic_storage_backend::write_data_portions_to_stream(
+    std::span<const util::const_byte_span> portions) {
+  if (!stream_open_) {
+    util::exception_location().raise<std::logic_error>(
+        "cannot write to the stream as it has not been opened");
+  }
+  do_write_data_portions_to_stream(portions);
+}
+
+void basic_storage_backend::do_write_data_portions_to_stream(
+    std::span<const util::const_byte_span> portions) {
+  for (const auto portion : portions) {
+    do_write_data_to_stream(portion);
+  }
+}
+
+void basic_storage_backend::preallocate_stream(std::uint64_t size) {
+  if (!stream_open_) {
+    util::exception_location().raise<std::logic_error>(
+        "cannot preallocate the stream as it has not been opened");
+  }
+  do_preallocate_stream(size);
+}
+
+void basic_storage_backend::do_preallocate_stream(std::uint64_t /*size*/) {}
+
+void basic_storage_backend::sync_stream() {
+  if (!stream_open_) {
+    util::exception_location().raise<std::logic_error>(
+        "cannot sync the stream as it has not been opened");
+  }
+  do_sync_stream();
+}
+
 void basic_storage_backend::close_stream() {
   if (!stream_open_) {
     util::exception_location().raise<std::logic_error>(
@@ -99,6 +202,12 @@ void basic_storage_backend::close_stream() {
   stream_open_ = false;
 }
 
+void basic_storage_backend::prepare_for_streaming() {
+  do_prepare_for_streaming();
+}
+
+void basic_storage_backend::do_prepare_for_streaming() {}
+
 [[nodiscard]] std::string basic_storage_backend::get_description() const {
   return do_get_description();
 }
@@ -108,4 +217,14 @@ basic_storage_backend::get_object_uri(std::string_view name) const {
   return do_get_object_uri(name);
 }
 
+[[nodiscard]] std::vector<std::string>
+basic_storage_backend::extract_warnings() {
+  return do_extract_warnings();
+}
+
+[[nodiscard]] std::vector<std::string>
+basic_storage_backend::do_extract_warnings() {
+  return {};
+}
+
 } // namespace binsrv
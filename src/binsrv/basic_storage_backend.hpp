@@ -18,9 +18,11 @@
 
 #include "binsrv/basic_storage_backend_fwd.hpp" // IWYU pragma: export
 
+#include <filesystem>
 #include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "util/byte_span_fwd.hpp"
 
@@ -37,33 +39,74 @@ public:
   virtual ~basic_storage_backend() = default;
 
   [[nodiscard]] storage_object_name_container list_objects();
+  // 'get_object' may be called simultaneously from several threads
+  // (as long as no other method is called at the same time), so
+  // 'do_get_object' implementations must not modify any shared state.
   [[nodiscard]] std::string get_object(std::string_view name);
   // 'put_object' is an atomic overwrite: a concurrent / post-crash
   // reader either sees the previous bytes in full or the new bytes in
   // full, never a partial mix.
   void put_object(std::string_view name, util::const_byte_span content);
+  // Appends 'content' to the end of an already existing object and
+  // makes the result durable. Unlike 'put_object', this operation is
+  // not atomic: after a crash a reader may see the previous bytes
+  // followed by any prefix of 'content'.
+  void append_to_object(std::string_view name, util::const_byte_span content);
+  // Same as 'put_object' but the content is read from the local file
+  // 'source_path', so that large objects do not have to be loaded in
+  // memory. The file must not be modified until the call returns.
+  void put_object_from_file(std::string_view name,
+                            const std::filesystem::path &source_path);
+  // Writes the content of the object into the local file 'destination_path'
+  // (overwriting it). Durability of the file is the caller's responsibility.
+  void get_object_into_file(std::string_view name,
+                            const std::filesystem::path &destination_path);
   // Single-object remove followed by a durability barrier. On
   // return the unlink is durable against a power-loss / hard crash.
   void remove_object(std::string_view name);
   // Batch remove. Each name is dropped on a best-effort basis -
-  // failures do not abort the loop - and a single durability
+  // failures do not abort the batch - and a single durability
   // barrier runs once for the whole batch. If at least one
-  // per-name removal failed, the very first failure is re-raised
-  // out of this call after the barrier has run, so the caller
-  // learns that the batch was not 100% clean while still benefiting
-  // from the partial cleanup and the durability of whatever did
-  // succeed.
+  // per-name removal failed, an error is re-raised out of this
+  // call after the barrier has run, so the caller learns that the
+  // batch was not 100% clean while still benefiting from the
+  // partial cleanup and the durability of whatever did succeed.
   void remove_objects(std::span<const std::string> names);
 
   [[nodiscard]] bool is_stream_open() const noexcept { return stream_open_; }
   [[nodiscard]] std::uint64_t
   open_stream(std::string_view name, storage_backend_open_stream_mode mode);
   void write_data_to_stream(util::const_byte_span data);
+  // writes all the 'portions' one after another (scatter-gather)
+  void write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions);
+  // A hint that the stream is expected to grow up to 'size' bytes. Backends
+  // that can do so reserve the space in advance without changing the size
+  // of the object, any unused part of the reservation is released when the
+  // stream is closed.
+  void preallocate_stream(std::uint64_t size);
+  // Durability barrier for the stream: on return all the data written
+  // to the stream so far survives a power-loss / hard crash. Callers
+  // are expected to invoke it once per checkpoint, before updating
+  // any metadata that refers to this data.
+  void sync_stream();
   void close_stream();
 
+  // Called once, before anything else is done with the backend, by the
+  // storages opened for streaming (and never by the ones opened for
+  // querying, which may share the backend with a running streaming
+  // process). Brings the backend up to date with the data acknowledged
+  // during the previous run, e.g. by replaying local journals.
+  void prepare_for_streaming();
+
   [[nodiscard]] std::string get_description() const;
   [[nodiscard]] std::string get_object_uri(std::string_view name) const;
 
+  // Returns the descriptions of the non-fatal errors (e.g. a storage mirror
+  // that is no longer updated) that happened since the previous call. May
+  // be called from any thread.
+  [[nodiscard]] std::vector<std::string> extract_warnings();
+
 private:
   bool stream_open_{false};
 
@@ -71,7 +114,23 @@ private:
   [[nodiscard]] virtual std::string do_get_object(std::string_view name) = 0;
   virtual void do_put_object(std::string_view name,
                              util::const_byte_span content) = 0;
+  virtual void do_append_to_object(std::string_view name,
+                                   util::const_byte_span content) = 0;
+  // The default implementations load the whole object in memory and call
+  // 'do_put_object' / 'do_get_object'. Backends that can transfer objects
+  // directly from / to files should override them.
+  virtual void
+  do_put_object_from_file(std::string_view name,
+                          const std::filesystem::path &source_path);
+  virtual void
+  do_get_object_into_file(std::string_view name,
+                          const std::filesystem::path &destination_path);
   virtual void do_remove_object(std::string_view name) = 0;
+  // Best-effort batch remove (without durability barrier). The
+  // default implementation calls 'do_remove_object' for every name
+  // and re-raises the very first failure. Backends that can remove
+  // several objects in one request should override it.
+  virtual void do_remove_objects(std::span<const std::string> names);
   // Backend-specific durability barrier.
   virtual void do_fsync() = 0;
 
@@ -79,11 +138,24 @@ private:
   do_open_stream(std::string_view name,
                  storage_backend_open_stream_mode mode) = 0;
   virtual void do_write_data_to_stream(util::const_byte_span data) = 0;
+  // The default implementation calls 'do_write_data_to_stream' for every
+  // portion. Backends that can write several buffers in one operation
+  // should override it.
+  virtual void do_write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions);
+  // The default implementation ignores the hint.
+  virtual void do_preallocate_stream(std::uint64_t size);
+  virtual void do_sync_stream() = 0;
   virtual void do_close_stream() = 0;
 
+  // The default implementation does nothing.
+  virtual void do_prepare_for_streaming();
+
   [[nodiscard]] virtual std::string do_get_description() const = 0;
   [[nodiscard]] virtual std::string
   do_get_object_uri(std::string_view name) const = 0;
+  // The default implementation reports nothing.
+  [[nodiscard]] virtual std::vector<std::string> do_extract_warnings();
 };
 
 } // namespace binsrv
@@ -0,0 +1,71 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#ifndef BINSRV_BINLOG_FILE_METADATA_DELTA_HPP
+#define BINSRV_BINLOG_FILE_METADATA_DELTA_HPP
+
+#include "binsrv/binlog_file_metadata_delta_fwd.hpp" // IWYU pragma: export
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "binsrv/events/common_types.hpp"
+
+#include "binsrv/gtids/gtid_set.hpp"
+
+#include "util/ctime_timestamp.hpp"
+#include "util/nv_tuple.hpp"
+
+namespace binsrv {
+
+// A single entry of the binlog file metadata journal, describing the changes
+// made to the binlog file by one checkpoint. In contrast to
+// 'binlog_file_metadata', it does not include 'previous_gtids' (which never
+// change for an existing binlog file) and its 'added_gtids' contain only the
+// GTIDs added by this checkpoint. All other fields store absolute values, so
+// that applying the same entry more than once has no effect.
+class [[nodiscard]] binlog_file_metadata_delta {
+private:
+  using impl_type = util::nv_tuple<
+      // clang-format off
+      util::nv<"version", std::uint32_t>,
+      util::nv<"size", std::uint64_t>,
+      util::nv<"added_gtids", gtids::optional_gtid_set>,
+      util::nv<"min_timestamp", util::ctime_timestamp>,
+      util::nv<"max_timestamp", util::ctime_timestamp>,
+      util::nv<"last_sequence_number", events::seq_no_t>
+      // clang-format on
+      >;
+
+public:
+  binlog_file_metadata_delta();
+
+  explicit binlog_file_metadata_delta(std::string_view data);
+
+  [[nodiscard]] std::string str() const;
+
+  [[nodiscard]] auto &root() noexcept { return impl_; }
+  [[nodiscard]] const auto &root() const noexcept { return impl_; }
+
+private:
+  impl_type impl_;
+
+  void validate() const;
+};
+
+} // namespace binsrv
+
+#endif // BINSRV_BINLOG_FILE_METADATA_DELTA_HPP
@@ -15,12 +15,14 @@
 
 #include "binsrv/events/event_view.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
 // needed for 'event_storage'
 #include <boost/container/small_vector.hpp> // IWYU pragma: keep
@@ -38,9 +40,35 @@
 #include "util/conversion_helpers.hpp"
 #include "util/crc_helpers.hpp"
 #include "util/exception_location_helpers.hpp"
+#include "util/thread_pool.hpp"
 
 namespace binsrv::events {
 
+namespace {
+
+// Checksums of huge events (e.g. multi-megabyte ROWS or TRANSACTION_PAYLOAD
+// events produced by bulk loads) are verified by several threads, so that
+// the receiving thread is blocked for a shorter time. Below this size
+// handing the chunks over to other threads costs more than it saves.
+constexpr std::size_t parallel_checksum_min_size{8U * 1024U * 1024U};
+// small enough to balance the load between threads, large enough for the
+// cost of combining the checksums of the chunks to be negligible
+constexpr std::size_t parallel_checksum_chunk_size{1024U * 1024U};
+// checksumming is memory-bound, so more threads than this do not make it
+// any faster and only take CPU time away from the rest of the process
+constexpr std::size_t max_parallel_checksum_concurrency{8U};
+
+// created on the first huge event, so that no threads are started unless
+// they are needed
+util::thread_pool &get_parallel_checksum_thread_pool() {
+  static util::thread_pool pool{
+      std::clamp(std::size_t{std::thread::hardware_concurrency()},
+                 std::size_t{1U}, max_parallel_checksum_concurrency)};
+  return pool;
+}
+
+} // anonymous namespace
+
 event_view_base::event_view_base(const reader_context &context,
                                  util::byte_span portion)
     : portion_{portion} {
@@ -135,10 +163,18 @@ event_view_base::event_view_base(const reader_context &context,
   }
 
   const auto footer_v{get_footer_view()};
-  if (calculate_crc() != footer_v.get_crc_raw()) {
+  const auto checksummed_portion{
+      get_portion().subspan(0U, get_total_size() - get_footer_size())};
+  const auto crc{std::size(checksummed_portion) >= parallel_checksum_min_size
+                     ? util::calculate_crc32_parallel(
+                           checksummed_portion, parallel_checksum_chunk_size,
+                           get_parallel_checksum_thread_pool())
+                     : calculate_crc()};
+  if (crc != footer_v.get_crc_raw()) {
     util::exception_location().raise<std::invalid_argument>(
         "event checksum mismatch");
   }
+  checksum_verified_ = true;
 }
 
 [[nodiscard]] std::uint32_t event_view_base::calculate_crc() const noexcept {
@@ -146,6 +182,14 @@ event_view_base::event_view_base(const reader_context &context,
       get_portion().subspan(0U, get_total_size() - get_footer_size()));
 }
 
+[[nodiscard]] std::uint32_t event_view_base::calculate_crc_with_known_body_crc(
+    std::uint32_t body_crc) const noexcept {
+  assert(util::calculate_crc32(get_body_raw()) == body_crc);
+  const auto headers_crc{util::calculate_crc32(get_portion().subspan(
+      0U, get_common_header_size() + get_post_header_size()))};
+  return util::combine_crc32(headers_crc, body_crc, get_body_size());
+}
+
 [[nodiscard]] common_header_view
 event_view_base::get_common_header_view() const {
   return common_header_view{get_common_header_raw()};
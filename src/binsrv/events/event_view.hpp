@@ -18,6 +18,10 @@
 
 #include "binsrv/events/event_view_fwd.hpp" // IWYU pragma: export
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
 #include "binsrv/events/common_header_view.hpp" // IWYU pragma: export
 #include "binsrv/events/footer_view.hpp"        // IWYU pragma: export
 #include "binsrv/events/protocol_traits_fwd.hpp"
@@ -42,6 +46,10 @@ public:
   }
 
   [[nodiscard]] std::uint32_t calculate_crc() const noexcept;
+  // calculates the same value as 'calculate_crc()' when CRC32 of the body is
+  // already known - only the common header and the post header are processed
+  [[nodiscard]] std::uint32_t
+  calculate_crc_with_known_body_crc(std::uint32_t body_crc) const noexcept;
 
   // common header section
   [[nodiscard]] static std::size_t get_common_header_size() noexcept {
@@ -102,6 +110,11 @@ public:
   }
   [[nodiscard]] footer_view get_footer_view() const;
   [[nodiscard]] footer_updatable_view get_footer_updatable_view() const;
+  // true if the checksum in the footer was verified against the data when
+  // this view was constructed (modifications made later are not tracked)
+  [[nodiscard]] bool is_checksum_verified() const noexcept {
+    return checksum_verified_;
+  }
 
 protected:
   // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
@@ -121,6 +134,7 @@ private:
   util::byte_span portion_{};
   std::size_t post_header_size_{0U};
   std::size_t footer_size_{0U};
+  bool checksum_verified_{false};
 };
 
 class [[nodiscard]] event_updatable_view : private event_view_base {
@@ -163,7 +177,10 @@ public:
     ~write_proxy() {
       if (parent_->has_footer()) {
         const auto footer_v{parent_->get_footer_updatable_view()};
-        footer_v.set_crc_raw(parent_->calculate_crc());
+        footer_v.set_crc_raw(
+            body_crc_.has_value()
+                ? parent_->calculate_crc_with_known_body_crc(*body_crc_)
+                : parent_->calculate_crc());
       }
     }
 
@@ -191,10 +208,12 @@ public:
     }
 
   private:
-    explicit write_proxy(const event_updatable_view &parent)
-        : parent_{&parent} {}
+    write_proxy(const event_updatable_view &parent,
+                const std::optional<std::uint32_t> &body_crc)
+        : parent_{&parent}, body_crc_{body_crc} {}
 
     const event_view_base *parent_;
+    std::optional<std::uint32_t> body_crc_;
   };
 
   event_updatable_view(const reader_context &context, util::byte_span portion)
@@ -220,11 +239,18 @@ public:
   // clang-format on
 
   [[nodiscard]] write_proxy get_write_proxy() const {
-    return write_proxy{*this};
+    return write_proxy{*this, {}};
   }
 
 private:
   using event_view_base::event_view_base;
+
+  // used by the rewriter, which calculates CRC32 of the body while copying
+  // it - the body must not be modified through the returned proxy
+  [[nodiscard]] write_proxy
+  get_write_proxy(const std::optional<std::uint32_t> &body_crc) const {
+    return write_proxy{*this, body_crc};
+  }
 };
 
 class [[nodiscard]] event_view : private event_view_base {
@@ -265,6 +291,7 @@ public:
   using event_view_base::has_footer;
   using event_view_base::get_footer_raw;
   using event_view_base::get_footer_view;
+  using event_view_base::is_checksum_verified;
   // clang-format on
 
 private:
@@ -19,6 +19,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <stdexcept>
 #include <string_view>
 
@@ -34,10 +35,23 @@
 #include "binsrv/events/protocol_traits_fwd.hpp"
 
 #include "util/byte_span_fwd.hpp"
+#include "util/crc_helpers.hpp"
 #include "util/exception_location_helpers.hpp"
 
 namespace binsrv::events {
 
+namespace {
+
+// for smaller bodies recalculating the checksum over the data that is still
+// in cache is cheaper than combining two checksums
+constexpr std::size_t fused_checksum_min_body_size{16U * 1024U};
+
+// patching the checksum of a relocated event costs about as much as
+// recalculating it over a few kilobytes
+constexpr std::size_t patched_checksum_min_event_size{4U * 1024U};
+
+} // anonymous namespace
+
 [[nodiscard]] event_updatable_view
 rewriter::materialize(const event_view &event_v, event_storage &buffer,
                       materialization_type mode) {
@@ -54,11 +68,47 @@ rewriter::materialize(const event_view &event_v, event_storage &buffer,
       });
 }
 
+[[nodiscard]] std::size_t
+rewriter::get_materialized_size(const event_view &event_v,
+                                materialization_type mode) noexcept {
+  std::size_t destination_footer_size{};
+  switch (normalize_materialization_mode(event_v, mode)) {
+  case materialization_type::force_add_checksum:
+    destination_footer_size = footer_view_base::size_in_bytes;
+    break;
+  case materialization_type::force_remove_checksum:
+    destination_footer_size = 0U;
+    break;
+  case materialization_type::leave_checksum_as_is:
+    destination_footer_size = event_v.get_footer_size();
+    break;
+  }
+  return event_v.get_total_size() - event_v.get_footer_size() +
+         destination_footer_size;
+}
+
 [[nodiscard]] event_updatable_view rewriter::materialize_and_relocate(
     const event_view &event_v, event_storage &buffer, materialization_type mode,
     std::uint64_t offset) {
+  return materialize_and_relocate(
+      event_v,
+      prepare_buffer_internal(buffer, get_materialized_size(event_v, mode)),
+      mode, offset);
+}
+
+[[nodiscard]] event_updatable_view rewriter::materialize_and_relocate(
+    const event_view &event_v, util::byte_span destination,
+    materialization_type mode, std::uint64_t offset) {
+  // a verified checksum implies that the source event has a footer, so
+  // 'force_add_checksum' here is the same as 'leave_checksum_as_is'
+  if (mode != materialization_type::force_remove_checksum &&
+      event_v.is_checksum_verified() &&
+      event_v.get_total_size() >= patched_checksum_min_event_size) {
+    return relocate_with_patched_checksum_internal(event_v, destination,
+                                                   offset);
+  }
   return generic_materialize(
-      event_v, buffer, mode,
+      event_v, destination, mode,
       [offset](materialization_type normalized_mode,
                const event_updatable_view::write_proxy &proxy) {
         const auto common_header_uv{proxy.get_common_header_updatable_view()};
@@ -72,75 +122,161 @@ rewriter::materialize(const event_view &event_v, event_storage &buffer,
       });
 }
 
-[[nodiscard]] event_updatable_view
-rewriter::prepare_generic_materialize_internal(const event_view &event_v,
-                                               event_storage &buffer,
-                                               materialization_type &mode) {
-  // mode adjustments for cases when nothing has to be changed
+[[nodiscard]] materialization_type
+rewriter::normalize_materialization_mode(const event_view &event_v,
+                                         materialization_type mode) noexcept {
   if (mode == materialization_type::force_remove_checksum &&
       !event_v.has_footer()) {
-    mode = materialization_type::leave_checksum_as_is;
+    return materialization_type::leave_checksum_as_is;
   }
   if (mode == materialization_type::force_add_checksum &&
       event_v.has_footer()) {
-    mode = materialization_type::leave_checksum_as_is;
+    return materialization_type::leave_checksum_as_is;
   }
+  return mode;
+}
+
+[[nodiscard]] util::byte_span
+rewriter::prepare_buffer_internal(event_storage &buffer, std::size_t size) {
+  // no need to zero-initialize the buffer as it is overwritten completely
+  buffer.resize(size, boost::container::default_init);
+  return util::byte_span{std::data(buffer), std::size(buffer)};
+}
+
+[[nodiscard]] event_updatable_view
+rewriter::prepare_generic_materialize_internal(
+    const event_view &event_v, util::byte_span destination,
+    materialization_type &mode, std::optional<std::uint32_t> &body_crc) {
+  mode = normalize_materialization_mode(event_v, mode);
 
   std::size_t destination_footer_size{};
-  // source does not have checksum, destination should
   switch (mode) {
-  case materialization_type::force_add_checksum: {
+  case materialization_type::force_add_checksum:
     // source does not have checksum, destination should
     assert(!event_v.has_footer());
-    const auto event_size_with_footer{event_v.get_total_size() +
-                                      footer_view_base::size_in_bytes};
-    const auto source_portion{event_v.get_portion()};
-    buffer.reserve(event_size_with_footer);
-    buffer.assign(std::cbegin(source_portion), std::cend(source_portion));
-    buffer.resize(event_size_with_footer);
     destination_footer_size = footer_view_base::size_in_bytes;
-  } break;
-  case materialization_type::force_remove_checksum: {
+    break;
+  case materialization_type::force_remove_checksum:
     // source has checksum, destination should not
     assert(event_v.has_footer());
-    const auto event_size_wo_footer{event_v.get_total_size() -
-                                    footer_view_base::size_in_bytes};
-    const auto source_portion{
-        event_v.get_portion().subspan(0U, event_size_wo_footer)};
-    buffer.assign(std::cbegin(source_portion), std::cend(source_portion));
     destination_footer_size = 0U;
-  } break;
-  case materialization_type::leave_checksum_as_is: {
+    break;
+  case materialization_type::leave_checksum_as_is:
     // either source has checksum and destination should or
     // source does not have checksum and destination should not
-    const auto source_portion{event_v.get_portion()};
-    buffer.assign(std::cbegin(source_portion), std::cend(source_portion));
     destination_footer_size = event_v.get_footer_size();
-  } break;
+    break;
+  }
+
+  // the source footer is never copied: it is either dropped or its checksum
+  // is recalculated (and written) when the write_proxy created by
+  // 'generic_materialize()' is destroyed
+  const auto source_portion{event_v.get_portion().subspan(
+      0U, event_v.get_total_size() - event_v.get_footer_size())};
+  if (std::size(destination) !=
+      std::size(source_portion) + destination_footer_size) {
+    util::exception_location().raise<std::invalid_argument>(
+        "destination size does not match the materialized event size");
   }
-  const util::byte_span destination_portion{std::begin(buffer),
-                                            std::size(buffer)};
+  const util::byte_span destination_portion{destination};
+
+  body_crc.reset();
+  if (destination_footer_size != 0U &&
+      event_v.get_body_size() >= fused_checksum_min_body_size) {
+    // the checksum of the body is calculated in the same pass over the data
+    // as copying, so that large events (e.g. multi-megabyte ROWS events) are
+    // read from memory only once instead of twice
+    const auto body_offset{event_v.get_common_header_size() +
+                           event_v.get_post_header_size()};
+    std::ranges::copy(source_portion.first(body_offset),
+                      std::begin(destination_portion));
+    body_crc = util::copy_and_update_crc32(
+        0U, source_portion.subspan(body_offset),
+        destination_portion.subspan(body_offset));
+  } else {
+    std::ranges::copy(source_portion, std::begin(destination_portion));
+  }
+
   event_updatable_view result{destination_portion,
                               event_v.get_post_header_size(),
                               destination_footer_size};
   return result;
 }
 
+[[nodiscard]] event_updatable_view
+rewriter::relocate_with_patched_checksum_internal(const event_view &event_v,
+                                                  util::byte_span destination,
+                                                  std::uint64_t offset) {
+  assert(event_v.is_checksum_verified());
+  const auto source_portion{event_v.get_portion()};
+  if (std::size(destination) != std::size(source_portion)) {
+    util::exception_location().raise<std::invalid_argument>(
+        "destination size does not match the relocated event size");
+  }
+  std::ranges::copy(source_portion, std::begin(destination));
+  const util::byte_span destination_portion{destination};
+  event_updatable_view result{destination_portion,
+                              event_v.get_post_header_size(),
+                              event_v.get_footer_size()};
+
+  // 'next_event_position' in the common header is the only field that
+  // changes, so instead of calculating the checksum over the whole event
+  // again, the old one (which is known to be correct) is adjusted for the
+  // difference in the common header
+  const auto total_size{result.get_total_size()};
+  result.get_common_header_updatable_view().set_next_event_position_raw(
+      static_cast<std::uint32_t>(offset + total_size));
+  const auto trailing_length{total_size - result.get_footer_size() -
+                             result.get_common_header_size()};
+  result.get_footer_updatable_view().set_crc_raw(util::patch_crc32(
+      event_v.get_footer_view().get_crc_raw(), event_v.get_common_header_raw(),
+      result.get_common_header_raw(), trailing_length));
+  assert(result.get_footer_view().get_crc_raw() == result.calculate_crc());
+  return result;
+}
+
 [[nodiscard]] event_updatable_view
 rewriter::rewrite(seq_no_t last_local_sequence_number,
                   const event_view &current_event_v,
                   binsrv::events::event_storage &buffer, std::uint64_t offset) {
+  return rewrite(
+      last_local_sequence_number, current_event_v,
+      prepare_buffer_internal(buffer,
+                              get_rewritten_size(last_local_sequence_number,
+                                                 current_event_v)),
+      offset);
+}
+
+[[nodiscard]] std::size_t
+rewriter::get_rewritten_size(seq_no_t last_local_sequence_number,
+                             const event_view &current_event_v) {
+  if (current_event_v.get_common_header_view().get_type_code() ==
+      code_type::gtid_tagged_log) {
+    generic_body_impl<code_type::gtid_tagged_log> updated_gtid_tagged_log_body{
+        current_event_v.get_body_raw()};
+    return prepare_gtid_tagged_log_body_internal(last_local_sequence_number,
+                                                 current_event_v,
+                                                 updated_gtid_tagged_log_body);
+  }
+  return get_materialized_size(current_event_v,
+                               materialization_type::force_add_checksum);
+}
+
+[[nodiscard]] event_updatable_view
+rewriter::rewrite(seq_no_t last_local_sequence_number,
+                  const event_view &current_event_v,
+                  util::byte_span destination, std::uint64_t offset) {
   switch (current_event_v.get_common_header_view().get_type_code()) {
   case code_type::gtid_log:
   case code_type::anonymous_gtid_log:
     return rewrite_gtid_log_internal(last_local_sequence_number,
-                                     current_event_v, buffer, offset);
+                                     current_event_v, destination, offset);
   case code_type::gtid_tagged_log:
-    return rewrite_gtid_tagged_log_internal(last_local_sequence_number,
-                                            current_event_v, buffer, offset);
+    return rewrite_gtid_tagged_log_internal(
+        last_local_sequence_number, current_event_v, destination, offset);
     break;
   default:
-    return materialize_and_relocate(current_event_v, buffer,
+    return materialize_and_relocate(current_event_v, destination,
                                     materialization_type::force_add_checksum,
                                     offset);
   }
@@ -175,7 +311,7 @@ void rewriter::fix_sequence_number_and_last_committed(
 
 [[nodiscard]] event_updatable_view rewriter::rewrite_gtid_log_internal(
     seq_no_t last_local_sequence_number, const event_view &current_event_v,
-    binsrv::events::event_storage &buffer, std::uint64_t offset) {
+    util::byte_span destination, std::uint64_t offset) {
   assert(current_event_v.get_common_header_view().get_type_code() ==
              code_type::gtid_log ||
          current_event_v.get_common_header_view().get_type_code() ==
@@ -220,22 +356,21 @@ void rewriter::fix_sequence_number_and_last_committed(
         // data span
         updated_gtid_log_post_header.encode_to(post_header_portion);
       }};
-  return generic_materialize(current_event_v, buffer,
+  return generic_materialize(current_event_v, destination,
                              materialization_type::force_add_checksum,
                              gtid_log_fixer);
 }
 
-[[nodiscard]] event_updatable_view rewriter::rewrite_gtid_tagged_log_internal(
+[[nodiscard]] std::size_t rewriter::prepare_gtid_tagged_log_body_internal(
     seq_no_t last_local_sequence_number, const event_view &current_event_v,
-    binsrv::events::event_storage &buffer, std::uint64_t offset) {
+    generic_body_impl<code_type::gtid_tagged_log>
+        &updated_gtid_tagged_log_body) {
   assert(current_event_v.get_common_header_view().get_type_code() ==
          code_type::gtid_tagged_log);
 
   // the original size of the current event
   const std::size_t original_event_size{current_event_v.get_total_size()};
 
-  generic_body_impl<code_type::gtid_tagged_log> updated_gtid_tagged_log_body{
-      current_event_v.get_body_raw()};
   // the original size of the transaction extracted from the event body
   const std::uint64_t original_transaction_length{
       updated_gtid_tagged_log_body.get_transaction_length_raw()};
@@ -296,16 +431,31 @@ void rewriter::fix_sequence_number_and_last_committed(
   // consistent with the transaction_length field in the event body. Moreover,
   // the transaction_length field in the event body has also been updated
   // accordingly.
+  return recalculated_event_size;
+}
 
-  // assembling the rewritten event in the provided buffer
+[[nodiscard]] event_updatable_view rewriter::rewrite_gtid_tagged_log_internal(
+    seq_no_t last_local_sequence_number, const event_view &current_event_v,
+    util::byte_span destination, std::uint64_t offset) {
+  generic_body_impl<code_type::gtid_tagged_log> updated_gtid_tagged_log_body{
+      current_event_v.get_body_raw()};
+  const auto recalculated_event_size{prepare_gtid_tagged_log_body_internal(
+      last_local_sequence_number, current_event_v,
+      updated_gtid_tagged_log_body)};
+
+  // assembling the rewritten event in the provided destination
   // recalculated_event_size includes
   // common_header size(19) + post_header size (0) + body size (variable) +
   // footer size (4)
-  buffer.resize(recalculated_event_size);
-  // copying common_header from the original event to the buffer
-  std::ranges::copy(current_event_v.get_common_header_raw(), buffer.begin());
+  if (std::size(destination) != recalculated_event_size) {
+    util::exception_location().raise<std::invalid_argument>(
+        "destination size does not match the rewritten event size");
+  }
+  // copying common_header from the original event to the destination
+  std::ranges::copy(current_event_v.get_common_header_raw(),
+                    std::begin(destination));
   // no need to copy post_header as its size is zero for GTID_TAGGED_LOG events
-  event_updatable_view result{buffer, 0U, default_footer_length};
+  event_updatable_view result{destination, 0U, default_footer_length};
   {
     // creating a write proxy here so that the crc in the footer is recalculated
     // at the end of this block when the proxy is destroyed
@@ -18,11 +18,17 @@
 
 #include "binsrv/events/rewriter_fwd.hpp" // IWYU pragma: export
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 
+#include "binsrv/events/code_type.hpp"
 #include "binsrv/events/common_types.hpp"
 #include "binsrv/events/event_fwd.hpp"
 #include "binsrv/events/event_view.hpp"
+#include "binsrv/events/gtid_tagged_log_body_impl_fwd.hpp"
+
+#include "util/byte_span_fwd.hpp"
 
 namespace binsrv::events {
 
@@ -39,8 +45,11 @@ public:
   //   footer with a checksum if and only if the original event has it.
   // This function will also call a generic 'modification_functor' that allows
   // to perform any additional modifications to the materialized event (e.g.
-  // change some fields in the common header, post header or body. The signature
-  // of the 'modification_functor' should be the following:
+  // change some fields in the common header or post header). The body must
+  // not be modified by the functor: for large events its checksum is
+  // calculated while copying it, before the functor is called, and only the
+  // headers are processed again afterwards. The signature of the
+  // 'modification_functor' should be the following:
   // void modify(
   //   materialization_type,
   //   const event_updatable_view::write_proxy
@@ -50,6 +59,19 @@ public:
   generic_materialize(const event_view &event_v, event_storage &buffer,
                       materialization_type mode,
                       const ModificationFunctor &modification_functor);
+  // The same as above, but the event is materialized into the caller-provided
+  // 'destination', which must be exactly 'get_materialized_size()' bytes long
+  // (e.g. space reserved directly in the storage event buffer).
+  template <typename ModificationFunctor>
+  [[nodiscard]] static event_updatable_view
+  generic_materialize(const event_view &event_v, util::byte_span destination,
+                      materialization_type mode,
+                      const ModificationFunctor &modification_functor);
+
+  // Returns the size of the event 'event_v' materialized in the 'mode'.
+  [[nodiscard]] static std::size_t
+  get_materialized_size(const event_view &event_v,
+                        materialization_type mode) noexcept;
 
   // Simplified materialization functions for one of the most common use cases
   // when no additional modifications are needed (only 'event_size' in the
@@ -62,10 +84,16 @@ public:
   // when the event needs to be put into a datafile at the specified 'offset'
   // (in this case 'next_event_position' in the common header will be updated
   // and 'event_size' in the common header may be updated if the footer was
-  // added or removed).
+  // added or removed). If the footer is preserved and its checksum was
+  // verified when 'event_v' was constructed, for large events the new
+  // checksum is derived from the old one instead of being recalculated.
   [[nodiscard]] static event_updatable_view
   materialize_and_relocate(const event_view &event_v, event_storage &buffer,
                            materialization_type mode, std::uint64_t offset);
+  [[nodiscard]] static event_updatable_view
+  materialize_and_relocate(const event_view &event_v,
+                           util::byte_span destination,
+                           materialization_type mode, std::uint64_t offset);
 
   // This methods performs required adjustments for event relocation:
   // - for all events it updates next_event_position field in the
@@ -83,12 +111,38 @@ public:
   rewrite(seq_no_t last_local_sequence_number,
           const event_view &current_event_v,
           binsrv::events::event_storage &buffer, std::uint64_t offset);
+  // The same as above, but the event is rewritten into the caller-provided
+  // 'destination', which must be exactly 'get_rewritten_size()' bytes long
+  // (the size may differ from the size of 'current_event_v').
+  [[nodiscard]] static std::size_t
+  get_rewritten_size(seq_no_t last_local_sequence_number,
+                     const event_view &current_event_v);
+  [[nodiscard]] static event_updatable_view
+  rewrite(seq_no_t last_local_sequence_number,
+          const event_view &current_event_v, util::byte_span destination,
+          std::uint64_t offset);
 
 private:
+  // mode adjustments for cases when nothing has to be changed
+  [[nodiscard]] static materialization_type
+  normalize_materialization_mode(const event_view &event_v,
+                                 materialization_type mode) noexcept;
+  // resizes 'buffer' to 'size' bytes without initializing them and returns
+  // its content
+  [[nodiscard]] static util::byte_span
+  prepare_buffer_internal(event_storage &buffer, std::size_t size);
+  // 'body_crc' is set to CRC32 of the copied body when the destination
+  // event has a footer and the body is large enough for calculating the
+  // checksum together with copying to pay off
   [[nodiscard]] static event_updatable_view
   prepare_generic_materialize_internal(const event_view &event_v,
-                                       event_storage &buffer,
-                                       materialization_type &mode);
+                                       util::byte_span destination,
+                                       materialization_type &mode,
+                                       std::optional<std::uint32_t> &body_crc);
+  [[nodiscard]] static event_updatable_view
+  relocate_with_patched_checksum_internal(const event_view &event_v,
+                                          util::byte_span destination,
+                                          std::uint64_t offset);
   // fixes the sequence_number and last_committed values extracted from
   // GTID_LOG and ANONYMOUS_GTID_LOG events based on the value of the last
   // written sequence_number in the binlog (last_local_sequence_number)
@@ -99,11 +153,18 @@ private:
 
   [[nodiscard]] static event_updatable_view rewrite_gtid_log_internal(
       seq_no_t last_local_sequence_number, const event_view &current_event_v,
-      binsrv::events::event_storage &buffer, std::uint64_t offset);
+      util::byte_span destination, std::uint64_t offset);
 
+  // fixes sequence_number, last_committed and transaction_length in the
+  // 'updated_gtid_tagged_log_body' extracted from 'current_event_v' and
+  // returns the size of the rewritten event
+  [[nodiscard]] static std::size_t prepare_gtid_tagged_log_body_internal(
+      seq_no_t last_local_sequence_number, const event_view &current_event_v,
+      generic_body_impl<code_type::gtid_tagged_log>
+          &updated_gtid_tagged_log_body);
   [[nodiscard]] static event_updatable_view rewrite_gtid_tagged_log_internal(
       seq_no_t last_local_sequence_number, const event_view &current_event_v,
-      binsrv::events::event_storage &buffer, std::uint64_t offset);
+      util::byte_span destination, std::uint64_t offset);
 };
 
 template <typename ModificationFunctor>
@@ -111,13 +172,26 @@ template <typename ModificationFunctor>
 rewriter::generic_materialize(const event_view &event_v, event_storage &buffer,
                               materialization_type mode,
                               const ModificationFunctor &modification_functor) {
+  return generic_materialize(
+      event_v,
+      prepare_buffer_internal(buffer, get_materialized_size(event_v, mode)),
+      mode, modification_functor);
+}
+
+template <typename ModificationFunctor>
+[[nodiscard]] event_updatable_view rewriter::generic_materialize(
+    const event_view &event_v, util::byte_span destination,
+    materialization_type mode,
+    const ModificationFunctor &modification_functor) {
+  std::optional<std::uint32_t> body_crc{};
   // mode may be modified (normalized) by this call
-  const auto result{
-      prepare_generic_materialize_internal(event_v, buffer, mode)};
+  const auto result{prepare_generic_materialize_internal(event_v, destination,
+                                                         mode, body_crc)};
   {
     // we are creating a write_proxy here so that the checksum will be properly
-    // recalculated after all modifications
-    const auto write_proxy{result.get_write_proxy()};
+    // recalculated after all modifications (if CRC32 of the body was
+    // calculated while copying it, only the headers are processed again)
+    const auto write_proxy{result.get_write_proxy(body_crc)};
     modification_functor(mode, write_proxy);
   }
   return result;
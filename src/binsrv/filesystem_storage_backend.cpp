@@ -23,6 +23,7 @@
 #include <ios>
 #include <iosfwd>
 #include <iterator>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -52,12 +53,9 @@ constexpr std::string_view tmp_object_suffix{".tmp"};
 
 filesystem_storage_backend::filesystem_storage_backend(
     const storage_config &config)
-    : root_path_{}, ofs_{} {
+    : root_path_{}, stream_file_{} {
   // TODO: switch to utf8 file names
 
-  // setting "unbuffered mode" as we will be using our own buffer
-  ofs_.rdbuf()->pubsetbuf(nullptr, 0U);
-
   const auto &backend_uri = config.get<"uri">();
 
   const auto uri_parse_result{boost::urls::parse_absolute_uri(backend_uri)};
@@ -219,6 +217,41 @@ void filesystem_storage_backend::do_put_object(std::string_view name,
   util::fsync(object_path.parent_path());
 }
 
+void filesystem_storage_backend::do_append_to_object(
+    std::string_view name, util::const_byte_span content) {
+  // in contrast to 'do_put_object', no temporary file is involved here:
+  // the new content is written at the end of the existing file, so the cost
+  // of this operation does not depend on the size of the object, and a
+  // single fsync(2) of the file itself is enough as its directory entry
+  // does not change
+  const auto object_path = get_object_path(name);
+  if (!std::filesystem::is_regular_file(object_path)) {
+    util::exception_location().raise<std::logic_error>(
+        "cannot append to a non-existing object");
+  }
+
+  std::ofstream object_ofs{};
+  object_ofs.rdbuf()->pubsetbuf(nullptr, 0U);
+  object_ofs.open(object_path, std::ios_base::out | std::ios_base::binary |
+                                   std::ios_base::app);
+  if (!object_ofs.is_open()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot open underlying object file for appending");
+  }
+  const auto content_sv = util::as_string_view(content);
+  if (!object_ofs.write(std::data(content_sv),
+                        static_cast<std::streamoff>(std::size(content_sv)))) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot append data to underlying object file");
+  }
+  object_ofs.close();
+  if (object_ofs.fail()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot close underlying object file");
+  }
+  util::fsync(object_path);
+}
+
 void filesystem_storage_backend::do_remove_object(std::string_view name) {
   const auto object_path = get_object_path(name);
   std::error_code remove_ec;
@@ -243,44 +276,42 @@ void filesystem_storage_backend::do_fsync() {
 
 [[nodiscard]] std::uint64_t filesystem_storage_backend::do_open_stream(
     std::string_view name, storage_backend_open_stream_mode mode) {
-  assert(!ofs_.is_open());
+  assert(!stream_file_.is_open());
   const std::filesystem::path current_file_path{get_object_path(name)};
 
-  const auto open_mode{std::ios_base::out | std::ios_base::binary |
-                       (mode == storage_backend_open_stream_mode::create
-                            ? std::ios_base::trunc
-                            : std::ios_base::app | std::ios_base::ate)};
-  ofs_.open(current_file_path, open_mode);
-  if (!ofs_.is_open()) {
-    util::exception_location().raise<std::runtime_error>(
-        "cannot open underlying file for the stream");
-  }
-
-  const auto open_position{static_cast<std::streamoff>(ofs_.tellp())};
-
-  return static_cast<std::uint64_t>(open_position);
+  return stream_file_.open(current_file_path,
+                           mode == storage_backend_open_stream_mode::create);
 }
 
 void filesystem_storage_backend::do_write_data_to_stream(
     util::const_byte_span data) {
-  assert(ofs_.is_open());
-  const auto data_sv = util::as_string_view(data);
-  if (!ofs_.write(std::data(data_sv),
-                  static_cast<std::streamoff>(std::size(data_sv)))) {
-    util::exception_location().raise<std::runtime_error>(
-        "cannot write data to the underlying stream file");
-  }
-  if (!ofs_.flush()) {
-    util::exception_location().raise<std::runtime_error>(
-        "cannot flush the underlying stream file");
-  }
-  // TODO: make sure that the data is properly written to the disk
-  //       use fsync() system call here
+  assert(stream_file_.is_open());
+  // the data goes directly to the OS page cache - making it durable is
+  // deferred until 'do_sync_stream()', so that a checkpoint costs a single
+  // fdatasync(2) regardless of how many writes it consists of
+  stream_file_.write(data);
+}
+
+void filesystem_storage_backend::do_write_data_portions_to_stream(
+    std::span<const util::const_byte_span> portions) {
+  assert(stream_file_.is_open());
+  // a single writev(2) call instead of one write(2) per portion
+  stream_file_.write(portions);
+}
+
+void filesystem_storage_backend::do_preallocate_stream(std::uint64_t size) {
+  assert(stream_file_.is_open());
+  stream_file_.preallocate(size);
+}
+
+void filesystem_storage_backend::do_sync_stream() {
+  assert(stream_file_.is_open());
+  stream_file_.datasync();
 }
 
 void filesystem_storage_backend::do_close_stream() {
-  assert(ofs_.is_open());
-  ofs_.close();
+  assert(stream_file_.is_open());
+  stream_file_.close();
 }
 
 [[nodiscard]] std::string
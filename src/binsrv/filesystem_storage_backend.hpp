@@ -17,15 +17,17 @@
 #define BINSRV_FILESYSTEM_STORAGE_BACKEND_HPP
 
 #include <filesystem>
-#include <fstream>
+#include <span>
 #include <string_view>
 
 #include "binsrv/basic_storage_backend.hpp" // IWYU pragma: export
 #include "binsrv/storage_config_fwd.hpp"
 
+#include "util/native_file_operations_helpers.hpp"
+
 namespace binsrv {
 
-class [[nodiscard]] filesystem_storage_backend final
+class [[nodiscard]] filesystem_storage_backend
     : public basic_storage_backend {
 public:
   static constexpr std::size_t max_memory_object_size{1048576U};
@@ -38,30 +40,46 @@ public:
     return root_path_;
   }
 
-private:
-  std::filesystem::path root_path_;
-  std::ofstream ofs_;
+protected:
+  [[nodiscard]] std::filesystem::path
+  get_object_path(std::string_view name) const;
+
+  // derived backends that perform stream writes on their own must still use
+  // this file (rather than their own copy) so that none of the inherited
+  // stream operations can ever be reached with a file that was never opened
+  [[nodiscard]] util::native_append_file &get_stream_file() noexcept {
+    return stream_file_;
+  }
 
+  // accessible to derived backends that need to order object operations
+  // with respect to their own stream operations
   [[nodiscard]] storage_object_name_container do_list_objects() override;
 
   [[nodiscard]] std::string do_get_object(std::string_view name) override;
   void do_put_object(std::string_view name,
                      util::const_byte_span content) override;
+  void do_append_to_object(std::string_view name,
+                           util::const_byte_span content) override;
   void do_remove_object(std::string_view name) override;
   void do_fsync() override;
 
+private:
+  std::filesystem::path root_path_;
+  util::native_append_file stream_file_;
+
   [[nodiscard]] std::uint64_t
   do_open_stream(std::string_view name,
                  storage_backend_open_stream_mode mode) override;
   void do_write_data_to_stream(util::const_byte_span data) override;
+  void do_write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions) override;
+  void do_preallocate_stream(std::uint64_t size) override;
+  void do_sync_stream() override;
   void do_close_stream() override;
 
   [[nodiscard]] std::string do_get_description() const override;
   [[nodiscard]] std::string
   do_get_object_uri(std::string_view name) const override;
-
-  [[nodiscard]] std::filesystem::path
-  get_object_path(std::string_view name) const;
 };
 
 } // namespace binsrv
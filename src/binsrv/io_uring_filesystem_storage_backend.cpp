@@ -0,0 +1,388 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "binsrv/io_uring_filesystem_storage_backend.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "binsrv/filesystem_storage_backend.hpp"
+#include "binsrv/storage_config.hpp"
+
+#include "util/byte_span.hpp"
+#include "util/exception_location_helpers.hpp"
+#include "util/native_file_operations_helpers.hpp"
+
+namespace binsrv {
+
+namespace {
+
+// 'user_data' values from 0 to 'max_in_flight_writes - 1' identify write
+// slots, this one identifies the 'fdatasync()' operation
+constexpr std::uint64_t sync_user_data{
+    std::numeric_limits<std::uint64_t>::max()};
+
+[[nodiscard]] std::string make_error_message(std::string_view prefix,
+                                             std::int32_t result) {
+  std::string message{prefix};
+  message += ": ";
+  message += std::error_code{-result, std::generic_category()}.message();
+  return message;
+}
+
+} // namespace
+
+io_uring_filesystem_storage_backend::io_uring_filesystem_storage_backend(
+    const storage_config &config)
+    : filesystem_storage_backend{config}, queue_{max_in_flight_writes + 1U},
+      slots_(max_in_flight_writes) {}
+
+io_uring_filesystem_storage_backend::~io_uring_filesystem_storage_backend() {
+  // the kernel may still be reading from the write slot buffers, so they
+  // must not be destroyed before all the operations are finished (this also
+  // applies the deferred object modifications)
+  // bugprone-empty-catch should not be that strict in destructors
+  try {
+    wait_for_all_operations();
+  } catch (...) { // NOLINT(bugprone-empty-catch)
+  }
+}
+
+[[nodiscard]] storage_object_name_container
+io_uring_filesystem_storage_backend::do_list_objects() {
+  wait_for_deferred_operations();
+  return filesystem_storage_backend::do_list_objects();
+}
+
+[[nodiscard]] std::string
+io_uring_filesystem_storage_backend::do_get_object(std::string_view name) {
+  wait_for_deferred_operations();
+  return filesystem_storage_backend::do_get_object(name);
+}
+
+void io_uring_filesystem_storage_backend::do_put_object(
+    std::string_view name, util::const_byte_span content) {
+  if (!must_defer_object_modifications()) {
+    filesystem_storage_backend::do_put_object(name, content);
+    return;
+  }
+  deferred_operations_.emplace_back(
+      [this, name = std::string{name},
+       data = std::string{util::as_string_view(content)}] {
+        filesystem_storage_backend::do_put_object(
+            name, util::as_const_byte_span(data));
+      });
+}
+
+void io_uring_filesystem_storage_backend::do_append_to_object(
+    std::string_view name, util::const_byte_span content) {
+  if (!must_defer_object_modifications()) {
+    filesystem_storage_backend::do_append_to_object(name, content);
+    return;
+  }
+  deferred_operations_.emplace_back(
+      [this, name = std::string{name},
+       data = std::string{util::as_string_view(content)}] {
+        filesystem_storage_backend::do_append_to_object(
+            name, util::as_const_byte_span(data));
+      });
+}
+
+void io_uring_filesystem_storage_backend::do_remove_object(
+    std::string_view name) {
+  if (!must_defer_object_modifications()) {
+    filesystem_storage_backend::do_remove_object(name);
+    return;
+  }
+  deferred_operations_.emplace_back([this, name = std::string{name}] {
+    filesystem_storage_backend::do_remove_object(name);
+  });
+}
+
+void io_uring_filesystem_storage_backend::do_fsync() {
+  // the durability barrier for removals must stay after them
+  if (!must_defer_object_modifications()) {
+    filesystem_storage_backend::do_fsync();
+    return;
+  }
+  deferred_operations_.emplace_back(
+      [this] { filesystem_storage_backend::do_fsync(); });
+}
+
+[[nodiscard]] std::uint64_t io_uring_filesystem_storage_backend::do_open_stream(
+    std::string_view name, storage_backend_open_stream_mode mode) {
+  auto &stream_file{get_stream_file()};
+  assert(!stream_file.is_open());
+  assert(number_of_in_flight_operations_ == 0U);
+  pending_error_.clear();
+  // the object modifications that failed while the previous stream was open
+  // must be applied before anything else
+  retry_deferred_operations();
+  next_offset_ = stream_file.open(
+      get_object_path(name), mode == storage_backend_open_stream_mode::create);
+  return next_offset_;
+}
+
+void io_uring_filesystem_storage_backend::do_write_data_to_stream(
+    util::const_byte_span data) {
+  write_portions_internal({&data, 1U});
+}
+
+void io_uring_filesystem_storage_backend::do_write_data_portions_to_stream(
+    std::span<const util::const_byte_span> portions) {
+  write_portions_internal(portions);
+}
+
+void io_uring_filesystem_storage_backend::do_preallocate_stream(
+    std::uint64_t size) {
+  auto &stream_file{get_stream_file()};
+  assert(stream_file.is_open());
+  stream_file.preallocate(size);
+}
+
+void io_uring_filesystem_storage_backend::do_sync_stream() {
+  assert(get_stream_file().is_open());
+  raise_if_pending_error();
+  // not waited for here - the object modifications that follow are deferred
+  // until it is finished instead
+  queue_sync();
+}
+
+void io_uring_filesystem_storage_backend::do_close_stream() {
+  auto &stream_file{get_stream_file()};
+  assert(stream_file.is_open());
+  wait_for_all_operations();
+  stream_file.close();
+  raise_if_pending_error();
+}
+
+[[nodiscard]] std::string
+io_uring_filesystem_storage_backend::do_get_description() const {
+  return "local filesystem (io_uring) - " + get_root_path().generic_string();
+}
+
+void io_uring_filesystem_storage_backend::write_portions_internal(
+    std::span<const util::const_byte_span> portions) {
+  assert(get_stream_file().is_open());
+  raise_if_pending_error();
+  std::size_t remaining_size{0U};
+  for (const auto portion : portions) {
+    remaining_size += std::size(portion);
+  }
+
+  // the data is gathered into write slots as the caller is allowed to reuse
+  // its buffers as soon as this call returns
+  std::size_t index{0U};
+  write_slot *slot{nullptr};
+  for (auto portion : portions) {
+    while (!portion.empty()) {
+      if (slot == nullptr) {
+        index = acquire_write_slot();
+        slot = &slots_[index];
+        slot->buffer.clear();
+        slot->buffer.reserve(std::min(remaining_size, max_write_slot_size));
+        slot->offset = next_offset_;
+        slot->written = 0U;
+      }
+      const auto part{portion.first(std::min(
+          std::size(portion), max_write_slot_size - std::size(slot->buffer)))};
+      slot->buffer.insert(std::end(slot->buffer), std::begin(part),
+                          std::end(part));
+      portion = portion.subspan(std::size(part));
+      remaining_size -= std::size(part);
+      next_offset_ += std::size(part);
+      if (std::size(slot->buffer) == max_write_slot_size) {
+        submit_write_slot(index);
+        slot = nullptr;
+      }
+    }
+  }
+  if (slot != nullptr) {
+    submit_write_slot(index);
+  }
+}
+
+[[nodiscard]] std::size_t
+io_uring_filesystem_storage_backend::acquire_write_slot() {
+  process_completions();
+  for (;;) {
+    for (std::size_t index{0U}; index < std::size(slots_); ++index) {
+      if (!slots_[index].in_flight) {
+        return index;
+      }
+    }
+    queue_.submit(1U);
+    process_completions();
+  }
+}
+
+void io_uring_filesystem_storage_backend::submit_write_slot(std::size_t index) {
+  auto &slot{slots_[index]};
+  const util::const_byte_span remaining{
+      util::const_byte_span{slot.buffer}.subspan(slot.written)};
+  queue_.queue_write(get_stream_file().get_descriptor(), remaining,
+                     slot.offset + slot.written, index);
+  slot.in_flight = true;
+  ++number_of_in_flight_operations_;
+  queue_.submit();
+}
+
+void io_uring_filesystem_storage_backend::queue_sync() {
+  queue_.queue_fdatasync(get_stream_file().get_descriptor(), sync_user_data);
+  ++number_of_in_flight_operations_;
+  ++number_of_in_flight_syncs_;
+  queue_.submit();
+}
+
+void io_uring_filesystem_storage_backend::process_completions() {
+  while (const auto completion{queue_.pop_completion()}) {
+    assert(number_of_in_flight_operations_ != 0U);
+    --number_of_in_flight_operations_;
+    if (completion->user_data == sync_user_data) {
+      assert(number_of_in_flight_syncs_ != 0U);
+      --number_of_in_flight_syncs_;
+      if (completion->result < 0 && pending_error_.empty()) {
+        pending_error_ = make_error_message(
+            "cannot sync underlying object file", completion->result);
+      }
+      if (number_of_in_flight_syncs_ == 0U) {
+        if (resubmitted_during_sync_ && pending_error_.empty()) {
+          // the re-submitted parts must be made durable as well before
+          // the deferred modifications are applied
+          resubmitted_during_sync_ = false;
+          queue_sync();
+        } else {
+          resubmitted_during_sync_ = false;
+          apply_deferred_operations();
+        }
+      }
+      continue;
+    }
+
+    const auto index{static_cast<std::size_t>(completion->user_data)};
+    assert(index < std::size(slots_));
+    auto &slot{slots_[index]};
+    slot.in_flight = false;
+    if (completion->result <= 0) {
+      if (pending_error_.empty()) {
+        pending_error_ =
+            completion->result == 0
+                ? std::string{"cannot write data to underlying object file: "
+                              "no progress"}
+                : make_error_message(
+                      "cannot write data to underlying object file",
+                      completion->result);
+      }
+      continue;
+    }
+    slot.written += static_cast<std::size_t>(completion->result);
+    if (slot.written < std::size(slot.buffer)) {
+      if (number_of_in_flight_syncs_ != 0U) {
+        resubmitted_during_sync_ = true;
+      }
+      submit_write_slot(index);
+    }
+  }
+}
+
+void io_uring_filesystem_storage_backend::wait_for_all_operations() {
+  process_completions();
+  while (number_of_in_flight_operations_ != 0U) {
+    queue_.submit(1U);
+    process_completions();
+  }
+}
+
+void io_uring_filesystem_storage_backend::raise_if_pending_error() {
+  if (!pending_error_.empty()) {
+    util::exception_location().raise<std::runtime_error>(pending_error_);
+  }
+  retry_deferred_operations();
+}
+
+[[nodiscard]] bool
+io_uring_filesystem_storage_backend::must_defer_object_modifications() {
+  if (number_of_in_flight_syncs_ != 0U) {
+    process_completions();
+    if (number_of_in_flight_syncs_ != 0U) {
+      return true;
+    }
+  }
+  // neither a modification that refers to the stream data that has not been
+  // written nor one that overtakes an earlier failed modification may be
+  // applied
+  raise_if_pending_error();
+  return false;
+}
+
+void io_uring_filesystem_storage_backend::apply_deferred_operations() {
+  // after a stream error, the modifications are discarded, as they may refer
+  // to stream data that has not been written
+  if (!pending_error_.empty()) {
+    deferred_operations_.clear();
+    return;
+  }
+  while (!deferred_operations_.empty()) {
+    try {
+      deferred_operations_.front()();
+    } catch (const std::exception &e) {
+      // the failed modification and the ones after it stay queued (in their
+      // original order) and are retried by the next object or stream
+      // operation, which raises this error if the retry fails as well
+      deferred_operation_error_ = e.what();
+      return;
+    }
+    deferred_operations_.pop_front();
+  }
+  deferred_operation_error_.clear();
+}
+
+void io_uring_filesystem_storage_backend::retry_deferred_operations() {
+  if (number_of_in_flight_syncs_ != 0U || deferred_operations_.empty()) {
+    return;
+  }
+  apply_deferred_operations();
+  if (!deferred_operations_.empty()) {
+    util::exception_location().raise<std::runtime_error>(
+        deferred_operation_error_);
+  }
+}
+
+void io_uring_filesystem_storage_backend::wait_for_deferred_operations() {
+  // checked without modifying anything, as 'do_get_object()' may be called
+  // from several threads at the same time (when no stream is open and no
+  // object modification has failed)
+  if (number_of_in_flight_syncs_ == 0U && deferred_operations_.empty()) {
+    return;
+  }
+  process_completions();
+  while (number_of_in_flight_syncs_ != 0U) {
+    queue_.submit(1U);
+    process_completions();
+  }
+  raise_if_pending_error();
+}
+
+} // namespace binsrv
@@ -0,0 +1,141 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#ifndef BINSRV_IO_URING_FILESYSTEM_STORAGE_BACKEND_HPP
+#define BINSRV_IO_URING_FILESYSTEM_STORAGE_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binsrv/filesystem_storage_backend.hpp" // IWYU pragma: export
+#include "binsrv/storage_config_fwd.hpp"
+
+#include "util/byte_span_fwd.hpp"
+#include "util/io_uring_queue.hpp"
+
+namespace binsrv {
+
+// A variant of the local filesystem storage backend in which binlog data
+// writes and the durability barriers ('fdatasync()' on checkpoints) are
+// performed asynchronously via Linux io_uring. 'do_write_data_to_stream()'
+// and 'do_write_data_portions_to_stream()' copy the data into the
+// preallocated write slots and return as soon as the writes are passed to
+// the kernel, so that receiving binlog events is not blocked on disk latency.
+// 'do_sync_stream()' does not wait for the 'fdatasync()' either: object
+// modifications (e.g. binlog metadata updates) made while it is in flight
+// are deferred until it is finished, so that no object can ever refer to
+// stream data that is not durable yet. Reading objects waits for the
+// deferred modifications to be applied. A deferred modification that fails
+// is kept queued (together with the ones after it) and retried by the next
+// object or stream operation, which raises its error if it fails again.
+// Object modifications themselves (tmp file writes, renames and directory
+// 'fsync()' calls) are still performed synchronously, and neither
+// registered buffers nor 'O_DIRECT' are used.
+// The stream file itself is owned by 'filesystem_storage_backend'. All
+// object operations are performed by it.
+class [[nodiscard]] io_uring_filesystem_storage_backend final
+    : public filesystem_storage_backend {
+public:
+  static constexpr std::uint32_t max_in_flight_writes{32U};
+  // larger writes are split into several slots, which also limits the
+  // amount of memory the slots keep
+  static constexpr std::size_t max_write_slot_size{4194304U};
+
+  explicit io_uring_filesystem_storage_backend(const storage_config &config);
+  io_uring_filesystem_storage_backend(
+      const io_uring_filesystem_storage_backend &) = delete;
+  io_uring_filesystem_storage_backend &
+  operator=(const io_uring_filesystem_storage_backend &) = delete;
+  io_uring_filesystem_storage_backend(io_uring_filesystem_storage_backend &&) =
+      delete;
+  io_uring_filesystem_storage_backend &
+  operator=(io_uring_filesystem_storage_backend &&) = delete;
+  ~io_uring_filesystem_storage_backend() override;
+
+private:
+  struct write_slot {
+    std::vector<std::byte> buffer;
+    std::uint64_t offset{0ULL};
+    std::size_t written{0U};
+    bool in_flight{false};
+  };
+  using write_slot_container = std::vector<write_slot>;
+
+  using deferred_operation = std::function<void()>;
+  using deferred_operation_container = std::deque<deferred_operation>;
+
+  std::uint64_t next_offset_{0ULL};
+  util::io_uring_queue queue_;
+  write_slot_container slots_;
+  std::size_t number_of_in_flight_operations_{0U};
+  std::size_t number_of_in_flight_syncs_{0U};
+  // set when a short write is completed by re-submitting its remaining part
+  // while a 'fdatasync()' is in flight, as that part is not covered by it
+  bool resubmitted_during_sync_{false};
+  // object modifications waiting for the in-flight 'fdatasync()' operations
+  deferred_operation_container deferred_operations_;
+  // the first error reported by the kernel for an asynchronous operation -
+  // it is raised from the next stream operation or object modification
+  std::string pending_error_;
+  // the error of the deferred object modification that failed last - it
+  // stays at the front of 'deferred_operations_' until a retry succeeds
+  std::string deferred_operation_error_;
+
+  [[nodiscard]] storage_object_name_container do_list_objects() override;
+
+  [[nodiscard]] std::string do_get_object(std::string_view name) override;
+  void do_put_object(std::string_view name,
+                     util::const_byte_span content) override;
+  void do_append_to_object(std::string_view name,
+                           util::const_byte_span content) override;
+  void do_remove_object(std::string_view name) override;
+  void do_fsync() override;
+
+  [[nodiscard]] std::uint64_t
+  do_open_stream(std::string_view name,
+                 storage_backend_open_stream_mode mode) override;
+  void do_write_data_to_stream(util::const_byte_span data) override;
+  void do_write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions) override;
+  void do_preallocate_stream(std::uint64_t size) override;
+  void do_sync_stream() override;
+  void do_close_stream() override;
+
+  [[nodiscard]] std::string do_get_description() const override;
+
+  void write_portions_internal(std::span<const util::const_byte_span> portions);
+
+  [[nodiscard]] std::size_t acquire_write_slot();
+  void submit_write_slot(std::size_t index);
+  void queue_sync();
+  void process_completions();
+  void wait_for_all_operations();
+  void raise_if_pending_error();
+
+  [[nodiscard]] bool must_defer_object_modifications();
+  void apply_deferred_operations();
+  void retry_deferred_operations();
+  void wait_for_deferred_operations();
+};
+
+} // namespace binsrv
+
+#endif // BINSRV_IO_URING_FILESYSTEM_STORAGE_BACKEND_HPP
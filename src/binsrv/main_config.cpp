@@ -75,6 +75,7 @@ main_config::main_config(std::string_view file_name) {
 void main_config::validate() const {
   root().get<"connection">().validate();
   root().get<"replication">().validate();
+  root().get<"storage">().validate();
 }
 
 } // namespace binsrv
@@ -0,0 +1,418 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include "binsrv/mirrored_storage_backend.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <boost/scope/scope_exit.hpp>
+
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include "binsrv/storage_backend_factory.hpp"
+#include "binsrv/storage_config.hpp"
+#include "binsrv/storage_mirror_config.hpp"
+
+#include "util/background_worker.hpp"
+#include "util/byte_span.hpp"
+#include "util/exception_location_helpers.hpp"
+
+namespace binsrv {
+
+mirrored_storage_backend::mirrored_storage_backend(
+    basic_storage_backend_ptr primary, const storage_config &config)
+    : primary_{std::move(primary)}, mirrors_{} {
+  const auto &optional_mirrors{config.get<"mirrors">()};
+  if (!optional_mirrors.has_value() || optional_mirrors->empty()) {
+    util::exception_location().raise<std::invalid_argument>(
+        "mirrored storage backend requires at least one mirror in storage "
+        "config");
+  }
+
+  // every mirror is configured exactly as a standalone storage backend of
+  // the specified type, sharing all the generic parameters with the primary
+  for (const auto &mirror_config : *optional_mirrors) {
+    auto backend_config{config};
+    backend_config.get<"backend">() = mirror_config.get<"backend">();
+    backend_config.get<"uri">() = mirror_config.get<"uri">();
+    backend_config.get<"s3">() = mirror_config.get<"s3">();
+    backend_config.get<"tiered">().reset();
+    backend_config.get<"mirrors">().reset();
+
+    auto &current{mirrors_.emplace_back(std::make_unique<mirror>())};
+    current->backend = storage_backend_factory::create(backend_config);
+    current->required = mirror_config.get<"required">().value_or(false);
+    current->worker = std::make_unique<util::background_worker>(
+        mirror_config.get<"queue_size">().value_or(default_mirror_queue_size));
+  }
+
+  // objects are transferred via a temporary file, so that large binlog
+  // files do not have to be loaded in memory
+  const auto &optional_fs_buffer_directory{
+      config.get<"fs_buffer_directory">()};
+  if (optional_fs_buffer_directory.has_value()) {
+    tmp_file_directory_ = *optional_fs_buffer_directory;
+  } else {
+    tmp_file_directory_ = std::filesystem::temp_directory_path();
+  }
+}
+
+mirrored_storage_backend::~mirrored_storage_backend() {
+  // bugprone-empty-catch should not be that strict in destructors
+  try {
+    // waiting for the pending operations before destroying the mirrors (the
+    // mirrors left behind because of an error are resynchronized on the
+    // next run)
+    for (auto &current : mirrors_) {
+      current->worker.reset();
+    }
+  } catch (...) { // NOLINT(bugprone-empty-catch)
+  }
+}
+
+[[nodiscard]] storage_object_name_container
+mirrored_storage_backend::do_list_objects() {
+  return primary_->list_objects();
+}
+
+[[nodiscard]] std::string
+mirrored_storage_backend::do_get_object(std::string_view name) {
+  return primary_->get_object(name);
+}
+
+void mirrored_storage_backend::do_put_object(std::string_view name,
+                                             util::const_byte_span content) {
+  const auto shared{std::make_shared<const std::string>(
+      util::as_string_view(content))};
+  submit_to_mirrors(
+      [name = std::string{name}, shared](basic_storage_backend &backend) {
+        backend.put_object(name, util::as_const_byte_span(*shared));
+      });
+  primary_->put_object(name, content);
+}
+
+void mirrored_storage_backend::do_append_to_object(
+    std::string_view name, util::const_byte_span content) {
+  const auto shared{std::make_shared<const std::string>(
+      util::as_string_view(content))};
+  submit_to_mirrors(
+      [name = std::string{name}, shared](basic_storage_backend &backend) {
+        backend.append_to_object(name, util::as_const_byte_span(*shared));
+      });
+  primary_->append_to_object(name, content);
+}
+
+void mirrored_storage_backend::do_put_object_from_file(
+    std::string_view name, const std::filesystem::path &source_path) {
+  // the file must not be modified until the mirrors have finished reading
+  // it, so these particular tasks (and not the whole mirror queues) are
+  // waited for before returning - a task that is never executed (e.g.
+  // because its mirror has been disabled) destroys its promise unsatisfied,
+  // which makes the corresponding future ready as well
+  std::vector<std::future<void>> mirror_tasks_finished;
+  mirror_tasks_finished.reserve(std::size(mirrors_));
+  const boost::scope::scope_exit mirror_tasks_guard{
+      [&mirror_tasks_finished]() noexcept {
+        for (const auto &task_finished : mirror_tasks_finished) {
+          task_finished.wait();
+        }
+      }};
+  for (const auto &current : mirrors_) {
+    const auto finished{std::make_shared<std::promise<void>>()};
+    mirror_tasks_finished.push_back(finished->get_future());
+    submit_to_mirror(*current, [&backend = *current->backend,
+                                name = std::string{name}, source_path,
+                                finished] {
+      const boost::scope::scope_exit finished_guard{
+          [&finished]() noexcept { finished->set_value(); }};
+      backend.put_object_from_file(name, source_path);
+    });
+  }
+  primary_->put_object_from_file(name, source_path);
+}
+
+void mirrored_storage_backend::do_get_object_into_file(
+    std::string_view name, const std::filesystem::path &destination_path) {
+  primary_->get_object_into_file(name, destination_path);
+}
+
+void mirrored_storage_backend::do_remove_object(std::string_view name) {
+  const std::array<std::string, 1U> names{std::string{name}};
+  do_remove_objects(names);
+}
+
+void mirrored_storage_backend::do_remove_objects(
+    std::span<const std::string> names) {
+  submit_to_mirrors(
+      [names = std::vector<std::string>(std::begin(names), std::end(names))](
+          basic_storage_backend &backend) { backend.remove_objects(names); });
+  primary_->remove_objects(names);
+}
+
+void mirrored_storage_backend::do_fsync() {
+  // intentional no-op: 'remove_objects()' called on the primary and on the
+  // mirrors in 'do_remove_objects()' already includes their own durability
+  // barriers
+}
+
+[[nodiscard]] std::uint64_t
+mirrored_storage_backend::do_open_stream(std::string_view name,
+                                         storage_backend_open_stream_mode mode) {
+  // unlike other operations, the primary goes first here, as the mirrors
+  // must be at exactly the same position
+  const auto offset{primary_->open_stream(name, mode)};
+  for (const auto &current : mirrors_) {
+    submit_to_mirror(
+        *current,
+        [&backend = *current->backend, name = std::string{name}, mode, offset] {
+          const auto mirror_offset{backend.open_stream(name, mode)};
+          if (mirror_offset != offset) {
+            util::exception_location().raise<std::logic_error>(
+                "storage mirror \"" + backend.get_description() +
+                "\" diverged from the primary storage backend: object \"" +
+                name + "\" has size " + std::to_string(mirror_offset) +
+                " instead of " + std::to_string(offset));
+          }
+        });
+  }
+  return offset;
+}
+
+void mirrored_storage_backend::do_write_data_to_stream(
+    util::const_byte_span data) {
+  const auto shared{
+      std::make_shared<const std::string>(util::as_string_view(data))};
+  submit_to_mirrors([shared](basic_storage_backend &backend) {
+    backend.write_data_to_stream(util::as_const_byte_span(*shared));
+  });
+  primary_->write_data_to_stream(data);
+}
+
+void mirrored_storage_backend::do_write_data_portions_to_stream(
+    std::span<const util::const_byte_span> all_portions) {
+  auto portions{all_portions};
+  // the portions refer to the storage event buffer, which is reused as soon
+  // as this call returns, so they are copied - in groups of bounded size, so
+  // that a large write (e.g. a spilled transaction) does not have to be
+  // copied in memory as a whole
+  while (!portions.empty()) {
+    std::size_t number_of_portions{0U};
+    std::size_t group_size{0U};
+    while (number_of_portions < std::size(portions) &&
+           group_size < max_shared_write_size) {
+      group_size += std::size(portions[number_of_portions]);
+      ++number_of_portions;
+    }
+    std::string gathered;
+    gathered.reserve(group_size);
+    for (const auto portion : portions.first(number_of_portions)) {
+      gathered += util::as_string_view(portion);
+    }
+    const auto shared{
+        std::make_shared<const std::string>(std::move(gathered))};
+    submit_to_mirrors([shared](basic_storage_backend &backend) {
+      backend.write_data_to_stream(util::as_const_byte_span(*shared));
+    });
+    portions = portions.subspan(number_of_portions);
+  }
+  primary_->write_data_portions_to_stream(all_portions);
+}
+
+void mirrored_storage_backend::do_preallocate_stream(std::uint64_t size) {
+  submit_to_mirrors([size](basic_storage_backend &backend) {
+    backend.preallocate_stream(size);
+  });
+  primary_->preallocate_stream(size);
+}
+
+void mirrored_storage_backend::do_sync_stream() {
+  // the durability barrier is waited for on the primary only, the mirrors
+  // perform theirs asynchronously
+  submit_to_mirrors(
+      [](basic_storage_backend &backend) { backend.sync_stream(); });
+  primary_->sync_stream();
+}
+
+void mirrored_storage_backend::do_close_stream() {
+  submit_to_mirrors(
+      [](basic_storage_backend &backend) { backend.close_stream(); });
+  primary_->close_stream();
+}
+
+void mirrored_storage_backend::do_prepare_for_streaming() {
+  primary_->prepare_for_streaming();
+
+  const auto tmp_file_path{
+      tmp_file_directory_ /
+      boost::uuids::to_string(boost::uuids::random_generator{}())};
+  const boost::scope::scope_exit tmp_file_guard{[&tmp_file_path]() noexcept {
+    std::error_code remove_ec;
+    std::filesystem::remove(tmp_file_path, remove_ec);
+  }};
+  // performed in the current thread before anything is written to the
+  // primary, so that the mirrors start from exactly the same state (as well
+  // as the rest of the streaming preparation, it is never done by the
+  // storages opened for querying)
+  for (const auto &current : mirrors_) {
+    if (current->required) {
+      resync_mirror(*current->backend, tmp_file_path);
+      continue;
+    }
+    try {
+      resync_mirror(*current->backend, tmp_file_path);
+    } catch (const std::exception &e) {
+      disable_mirror(*current, e.what());
+    }
+  }
+}
+
+[[nodiscard]] std::string
+mirrored_storage_backend::do_get_description() const {
+  std::string res{primary_->get_description()};
+  for (const auto &current : mirrors_) {
+    res += ", mirror: ";
+    res += current->backend->get_description();
+    res += " (queue size ";
+    res += std::to_string(current->worker->get_max_pending_tasks());
+    if (current->required) {
+      res += ", required";
+    }
+    if (current->disabled) {
+      res += ", disabled";
+    }
+    res += ')';
+  }
+  return res;
+}
+
+[[nodiscard]] std::string
+mirrored_storage_backend::do_get_object_uri(std::string_view name) const {
+  return primary_->get_object_uri(name);
+}
+
+[[nodiscard]] std::vector<std::string>
+mirrored_storage_backend::do_extract_warnings() {
+  // checked without locking, as this method is called after every received
+  // event
+  if (!has_warnings_) {
+    return {};
+  }
+  const std::lock_guard lock{warnings_mutex_};
+  has_warnings_ = false;
+  return std::exchange(warnings_, {});
+}
+
+void mirrored_storage_backend::resync_mirror(
+    basic_storage_backend &mirror_backend,
+    const std::filesystem::path &tmp_file_path) {
+  // e.g. the multipart uploads left unfinished in an S3 mirror are
+  // completed here, so that its objects are compared in their final state
+  mirror_backend.prepare_for_streaming();
+  const auto primary_objects{primary_->list_objects()};
+  auto mirror_objects{mirror_backend.list_objects()};
+
+  for (const auto &[name, size] : primary_objects) {
+    const auto mirror_it{mirror_objects.find(name)};
+    if (mirror_it != std::end(mirror_objects)) {
+      const auto mirror_size{mirror_it->second};
+      mirror_objects.erase(mirror_it);
+      if (mirror_size == size &&
+          (size > max_compared_object_size ||
+           primary_->get_object(name) == mirror_backend.get_object(name))) {
+        continue;
+      }
+    }
+    primary_->get_object_into_file(name, tmp_file_path);
+    mirror_backend.put_object_from_file(name, tmp_file_path);
+  }
+
+  // whatever is left has been removed from the primary (e.g. purged binlog
+  // files) while the mirror was not running
+  if (!mirror_objects.empty()) {
+    std::vector<std::string> victims;
+    victims.reserve(std::size(mirror_objects));
+    for (const auto &[name, size] : mirror_objects) {
+      victims.push_back(name);
+    }
+    mirror_backend.remove_objects(victims);
+  }
+}
+
+void mirrored_storage_backend::disable_mirror(
+    mirror &current, std::string_view reason) noexcept {
+  current.disabled = true;
+  // bugprone-empty-catch should not be that strict here, the mirror is
+  // disabled anyway
+  try {
+    std::string message{"storage mirror \""};
+    message += current.backend->get_description();
+    message += "\" disabled until the next start: ";
+    message += reason;
+    const std::lock_guard lock{warnings_mutex_};
+    warnings_.push_back(std::move(message));
+    has_warnings_ = true;
+  } catch (...) { // NOLINT(bugprone-empty-catch)
+  }
+}
+
+template <typename Task>
+void mirrored_storage_backend::submit_to_mirror(mirror &current, Task task) {
+  if (current.required) {
+    current.worker->submit(std::move(task));
+    return;
+  }
+  // a disabled mirror is no longer fed, it is brought up to date on the
+  // next start
+  if (current.disabled) {
+    return;
+  }
+  current.worker->submit([this, &current, task = std::move(task)] {
+    if (current.disabled) {
+      return;
+    }
+    try {
+      task();
+    } catch (const std::exception &e) {
+      disable_mirror(current, e.what());
+    }
+  });
+}
+
+template <typename Function>
+void mirrored_storage_backend::submit_to_mirrors(const Function &func) {
+  for (const auto &current : mirrors_) {
+    submit_to_mirror(*current,
+                     [&backend = *current->backend, func] { func(backend); });
+  }
+}
+
+} // namespace binsrv
@@ -0,0 +1,147 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#ifndef BINSRV_MIRRORED_STORAGE_BACKEND_HPP
+#define BINSRV_MIRRORED_STORAGE_BACKEND_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binsrv/basic_storage_backend.hpp" // IWYU pragma: export
+#include "binsrv/storage_config_fwd.hpp"
+
+#include "util/background_worker_fwd.hpp"
+
+namespace binsrv {
+
+// A storage backend that forwards every operation to the primary backend
+// (the one described by the main storage config) and replicates every
+// modification to a number of mirror backends. Each mirror has its own
+// background worker with a bounded queue, so the modifications are applied
+// to the primary and to all the mirrors concurrently and a slow mirror
+// delays the others only when its queue is full.
+// The primary backend is the only source of truth: objects are listed and
+// read from it only, and the durability guarantees of every operation
+// apply to the primary only. On construction, every mirror is brought up to
+// the state of the primary (objects that are missing or have a different
+// size / content are copied, objects unknown to the primary are removed).
+// An error in a mirror disables it until the next start (when it is brought
+// up to date again) and is reported via 'extract_warnings()', unless the
+// mirror is configured as a required one - in which case the error is
+// reported from the next operation performed on this backend.
+class [[nodiscard]] mirrored_storage_backend final
+    : public basic_storage_backend {
+public:
+  static constexpr std::size_t default_mirror_queue_size{64U};
+  // the maximum amount of stream data copied for the mirrors in a single
+  // task
+  static constexpr std::size_t max_shared_write_size{8388608U};
+  // objects of the same size in the primary and in a mirror are considered
+  // identical unless they are small enough to be compared (binlog files are
+  // append-only, while small metadata objects may be overwritten with
+  // content of the same size)
+  static constexpr std::uint64_t max_compared_object_size{1024ULL * 1024ULL};
+
+  mirrored_storage_backend(basic_storage_backend_ptr primary,
+                           const storage_config &config);
+  mirrored_storage_backend(const mirrored_storage_backend &) = delete;
+  mirrored_storage_backend &
+  operator=(const mirrored_storage_backend &) = delete;
+  mirrored_storage_backend(mirrored_storage_backend &&) = delete;
+  mirrored_storage_backend &operator=(mirrored_storage_backend &&) = delete;
+  ~mirrored_storage_backend() override;
+
+private:
+  using worker_ptr = std::unique_ptr<util::background_worker>;
+  struct mirror {
+    basic_storage_backend_ptr backend;
+    bool required{false};
+    // set on the first error in a mirror that is not required, no more
+    // operations are applied to it afterwards
+    std::atomic<bool> disabled{false};
+    // must be declared after the backend its tasks refer to
+    worker_ptr worker;
+  };
+  using mirror_ptr = std::unique_ptr<mirror>;
+  using mirror_container = std::vector<mirror_ptr>;
+
+  basic_storage_backend_ptr primary_;
+
+  // must be declared before 'mirrors_' as the mirror tasks refer to them
+  std::mutex warnings_mutex_{};
+  std::vector<std::string> warnings_{};
+  std::atomic<bool> has_warnings_{false};
+
+  mirror_container mirrors_;
+  std::filesystem::path tmp_file_directory_{};
+
+  // copies of the data passed to the methods below are shared by all the
+  // mirror tasks
+  using shared_content = std::shared_ptr<const std::string>;
+
+  [[nodiscard]] storage_object_name_container do_list_objects() override;
+
+  [[nodiscard]] std::string do_get_object(std::string_view name) override;
+  void do_put_object(std::string_view name,
+                     util::const_byte_span content) override;
+  void do_append_to_object(std::string_view name,
+                           util::const_byte_span content) override;
+  void do_put_object_from_file(
+      std::string_view name,
+      const std::filesystem::path &source_path) override;
+  void do_get_object_into_file(
+      std::string_view name,
+      const std::filesystem::path &destination_path) override;
+  void do_remove_object(std::string_view name) override;
+  void do_remove_objects(std::span<const std::string> names) override;
+  void do_fsync() override;
+
+  [[nodiscard]] std::uint64_t
+  do_open_stream(std::string_view name,
+                 storage_backend_open_stream_mode mode) override;
+  void do_write_data_to_stream(util::const_byte_span data) override;
+  void do_write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions) override;
+  void do_preallocate_stream(std::uint64_t size) override;
+  void do_sync_stream() override;
+  void do_close_stream() override;
+
+  void do_prepare_for_streaming() override;
+
+  [[nodiscard]] std::string do_get_description() const override;
+  [[nodiscard]] std::string
+  do_get_object_uri(std::string_view name) const override;
+  [[nodiscard]] std::vector<std::string> do_extract_warnings() override;
+
+  void resync_mirror(basic_storage_backend &mirror_backend,
+                     const std::filesystem::path &tmp_file_path);
+  void disable_mirror(mirror &current, std::string_view reason) noexcept;
+
+  template <typename Task> void submit_to_mirror(mirror &current, Task task);
+  template <typename Function> void submit_to_mirrors(const Function &func);
+};
+
+} // namespace binsrv
+
+#endif // BINSRV_MIRRORED_STORAGE_BACKEND_HPP
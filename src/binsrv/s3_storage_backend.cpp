@@ -15,6 +15,8 @@
 
 #include "binsrv/s3_storage_backend.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -23,13 +25,23 @@
 #include <functional>
 #include <ios>
 #include <istream>
+#include <iterator>
 #include <memory>
-#include <sstream>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <utility>
+#include <vector>
+
+#include <boost/scope/scope_exit.hpp>
+#include <boost/scope/scope_fail.hpp>
+
+#include <boost/lexical_cast.hpp>
 
 #include <boost/url/host_type.hpp>
 #include <boost/url/parse.hpp>
@@ -52,22 +64,50 @@
 #include <aws/s3-crt/ClientConfiguration.h>
 #include <aws/s3-crt/S3CrtClient.h>
 
+#include <aws/s3-crt/model/AbortMultipartUploadRequest.h>
 #include <aws/s3-crt/model/BucketLocationConstraint.h>
+#include <aws/s3-crt/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3-crt/model/CompleteMultipartUploadResult.h>
+#include <aws/s3-crt/model/CompletedMultipartUpload.h>
+#include <aws/s3-crt/model/CompletedPart.h>
+#include <aws/s3-crt/model/CreateMultipartUploadRequest.h>
+#include <aws/s3-crt/model/CreateMultipartUploadResult.h>
+#include <aws/s3-crt/model/Delete.h>
 #include <aws/s3-crt/model/DeleteObjectRequest.h>
+#include <aws/s3-crt/model/DeleteObjectsRequest.h>
+#include <aws/s3-crt/model/DeleteObjectsResult.h>
+#include <aws/s3-crt/model/Error.h>
 #include <aws/s3-crt/model/GetBucketLocationRequest.h>
 #include <aws/s3-crt/model/GetBucketLocationResult.h>
 #include <aws/s3-crt/model/GetObjectRequest.h>
 #include <aws/s3-crt/model/GetObjectResult.h>
+#include <aws/s3-crt/model/HeadObjectRequest.h>
+#include <aws/s3-crt/model/HeadObjectResult.h>
+#include <aws/s3-crt/model/ListMultipartUploadsRequest.h>
+#include <aws/s3-crt/model/ListMultipartUploadsResult.h>
 #include <aws/s3-crt/model/ListObjectsV2Request.h>
 #include <aws/s3-crt/model/ListObjectsV2Result.h>
+#include <aws/s3-crt/model/ListPartsRequest.h>
+#include <aws/s3-crt/model/ListPartsResult.h>
+#include <aws/s3-crt/model/MultipartUpload.h>
 #include <aws/s3-crt/model/Object.h>
+#include <aws/s3-crt/model/ObjectIdentifier.h>
+#include <aws/s3-crt/model/Part.h>
 #include <aws/s3-crt/model/PutObjectRequest.h>
+#include <aws/s3-crt/model/PutObjectResult.h>
+#include <aws/s3-crt/model/UploadPartCopyRequest.h>
+#include <aws/s3-crt/model/UploadPartCopyResult.h>
+#include <aws/s3-crt/model/UploadPartRequest.h>
+#include <aws/s3-crt/model/UploadPartResult.h>
 
 #include "binsrv/s3_error_helpers_private.hpp"
+#include "binsrv/s3_storage_config.hpp"
 #include "binsrv/storage_config.hpp"
 
+#include "util/background_worker.hpp"
 #include "util/byte_span.hpp"
 #include "util/exception_location_helpers.hpp"
+#include "util/write_ahead_journal.hpp"
 
 namespace {
 
@@ -88,6 +128,277 @@ private:
   Aws::SDKOptions options_;
 };
 
+// a read-only stream buffer over an externally owned memory region which
+// allows AWS SDK to read (and seek back and forth for checksum calculation
+// and retries) request bodies without materializing them into an
+// intermediate std::string / std::stringstream
+class const_byte_span_streambuf : public std::streambuf {
+public:
+  explicit const_byte_span_streambuf(util::const_byte_span content) {
+    // std::streambuf get area interface requires non-const pointers, however
+    // this class never modifies the underlying data as it does not override
+    // any output-related virtual functions
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    auto *const begin{const_cast<char *>(
+        std::data(util::as_string_view(content)))};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    setg(begin, begin, begin + std::size(content));
+  }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override {
+    if ((which & std::ios_base::in) == 0) {
+      return pos_type{off_type{-1}};
+    }
+    off_type base{};
+    if (dir == std::ios_base::cur) {
+      base = gptr() - eback();
+    } else if (dir == std::ios_base::end) {
+      base = egptr() - eback();
+    }
+    const auto position{base + off};
+    if (position < 0 || position > egptr() - eback()) {
+      return pos_type{off_type{-1}};
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    setg(eback(), eback() + position, egptr());
+    return pos_type{position};
+  }
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+    return seekoff(off_type{pos}, std::ios_base::beg, which);
+  }
+};
+
+class const_byte_span_iostream : public std::iostream {
+public:
+  explicit const_byte_span_iostream(util::const_byte_span content)
+      : std::iostream{nullptr}, buffer_{content} {
+    rdbuf(&buffer_);
+  }
+
+private:
+  const_byte_span_streambuf buffer_;
+};
+
+// a read-only stream buffer over a sequence of externally owned memory
+// regions, which allows AWS SDK to read request bodies scattered over several
+// buffers (e.g. a chunked event buffer followed by a memory-mapped spill
+// file) without gathering them into a contiguous copy first
+class const_byte_spans_streambuf : public std::streambuf {
+public:
+  explicit const_byte_spans_streambuf(
+      std::vector<util::const_byte_span> portions)
+      : portions_{std::move(portions)} {
+    portion_offsets_.reserve(std::size(portions_));
+    for (const auto portion : portions_) {
+      portion_offsets_.push_back(size_);
+      size_ += static_cast<off_type>(std::size(portion));
+    }
+  }
+
+protected:
+  int_type underflow() override {
+    reset_get_area();
+    if (read_position_ >= size_) {
+      return traits_type::eof();
+    }
+    // the last portion starting at or before the read position is the one
+    // containing it (empty portions are skipped this way as well)
+    const auto offset_it{
+        std::ranges::upper_bound(portion_offsets_, read_position_)};
+    const auto index{static_cast<std::size_t>(
+        std::distance(std::begin(portion_offsets_), offset_it) - 1)};
+    const auto portion{portions_[index]};
+    // std::streambuf get area interface requires non-const pointers, however
+    // this class never modifies the underlying data
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    auto *const begin{const_cast<char *>(
+        std::data(util::as_string_view(portion)))};
+    current_portion_offset_ = portion_offsets_[index];
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    setg(begin, begin + (read_position_ - current_portion_offset_),
+         begin + std::size(portion));
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return traits_type::to_int_type(*gptr());
+  }
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override {
+    if ((which & std::ios_base::in) == 0) {
+      return pos_type{off_type{-1}};
+    }
+    reset_get_area();
+    off_type base{};
+    if (dir == std::ios_base::cur) {
+      base = read_position_;
+    } else if (dir == std::ios_base::end) {
+      base = size_;
+    }
+    const auto position{base + off};
+    if (position < 0 || position > size_) {
+      return pos_type{off_type{-1}};
+    }
+    read_position_ = position;
+    return pos_type{position};
+  }
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+    return seekoff(off_type{pos}, std::ios_base::beg, which);
+  }
+
+private:
+  std::vector<util::const_byte_span> portions_;
+  std::vector<off_type> portion_offsets_{};
+  off_type size_{0};
+  off_type read_position_{0};
+  off_type current_portion_offset_{0};
+
+  void reset_get_area() noexcept {
+    if (eback() != nullptr) {
+      read_position_ = current_portion_offset_ + (gptr() - eback());
+      setg(nullptr, nullptr, nullptr);
+    }
+  }
+};
+
+class const_byte_spans_iostream : public std::iostream {
+public:
+  explicit const_byte_spans_iostream(
+      std::vector<util::const_byte_span> portions)
+      : std::iostream{nullptr}, buffer_{std::move(portions)} {
+    rdbuf(&buffer_);
+  }
+
+private:
+  const_byte_spans_streambuf buffer_;
+};
+
+// returns the spans covering the [offset, offset + size) range of the
+// concatenation of 'portions'
+[[nodiscard]] std::vector<util::const_byte_span>
+slice_portions(std::span<const util::const_byte_span> portions,
+               std::uint64_t offset, std::uint64_t size) {
+  std::vector<util::const_byte_span> result;
+  for (const auto portion : portions) {
+    if (size == 0ULL) {
+      break;
+    }
+    const std::uint64_t portion_size{std::size(portion)};
+    if (offset >= portion_size) {
+      offset -= portion_size;
+      continue;
+    }
+    const auto sliced_size{std::min(portion_size - offset, size)};
+    result.push_back(portion.subspan(offset, sliced_size));
+    offset = 0ULL;
+    size -= sliced_size;
+  }
+  return result;
+}
+
+// a stream buffer that appends everything written to it directly to an
+// externally owned std::string, which allows AWS SDK to store response bodies
+// in their final destination instead of an intermediate std::stringstream;
+// reading (and seeking within) the already written data is also supported
+class string_sink_streambuf : public std::streambuf {
+public:
+  explicit string_sink_streambuf(std::string &target) : target_{&target} {}
+
+protected:
+  std::streamsize xsputn(const char_type *data,
+                         std::streamsize size) override {
+    // the get area may be invalidated by the reallocation of the target
+    reset_get_area();
+    target_->append(data, static_cast<std::size_t>(size));
+    return size;
+  }
+  int_type overflow(int_type character) override {
+    if (!traits_type::eq_int_type(character, traits_type::eof())) {
+      reset_get_area();
+      target_->push_back(traits_type::to_char_type(character));
+    }
+    return traits_type::not_eof(character);
+  }
+
+  int_type underflow() override {
+    reset_get_area();
+    auto *const begin{std::data(*target_)};
+    const auto size{static_cast<off_type>(std::size(*target_))};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    setg(begin, begin + read_position_, begin + size);
+    return read_position_ < size ? traits_type::to_int_type(*gptr())
+                                 : traits_type::eof();
+  }
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override {
+    const auto size{static_cast<off_type>(std::size(*target_))};
+    if ((which & std::ios_base::in) == 0) {
+      // the put position is always at the end of the target
+      return dir != std::ios_base::beg && off == 0 ? pos_type{size}
+                                                   : pos_type{off_type{-1}};
+    }
+    reset_get_area();
+    off_type base{};
+    if (dir == std::ios_base::cur) {
+      base = read_position_;
+    } else if (dir == std::ios_base::end) {
+      base = size;
+    }
+    const auto position{base + off};
+    if (position < 0 || position > size) {
+      return pos_type{off_type{-1}};
+    }
+    read_position_ = position;
+    return pos_type{position};
+  }
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+    return seekoff(off_type{pos}, std::ios_base::beg, which);
+  }
+
+private:
+  std::string *target_;
+  off_type read_position_{0};
+
+  void reset_get_area() noexcept {
+    if (eback() != nullptr) {
+      read_position_ = gptr() - eback();
+      setg(nullptr, nullptr, nullptr);
+    }
+  }
+};
+
+class string_sink_iostream : public std::iostream {
+public:
+  explicit string_sink_iostream(std::string &target)
+      : std::iostream{nullptr}, buffer_{target} {
+    rdbuf(&buffer_);
+  }
+
+private:
+  string_sink_streambuf buffer_;
+};
+
+// splits the [0, total_size) range into the minimal number of almost equal
+// parts satisfying S3 multipart upload part size limits and calls
+// 'handler(offset, size)' for each one of them
+template <typename Handler>
+void for_each_multipart_range(std::uint64_t total_size, Handler &&handler) {
+  static constexpr auto max_part_size{
+      binsrv::s3_storage_backend::max_multipart_part_size};
+  const auto number_of_parts{
+      std::max<std::uint64_t>(1ULL, (total_size + max_part_size - 1ULL) /
+                                        max_part_size)};
+  const auto part_size{total_size / number_of_parts};
+  const auto remainder{total_size % number_of_parts};
+  std::uint64_t offset{0ULL};
+  for (std::uint64_t index{0ULL}; index < number_of_parts; ++index) {
+    const auto current_part_size{part_size + (index < remainder ? 1ULL : 0ULL)};
+    handler(offset, current_part_size);
+    offset += current_part_size;
+  }
+}
+
 } // namespace
 
 namespace binsrv {
@@ -114,6 +425,18 @@ struct qualified_object_path {
   std::filesystem::path object_path;
 };
 
+struct object_attributes {
+  std::uint64_t size;
+  std::string etag;
+};
+
+struct pending_multipart_upload {
+  std::string name;
+  std::string upload_id;
+};
+using pending_multipart_upload_container =
+    std::vector<pending_multipart_upload>;
+
 class s3_storage_backend::aws_context : private aws_context_base {
 public:
   struct bucket_tag {};
@@ -125,10 +448,13 @@ public:
   using stream_handler_type = std::function<void(std::size_t, std::iostream &)>;
 
   aws_context(bucket_tag tag, const simple_aws_credentials &credentials,
+              const optional_s3_storage_config &tuning,
               const std::string &bucket);
   aws_context(region_tag tag, const simple_aws_credentials &credentials,
+              const optional_s3_storage_config &tuning,
               const std::string &region);
   aws_context(endpoint_tag tag, const simple_aws_credentials &credentials,
+              const optional_s3_storage_config &tuning,
               const std::string &endpoint, bool secure_protocol);
 
   aws_context(const aws_context &) = delete;
@@ -158,23 +484,92 @@ public:
     return Aws::Http::SchemeMapper::ToString(configuration_.scheme);
   }
 
+  [[nodiscard]] double get_throughput_target_gbps() const noexcept {
+    return configuration_.throughputTargetGbps;
+  }
+  [[nodiscard]] std::uint64_t get_part_size() const noexcept {
+    return configuration_.partSize;
+  }
+  [[nodiscard]] std::uint32_t get_max_connections() const noexcept {
+    return static_cast<std::uint32_t>(configuration_.maxConnections);
+  }
+  [[nodiscard]] std::uint64_t get_memory_limit() const noexcept {
+    return configuration_.memoryLimitBytes;
+  }
+
   [[nodiscard]] std::string get_bucket_region(const std::string &bucket) const;
 
+  [[nodiscard]] object_attributes
+  get_object_attributes(const qualified_object_path &source) const;
+
   [[nodiscard]] std::string
-  get_object_into_string(const qualified_object_path &source) const;
+  get_object_into_string(const qualified_object_path &source,
+                         std::size_t max_content_length) const;
 
-  void
+  // returns the ETag of the downloaded object
+  std::string
   get_object_into_file(const qualified_object_path &source,
                        const std::filesystem::path &content_file_path) const;
 
-  void put_object_from_stream(const qualified_object_path &dest,
-                              std::iostream &content_stream) const;
+  // returns the ETag of the newly created object
+  std::string put_object_from_stream(const qualified_object_path &dest,
+                                     std::iostream &content_stream) const;
 
   void put_object_from_span(const qualified_object_path &dest,
                             util::const_byte_span content) const;
 
+  // multipart upload primitives: part numbers are 1-based, uploading a part
+  // with the number of an already uploaded one replaces the latter; the ETags
+  // of the uploaded parts are returned to the caller, which passes them to
+  // 'complete_multipart_upload()' in the order of their part numbers
+  [[nodiscard]] std::string
+  create_multipart_upload(const qualified_object_path &dest) const;
+  [[nodiscard]] std::string
+  upload_part_copy(const qualified_object_path &dest,
+                   const std::string &upload_id, std::size_t part_number,
+                   const std::string &copy_source_etag, std::uint64_t offset,
+                   std::uint64_t size) const;
+  // 'content_length' bytes are read from the beginning of 'content_stream'
+  [[nodiscard]] std::string
+  upload_part_from_stream(const qualified_object_path &dest,
+                          const std::string &upload_id,
+                          std::size_t part_number,
+                          std::iostream &content_stream,
+                          std::uint64_t content_length) const;
+  [[nodiscard]] std::string
+  upload_part_from_portions(const qualified_object_path &dest,
+                            const std::string &upload_id,
+                            std::size_t part_number,
+                            std::vector<util::const_byte_span> portions) const;
+  // returns the ETag of the newly created object
+  std::string
+  complete_multipart_upload(const qualified_object_path &dest,
+                            const std::string &upload_id,
+                            std::span<const std::string> part_etags) const;
+  void abort_multipart_upload(const qualified_object_path &dest,
+                              const std::string &upload_id) const noexcept;
+
+  // returns the multipart uploads initiated (and neither completed nor
+  // aborted) for the objects within 'prefix', the uploads of the same object
+  // are returned in the order of their initiation
+  [[nodiscard]] pending_multipart_upload_container
+  list_multipart_uploads(const qualified_object_path &prefix) const;
+  // returns the ETags of all the parts uploaded so far in the order of their
+  // part numbers (which must form a contiguous sequence starting from 1)
+  [[nodiscard]] std::vector<std::string>
+  list_part_etags(const qualified_object_path &dest,
+                  const std::string &upload_id) const;
+
   void delete_object(const qualified_object_path &target) const;
 
+  // deletes objects in batches of 'max_keys_per_delete_request' keys sending
+  // up to 'max_concurrent_delete_requests' requests simultaneously; all
+  // batches are always attempted, after which either the first request
+  // failure or an aggregated report of all per-key failures is raised
+  void
+  delete_objects(const std::string &bucket,
+                 std::span<const std::filesystem::path> object_paths) const;
+
   [[nodiscard]] storage_object_name_container
   list_objects(const qualified_object_path &prefix);
 
@@ -186,14 +581,17 @@ private:
   using s3_crt_client_ptr = std::unique_ptr<Aws::S3Crt::S3CrtClient>;
   s3_crt_client_ptr client_;
 
-  explicit aws_context(const simple_aws_credentials &credentials)
-      : aws_context_base{}, credentials_{credentials.get_access_key_id(),
-                                         credentials.get_secret_access_key()},
-        configuration_{} {}
+  aws_context(const simple_aws_credentials &credentials,
+              const optional_s3_storage_config &tuning);
+
+  // returns the ETag of the downloaded object
+  std::string
+  get_object_internal(const qualified_object_path &source,
+                      const stream_factory_type &stream_factory,
+                      const stream_handler_type &stream_handler) const;
 
-  void get_object_internal(const qualified_object_path &source,
-                           const stream_factory_type &stream_factory,
-                           const stream_handler_type &stream_handler) const;
+  [[nodiscard]] static std::string
+  make_prefix_string(const qualified_object_path &prefix);
 
   using list_object_container = Aws::Vector<Aws::S3Crt::Model::Object>;
   static void
@@ -202,10 +600,39 @@ private:
                                 storage_object_name_container &storage_objects);
 };
 
+s3_storage_backend::aws_context::aws_context(
+    const simple_aws_credentials &credentials,
+    const optional_s3_storage_config &tuning)
+    : aws_context_base{}, credentials_{credentials.get_access_key_id(),
+                                       credentials.get_secret_access_key()},
+      configuration_{} {
+  if (!tuning.has_value()) {
+    return;
+  }
+  // parameters that are not specified in the config keep AWS SDK defaults
+  const auto &optional_throughput_target_gbps{
+      tuning->get<"throughput_target_gbps">()};
+  if (optional_throughput_target_gbps.has_value()) {
+    configuration_.throughputTargetGbps = *optional_throughput_target_gbps;
+  }
+  const auto &optional_part_size{tuning->get<"part_size">()};
+  if (optional_part_size.has_value()) {
+    configuration_.partSize = optional_part_size->get_value();
+  }
+  const auto &optional_max_connections{tuning->get<"max_connections">()};
+  if (optional_max_connections.has_value()) {
+    configuration_.maxConnections = *optional_max_connections;
+  }
+  const auto &optional_memory_limit{tuning->get<"memory_limit">()};
+  if (optional_memory_limit.has_value()) {
+    configuration_.memoryLimitBytes = optional_memory_limit->get_value();
+  }
+}
+
 s3_storage_backend::aws_context::aws_context(
     bucket_tag /*tag*/, const simple_aws_credentials &credentials,
-    const std::string &bucket)
-    : aws_context{credentials} {
+    const optional_s3_storage_config &tuning, const std::string &bucket)
+    : aws_context{credentials, tuning} {
   // if the construction_alternative is 'bucket', leave the 'region' field in
   // the configuration class in its default state ("us-east-1") and try to
   // detect AWS S3 region from the bucket location
@@ -222,8 +649,8 @@ s3_storage_backend::aws_context::aws_context(
 
 s3_storage_backend::aws_context::aws_context(
     region_tag /*tag*/, const simple_aws_credentials &credentials,
-    const std::string &region)
-    : aws_context{credentials} {
+    const optional_s3_storage_config &tuning, const std::string &region)
+    : aws_context{credentials, tuning} {
   // if the provided construction_alternative is 'region', initialize S3 client
   // with the provided region parameter
   configuration_.region = region;
@@ -233,8 +660,9 @@ s3_storage_backend::aws_context::aws_context(
 
 s3_storage_backend::aws_context::aws_context(
     endpoint_tag /*tag*/, const simple_aws_credentials &credentials,
-    const std::string &endpoint, bool secure_protocol)
-    : aws_context{credentials} {
+    const optional_s3_storage_config &tuning, const std::string &endpoint,
+    bool secure_protocol)
+    : aws_context{credentials, tuning} {
   // if the provided construction_alternative is 'endpoint', initialize S3
   // client with the provided endpoint parameter
 
@@ -266,34 +694,58 @@ s3_storage_backend::aws_context::aws_context(
       GetNameForBucketLocationConstraint(model_region);
 }
 
+[[nodiscard]] object_attributes
+s3_storage_backend::aws_context::get_object_attributes(
+    const qualified_object_path &source) const {
+  Aws::S3Crt::Model::HeadObjectRequest head_object_request;
+  head_object_request.SetBucket(source.bucket);
+  head_object_request.SetKey(source.object_path.generic_string());
+
+  const auto head_object_outcome{client_->HeadObject(head_object_request)};
+  if (!head_object_outcome.IsSuccess()) {
+    raise_s3_error_from_outcome("cannot get S3 object attributes",
+                                head_object_outcome.GetError());
+  }
+  const auto &head_object_result{head_object_outcome.GetResult()};
+
+  const auto model_content_length{head_object_result.GetContentLength()};
+  if (!std::in_range<std::uint64_t>(model_content_length)) {
+    util::exception_location().raise<std::logic_error>(
+        "invalid S3 object content length");
+  }
+  return {.size = static_cast<std::uint64_t>(model_content_length),
+          .etag = head_object_result.GetETag()};
+}
+
 [[nodiscard]] std::string
 s3_storage_backend::aws_context::get_object_into_string(
-    const qualified_object_path &source) const {
+    const qualified_object_path &source, std::size_t max_content_length) const {
   std::string content;
-  auto stream_handler{[&content](std::size_t content_length,
-                                 std::iostream &content_stream) {
+  // the response body is written by AWS SDK directly into 'content'
+  auto stream_factory{[&content]() -> std::iostream * {
+    return Aws::New<string_sink_iostream>("GetObjectStreamFactoryAllocationTag",
+                                          content);
+  }};
+  auto stream_handler{[&content, max_content_length](
+                          std::size_t content_length,
+                          std::iostream & /*content_stream*/) {
     // TODO: check object length in advance before calling GetObject
     //       (with HeadObject, for instance)
-    if (content_length > max_memory_object_size) {
+    if (content_length > max_content_length) {
       util::exception_location().raise<std::out_of_range>(
           "S3 object is too large to be loaded in memory");
     }
-
-    content.resize(content_length);
-    if (!content_stream.read(std::data(content),
-                             static_cast<std::streamsize>(content_length))) {
+    if (std::size(content) != content_length) {
       util::exception_location().raise<std::runtime_error>(
           "cannot read S3 object content into a string");
     }
-    assert(content_stream.gcount() ==
-           static_cast<std::streamsize>(content_length));
   }};
-  get_object_internal(source, {}, stream_handler);
+  get_object_internal(source, stream_factory, stream_handler);
 
   return content;
 }
 
-void s3_storage_backend::aws_context::get_object_into_file(
+std::string s3_storage_backend::aws_context::get_object_into_file(
     const qualified_object_path &source,
     const std::filesystem::path &content_file_path) const {
   auto stream_factory{[&content_file_path]() -> std::iostream * {
@@ -317,12 +769,13 @@ void s3_storage_backend::aws_context::get_object_into_file(
         response_content_length = content_length;
       }};
 
-  get_object_internal(source, stream_factory, stream_handler);
+  auto etag{get_object_internal(source, stream_factory, stream_handler)};
   assert(std::filesystem::file_size(content_file_path) ==
          response_content_length);
+  return etag;
 }
 
-void s3_storage_backend::aws_context::put_object_from_stream(
+std::string s3_storage_backend::aws_context::put_object_from_stream(
     const qualified_object_path &dest, std::iostream &content_stream) const {
   Aws::S3Crt::Model::PutObjectRequest put_object_request;
   put_object_request.SetBucket(dest.bucket);
@@ -339,19 +792,16 @@ void s3_storage_backend::aws_context::put_object_from_stream(
     raise_s3_error_from_outcome("cannot put object into S3 bucket",
                                 put_object_outcome.GetError());
   }
+  return put_object_outcome.GetResult().GetETag();
 }
 
 void s3_storage_backend::aws_context::put_object_from_span(
     const qualified_object_path &dest, util::const_byte_span content) const {
-  std::string materialized_content{util::as_string_view(content)};
-  std::stringstream content_stream{std::move(materialized_content),
-                                   std::ios_base::in | std::ios_base::out |
-                                       std::ios_base::binary};
+  // AWS SDK reads the request body directly from the caller's memory
+  const_byte_span_iostream content_stream{content};
   put_object_from_stream(dest, content_stream);
 }
 
-// TODO: Consider deleting several objects in one request by using
-// `DeleteObjects()` AWS SDK C++ API call
 void s3_storage_backend::aws_context::delete_object(
     const qualified_object_path &target) const {
   Aws::S3Crt::Model::DeleteObjectRequest delete_object_request;
@@ -367,6 +817,94 @@ void s3_storage_backend::aws_context::delete_object(
   }
 }
 
+void s3_storage_backend::aws_context::delete_objects(
+    const std::string &bucket,
+    std::span<const std::filesystem::path> object_paths) const {
+  std::optional<Aws::S3Crt::S3CrtError> first_request_error{};
+  std::size_t number_of_failed_keys{0U};
+  std::string failed_keys_report{};
+  static constexpr std::size_t max_reported_failed_keys{16U};
+
+  const auto process_outcome{[&](const auto &delete_objects_outcome) {
+    if (!delete_objects_outcome.IsSuccess()) {
+      if (!first_request_error.has_value()) {
+        first_request_error.emplace(delete_objects_outcome.GetError());
+      }
+      return;
+    }
+    // in quiet mode the response contains only the keys that could not be
+    // deleted
+    const auto &key_errors{delete_objects_outcome.GetResult().GetErrors()};
+    for (const auto &key_error : key_errors) {
+      if (number_of_failed_keys < max_reported_failed_keys) {
+        failed_keys_report += (number_of_failed_keys == 0U ? "" : ", ");
+        failed_keys_report += key_error.GetKey();
+        failed_keys_report += " <";
+        failed_keys_report += key_error.GetCode();
+        failed_keys_report += "> - ";
+        failed_keys_report += key_error.GetMessage();
+      }
+      ++number_of_failed_keys;
+    }
+  }};
+
+  using outcome_callable_container =
+      std::vector<Aws::S3Crt::Model::DeleteObjectsOutcomeCallable>;
+  outcome_callable_container pending_requests;
+  pending_requests.reserve(max_concurrent_delete_requests);
+  const auto wait_for_pending_requests{[&]() {
+    for (auto &pending_request : pending_requests) {
+      process_outcome(pending_request.get());
+    }
+    pending_requests.clear();
+  }};
+
+  auto remaining_paths{object_paths};
+  while (!remaining_paths.empty()) {
+    const auto batch_size{
+        std::min(std::size(remaining_paths), max_keys_per_delete_request)};
+    Aws::Vector<Aws::S3Crt::Model::ObjectIdentifier> object_identifiers;
+    object_identifiers.reserve(batch_size);
+    for (const auto &object_path : remaining_paths.first(batch_size)) {
+      // unlike the keys in the request URIs, the keys in the request body
+      // are not normalized by the SDK and must not start with "/"
+      object_identifiers.emplace_back().SetKey(
+          object_path.relative_path().generic_string());
+    }
+    remaining_paths = remaining_paths.subspan(batch_size);
+
+    Aws::S3Crt::Model::Delete delete_model;
+    delete_model.SetObjects(std::move(object_identifiers));
+    delete_model.SetQuiet(true);
+
+    Aws::S3Crt::Model::DeleteObjectsRequest delete_objects_request;
+    delete_objects_request.SetBucket(bucket);
+    delete_objects_request.SetDelete(std::move(delete_model));
+
+    if (std::size(pending_requests) == max_concurrent_delete_requests) {
+      wait_for_pending_requests();
+    }
+    pending_requests.push_back(
+        client_->DeleteObjectsCallable(delete_objects_request));
+  }
+  wait_for_pending_requests();
+
+  if (first_request_error.has_value()) {
+    raise_s3_error_from_outcome("cannot delete objects from S3 bucket",
+                                *first_request_error);
+  }
+  if (number_of_failed_keys != 0U) {
+    std::string message{"cannot delete "};
+    message += std::to_string(number_of_failed_keys);
+    message += " object(s) from S3 bucket: ";
+    message += failed_keys_report;
+    if (number_of_failed_keys > max_reported_failed_keys) {
+      message += ", ...";
+    }
+    util::exception_location().raise<std::runtime_error>(message);
+  }
+}
+
 [[nodiscard]] storage_object_name_container
 s3_storage_backend::aws_context::list_objects(
     const qualified_object_path &prefix) {
@@ -375,26 +913,7 @@ s3_storage_backend::aws_context::list_objects(
   Aws::S3Crt::Model::ListObjectsV2Request list_objects_request;
   list_objects_request.SetBucket(prefix.bucket);
 
-  // for the list operation request the prefix must not start with "/""
-
-  // moreover, in order to exclude false positives in situations when
-  // both "/foo" and "/foobar" directories are present and we need to list
-  // the content of the "/foo" directory, the prefix should include a
-  // trailing slash "foo/"
-
-  // for the "/" prefix path we should set the prefix to an empty string /
-  // not set the prefix at all
-
-  // relative path of a default-constructed object / "" / "/" is an empty
-  // path
-  auto prefix_path{prefix.object_path.relative_path()};
-
-  // appending an empty path to an existing path will just add a trailing
-  // separator, e.g. "foo" -> "foo/" (for en empty path this operation has
-  // no effect)
-  prefix_path /= std::filesystem::path{};
-
-  const auto prefix_str{prefix_path.generic_string()};
+  const auto prefix_str{make_prefix_string(prefix)};
 
   if (!prefix_str.empty()) {
     list_objects_request.SetPrefix(prefix_str);
@@ -445,7 +964,7 @@ s3_storage_backend::aws_context::list_objects(
   return result;
 }
 
-void s3_storage_backend::aws_context::get_object_internal(
+std::string s3_storage_backend::aws_context::get_object_internal(
     const qualified_object_path &source,
     const stream_factory_type &stream_factory,
     const stream_handler_type &stream_handler) const {
@@ -476,6 +995,250 @@ void s3_storage_backend::aws_context::get_object_internal(
   if (stream_handler) {
     stream_handler(content_length, content_stream);
   }
+  return get_object_result.GetETag();
+}
+
+[[nodiscard]] std::string
+s3_storage_backend::aws_context::create_multipart_upload(
+    const qualified_object_path &dest) const {
+  Aws::S3Crt::Model::CreateMultipartUploadRequest create_request;
+  create_request.SetBucket(dest.bucket);
+  create_request.SetKey(dest.object_path.generic_string());
+
+  const auto create_outcome{client_->CreateMultipartUpload(create_request)};
+  if (!create_outcome.IsSuccess()) {
+    raise_s3_error_from_outcome("cannot create S3 multipart upload",
+                                create_outcome.GetError());
+  }
+  return create_outcome.GetResult().GetUploadId();
+}
+
+[[nodiscard]] std::string s3_storage_backend::aws_context::upload_part_copy(
+    const qualified_object_path &dest, const std::string &upload_id,
+    std::size_t part_number, const std::string &copy_source_etag,
+    std::uint64_t offset, std::uint64_t size) const {
+  assert(size != 0ULL);
+  assert(part_number != 0U && part_number <= max_multipart_parts);
+
+  // copy source must not include the leading slash of the object path
+  std::string copy_source{dest.bucket};
+  copy_source += '/';
+  copy_source += dest.object_path.relative_path().generic_string();
+
+  Aws::S3Crt::Model::UploadPartCopyRequest upload_part_copy_request;
+  upload_part_copy_request.SetBucket(dest.bucket);
+  upload_part_copy_request.SetKey(dest.object_path.generic_string());
+  upload_part_copy_request.SetUploadId(upload_id);
+  upload_part_copy_request.SetPartNumber(static_cast<int>(part_number));
+  upload_part_copy_request.SetCopySource(copy_source);
+  // guard against the source object being modified behind our back
+  if (!copy_source_etag.empty()) {
+    upload_part_copy_request.SetCopySourceIfMatch(copy_source_etag);
+  }
+  std::string copy_source_range{"bytes="};
+  copy_source_range += std::to_string(offset);
+  copy_source_range += '-';
+  copy_source_range += std::to_string(offset + size - 1ULL);
+  upload_part_copy_request.SetCopySourceRange(copy_source_range);
+
+  const auto upload_part_copy_outcome{
+      client_->UploadPartCopy(upload_part_copy_request)};
+  if (!upload_part_copy_outcome.IsSuccess()) {
+    raise_s3_error_from_outcome("cannot copy S3 object part",
+                                upload_part_copy_outcome.GetError());
+  }
+  return upload_part_copy_outcome.GetResult().GetCopyPartResult().GetETag();
+}
+
+[[nodiscard]] std::string
+s3_storage_backend::aws_context::upload_part_from_stream(
+    const qualified_object_path &dest, const std::string &upload_id,
+    std::size_t part_number, std::iostream &content_stream,
+    std::uint64_t content_length) const {
+  assert(part_number != 0U && part_number <= max_multipart_parts);
+  if (!content_stream.seekg(0)) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot rewind S3 object part content stream");
+  }
+
+  Aws::S3Crt::Model::UploadPartRequest upload_part_request;
+  upload_part_request.SetBucket(dest.bucket);
+  upload_part_request.SetKey(dest.object_path.generic_string());
+  upload_part_request.SetUploadId(upload_id);
+  upload_part_request.SetPartNumber(static_cast<int>(part_number));
+  upload_part_request.SetContentLength(
+      static_cast<long long>(content_length));
+
+  // making an shared pointer with noop deleter using aliasing constructor
+  const iostream_ptr wrapped_content_stream{iostream_ptr{}, &content_stream};
+  upload_part_request.SetBody(wrapped_content_stream);
+
+  const auto upload_part_outcome{client_->UploadPart(upload_part_request)};
+  if (!upload_part_outcome.IsSuccess()) {
+    raise_s3_error_from_outcome("cannot upload S3 object part",
+                                upload_part_outcome.GetError());
+  }
+  return upload_part_outcome.GetResult().GetETag();
+}
+
+[[nodiscard]] std::string
+s3_storage_backend::aws_context::upload_part_from_portions(
+    const qualified_object_path &dest, const std::string &upload_id,
+    std::size_t part_number,
+    std::vector<util::const_byte_span> portions) const {
+  std::uint64_t content_length{0ULL};
+  for (const auto portion : portions) {
+    content_length += std::size(portion);
+  }
+  const_byte_spans_iostream content_stream{std::move(portions)};
+  return upload_part_from_stream(dest, upload_id, part_number, content_stream,
+                                 content_length);
+}
+
+std::string s3_storage_backend::aws_context::complete_multipart_upload(
+    const qualified_object_path &dest, const std::string &upload_id,
+    std::span<const std::string> part_etags) const {
+  Aws::Vector<Aws::S3Crt::Model::CompletedPart> parts;
+  parts.reserve(std::size(part_etags));
+  for (const auto &part_etag : part_etags) {
+    auto &completed_part{parts.emplace_back()};
+    completed_part.SetPartNumber(static_cast<int>(std::size(parts)));
+    completed_part.SetETag(part_etag);
+  }
+  Aws::S3Crt::Model::CompletedMultipartUpload completed_upload;
+  completed_upload.SetParts(std::move(parts));
+
+  Aws::S3Crt::Model::CompleteMultipartUploadRequest complete_request;
+  complete_request.SetBucket(dest.bucket);
+  complete_request.SetKey(dest.object_path.generic_string());
+  complete_request.SetUploadId(upload_id);
+  complete_request.SetMultipartUpload(std::move(completed_upload));
+
+  const auto complete_outcome{
+      client_->CompleteMultipartUpload(complete_request)};
+  if (!complete_outcome.IsSuccess()) {
+    raise_s3_error_from_outcome("cannot complete S3 multipart upload",
+                                complete_outcome.GetError());
+  }
+  return complete_outcome.GetResult().GetETag();
+}
+
+void s3_storage_backend::aws_context::abort_multipart_upload(
+    const qualified_object_path &dest,
+    const std::string &upload_id) const noexcept {
+  Aws::S3Crt::Model::AbortMultipartUploadRequest abort_request;
+  abort_request.SetBucket(dest.bucket);
+  abort_request.SetKey(dest.object_path.generic_string());
+  abort_request.SetUploadId(upload_id);
+
+  // errors are intentionally ignored here - worst case scenario we will
+  // have an incomplete multipart upload that can be cleaned up by a bucket
+  // lifecycle rule
+  static_cast<void>(client_->AbortMultipartUpload(abort_request));
+}
+
+[[nodiscard]] pending_multipart_upload_container
+s3_storage_backend::aws_context::list_multipart_uploads(
+    const qualified_object_path &prefix) const {
+  pending_multipart_upload_container result;
+
+  Aws::S3Crt::Model::ListMultipartUploadsRequest list_uploads_request;
+  list_uploads_request.SetBucket(prefix.bucket);
+  const auto prefix_str{make_prefix_string(prefix)};
+  if (!prefix_str.empty()) {
+    list_uploads_request.SetPrefix(prefix_str);
+  }
+
+  bool has_more{true};
+  while (has_more) {
+    const auto list_uploads_outcome{
+        client_->ListMultipartUploads(list_uploads_request)};
+    if (!list_uploads_outcome.IsSuccess()) {
+      raise_s3_error_from_outcome(
+          "cannot list multipart uploads in the specified bucket",
+          list_uploads_outcome.GetError());
+    }
+    const auto &list_uploads_result{list_uploads_outcome.GetResult()};
+    for (const auto &upload : list_uploads_result.GetUploads()) {
+      std::string_view key{upload.GetKey()};
+      if (!key.starts_with(prefix_str)) {
+        util::exception_location().raise<std::logic_error>(
+            "encountered a multipart upload with unexpected prefix");
+      }
+      key.remove_prefix(std::size(prefix_str));
+      result.push_back(
+          {.name = std::string{key}, .upload_id = upload.GetUploadId()});
+    }
+
+    has_more = list_uploads_result.GetIsTruncated();
+    if (has_more) {
+      list_uploads_request.SetKeyMarker(list_uploads_result.GetNextKeyMarker());
+      list_uploads_request.SetUploadIdMarker(
+          list_uploads_result.GetNextUploadIdMarker());
+    }
+  }
+
+  return result;
+}
+
+[[nodiscard]] std::vector<std::string>
+s3_storage_backend::aws_context::list_part_etags(
+    const qualified_object_path &dest, const std::string &upload_id) const {
+  std::vector<std::string> result;
+
+  Aws::S3Crt::Model::ListPartsRequest list_parts_request;
+  list_parts_request.SetBucket(dest.bucket);
+  list_parts_request.SetKey(dest.object_path.generic_string());
+  list_parts_request.SetUploadId(upload_id);
+
+  bool has_more{true};
+  while (has_more) {
+    const auto list_parts_outcome{client_->ListParts(list_parts_request)};
+    if (!list_parts_outcome.IsSuccess()) {
+      raise_s3_error_from_outcome("cannot list S3 multipart upload parts",
+                                  list_parts_outcome.GetError());
+    }
+    const auto &list_parts_result{list_parts_outcome.GetResult()};
+    for (const auto &part : list_parts_result.GetParts()) {
+      if (part.GetPartNumber() != static_cast<int>(std::size(result)) + 1) {
+        util::exception_location().raise<std::logic_error>(
+            "S3 multipart upload parts are not numbered contiguously");
+      }
+      result.push_back(part.GetETag());
+    }
+
+    has_more = list_parts_result.GetIsTruncated();
+    if (has_more) {
+      list_parts_request.SetPartNumberMarker(
+          list_parts_result.GetNextPartNumberMarker());
+    }
+  }
+
+  return result;
+}
+
+[[nodiscard]] std::string s3_storage_backend::aws_context::make_prefix_string(
+    const qualified_object_path &prefix) {
+  // for the list operation request the prefix must not start with "/""
+
+  // moreover, in order to exclude false positives in situations when
+  // both "/foo" and "/foobar" directories are present and we need to list
+  // the content of the "/foo" directory, the prefix should include a
+  // trailing slash "foo/"
+
+  // for the "/" prefix path we should set the prefix to an empty string /
+  // not set the prefix at all
+
+  // relative path of a default-constructed object / "" / "/" is an empty
+  // path
+  auto prefix_path{prefix.object_path.relative_path()};
+
+  // appending an empty path to an existing path will just add a trailing
+  // separator, e.g. "foo" -> "foo/" (for en empty path this operation has
+  // no effect)
+  prefix_path /= std::filesystem::path{};
+
+  return prefix_path.generic_string();
 }
 
 void s3_storage_backend::aws_context::process_list_objects_internal(
@@ -503,7 +1266,8 @@ void s3_storage_backend::aws_context::process_list_objects_internal(
 
 s3_storage_backend::s3_storage_backend(const storage_config &config)
     : bucket_{}, root_path_{}, current_name_{}, uuid_generator_{},
-      tmp_file_directory_{}, current_tmp_file_path_{}, tmp_fstream_{}, impl_{} {
+      tmp_file_directory_{}, staging_buffer_{}, current_tmp_file_path_{},
+      tmp_fstream_{}, impl_{} {
   // TODO: take into account S3 limits (like 5GB single file upload)
 
   const auto &opt_fs_buffer_directory{config.get<"fs_buffer_directory">()};
@@ -571,7 +1335,7 @@ s3_storage_backend::s3_storage_backend(const storage_config &config)
   switch (uri.scheme_id()) {
   case boost::urls::scheme::http:
   case boost::urls::scheme::https:
-    init_with_endpoint(uri);
+    init_with_endpoint(uri, config.get<"s3">());
     break;
   case boost::urls::scheme::unknown:
     if (uri.scheme() != original_uri_schema) {
@@ -579,19 +1343,43 @@ s3_storage_backend::s3_storage_backend(const storage_config &config)
           "The only supported custom URI scheme is " +
           std::string{original_uri_schema});
     }
-    init_with_bucket_or_region(uri);
+    init_with_bucket_or_region(uri, config.get<"s3">());
     break;
   default:
     util::exception_location().raise<std::invalid_argument>(
         "URI of invalid scheme provided");
   }
+
+  const auto &optional_s3_config{config.get<"s3">()};
+  if (optional_s3_config.has_value()) {
+    const auto &optional_staging_memory_limit{
+        optional_s3_config->get<"staging_memory_limit">()};
+    if (optional_staging_memory_limit.has_value()) {
+      staging_memory_limit_ = optional_staging_memory_limit->get_value();
+    }
+  }
+  journal_enabled_ = optional_s3_config.has_value() &&
+                     optional_s3_config->get<"write_ahead_journal">().value_or(
+                         false);
+  if (journal_enabled_) {
+    upload_worker_ = std::make_unique<util::background_worker>(1U);
+  }
 }
 
 s3_storage_backend::~s3_storage_backend() {
   // bugprone-empty-catch should not be that strict in destructors
   try {
-    if (tmp_fstream_.is_open()) {
-      close_stream_internal();
+    // waiting for the background uploads to finish before destroying
+    // anything they use (the data that has not been uploaded because of an
+    // error will be replayed from the journal on the next run)
+    upload_worker_.reset();
+    if (!current_name_.empty()) {
+      const boost::scope::scope_exit close_guard{
+          [this]() noexcept { close_stream_internal(); }};
+      // the stream may be left open when the utility stops streaming in
+      // the middle of a binlog file, in which case the data uploaded so far
+      // must become visible in the object
+      finish_stream_internal();
     }
     if (owns_tmp_file_directory_) {
       std::error_code remove_ec;
@@ -602,7 +1390,8 @@ s3_storage_backend::~s3_storage_backend() {
 }
 
 void s3_storage_backend::init_with_bucket_or_region(
-    const boost::urls::url_view_base &uri) {
+    const boost::urls::url_view_base &uri,
+    const optional_s3_storage_config &tuning) {
   // "s3://" case
   assert(uri.scheme_id() == boost::urls::scheme::unknown);
   assert(uri.scheme() == original_uri_schema);
@@ -623,7 +1412,8 @@ void s3_storage_backend::init_with_bucket_or_region(
   if (host_fnd == std::string::npos) {
     // "<bucket_name>" branch (without "<region>")
     impl_ = std::make_unique<aws_context>(aws_context::bucket_tag{},
-                                          simple_aws_credentials{uri}, bucket_);
+                                          simple_aws_credentials{uri}, tuning,
+                                          bucket_);
   } else {
     // "<bucket_name>.<region>" branch
     const std::string region(bucket_, host_fnd + 1);
@@ -641,12 +1431,14 @@ void s3_storage_backend::init_with_bucket_or_region(
           "original s3 URI region must not be a qualified name");
     }
     impl_ = std::make_unique<aws_context>(aws_context::region_tag{},
-                                          simple_aws_credentials{uri}, region);
+                                          simple_aws_credentials{uri}, tuning,
+                                          region);
   }
 }
 
 void s3_storage_backend::init_with_endpoint(
-    const boost::urls::url_view_base &uri) {
+    const boost::urls::url_view_base &uri,
+    const optional_s3_storage_config &tuning) {
   // "http[s]://" case
   assert(uri.scheme_id() == boost::urls::scheme::http ||
          uri.scheme_id() == boost::urls::scheme::https);
@@ -690,8 +1482,8 @@ void s3_storage_backend::init_with_endpoint(
   }
 
   impl_ = std::make_unique<aws_context>(aws_context::endpoint_tag{},
-                                        simple_aws_credentials{uri}, endpoint,
-                                        secure_protocol);
+                                        simple_aws_credentials{uri}, tuning,
+                                        endpoint, secure_protocol);
 }
 
 [[nodiscard]] storage_object_name_container
@@ -702,20 +1494,79 @@ s3_storage_backend::do_list_objects() {
 [[nodiscard]] std::string
 s3_storage_backend::do_get_object(std::string_view name) {
   return impl_->get_object_into_string(
-      {.bucket = bucket_, .object_path = get_object_path(name)});
+      {.bucket = bucket_, .object_path = get_object_path(name)},
+      max_memory_object_size);
 }
 
 void s3_storage_backend::do_put_object(std::string_view name,
                                        util::const_byte_span content) {
   impl_->put_object_from_span(
       {.bucket = bucket_, .object_path = get_object_path(name)}, content);
+  if (name == appendable_object_name_) {
+    appendable_object_content_ = util::as_string_view(content);
+  }
+}
+
+void s3_storage_backend::do_append_to_object(std::string_view name,
+                                             util::const_byte_span content) {
+  // S3 does not support appending to existing objects, so the whole object
+  // is re-uploaded (the objects appended to are small, and keeping them
+  // regular objects keeps them readable by external tools)
+  const qualified_object_path object_path{.bucket = bucket_,
+                                          .object_path = get_object_path(name)};
+  if (name != appendable_object_name_) {
+    appendable_object_name_.clear();
+    appendable_object_content_ =
+        impl_->get_object_into_string(object_path, max_memory_object_size);
+    appendable_object_name_ = name;
+  }
+  // the cached content is updated only after a successful upload
+  auto new_content{appendable_object_content_};
+  new_content += util::as_string_view(content);
+  impl_->put_object_from_span(object_path,
+                              util::as_const_byte_span(new_content));
+  appendable_object_content_ = std::move(new_content);
+}
+
+void s3_storage_backend::do_put_object_from_file(
+    std::string_view name, const std::filesystem::path &source_path) {
+  std::fstream source_fstream{source_path,
+                              std::ios_base::in | std::ios_base::binary};
+  if (!source_fstream.is_open()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot open source file for S3 object body");
+  }
+  forget_appendable_object_internal(name);
+  // the body of the request is streamed by AWS SDK directly from the file
+  impl_->put_object_from_stream(
+      {.bucket = bucket_, .object_path = get_object_path(name)},
+      source_fstream);
+}
+
+void s3_storage_backend::do_get_object_into_file(
+    std::string_view name, const std::filesystem::path &destination_path) {
+  impl_->get_object_into_file(
+      {.bucket = bucket_, .object_path = get_object_path(name)},
+      destination_path);
 }
 
 void s3_storage_backend::do_remove_object(std::string_view name) {
+  forget_appendable_object_internal(name);
   impl_->delete_object(
       {.bucket = bucket_, .object_path = get_object_path(name)});
 }
 
+void s3_storage_backend::do_remove_objects(
+    std::span<const std::string> names) {
+  std::vector<std::filesystem::path> object_paths;
+  object_paths.reserve(std::size(names));
+  for (const auto &name : names) {
+    forget_appendable_object_internal(name);
+    object_paths.push_back(get_object_path(name));
+  }
+  impl_->delete_objects(bucket_, object_paths);
+}
+
 void s3_storage_backend::do_fsync() {
   // intentional no-op on S3: every PutObject / DeleteObject response
   // is itself the durability point (S3 provides strong
@@ -725,52 +1576,85 @@ void s3_storage_backend::do_fsync() {
 [[nodiscard]] std::uint64_t
 s3_storage_backend::do_open_stream(std::string_view name,
                                    storage_backend_open_stream_mode mode) {
-  assert(!tmp_fstream_.is_open());
-  current_name_ = name;
-  current_tmp_file_path_ = generate_tmp_file_path();
-
-  if (mode == storage_backend_open_stream_mode::append) {
-    impl_->get_object_into_file(
-        {.bucket = bucket_, .object_path = get_object_path(current_name_)},
-        current_tmp_file_path_);
+  const auto result{open_stream_internal(name, mode)};
+  if (journal_enabled_) {
+    const boost::scope::scope_fail close_guard{
+        [this]() noexcept { close_stream_internal(); }};
+    journal_.open(tmp_file_directory_, name, result);
+    const std::lock_guard lock{pending_upload_mutex_};
+    uploaded_offset_ = result;
   }
+  return result;
+}
 
-  const auto open_mode{std::ios_base::in | std::ios_base::out |
-                       std::ios_base::binary |
-                       (mode == storage_backend_open_stream_mode::create
-                            ? std::ios_base::trunc
-                            : std::ios_base::app | std::ios_base::ate)};
-  tmp_fstream_.open(current_tmp_file_path_, open_mode);
-  if (!tmp_fstream_.is_open()) {
-    util::exception_location().raise<std::runtime_error>(
-        "cannot open temporary file for S3 object body stream");
+void s3_storage_backend::do_write_data_to_stream(util::const_byte_span data) {
+  assert(!current_name_.empty());
+  if (std::empty(data)) {
+    return;
   }
+  if (journal_enabled_) {
+    const std::array<util::const_byte_span, 1U> portions{data};
+    journal_data_internal(portions);
+  } else {
+    upload_to_stream_internal({&data, 1U});
+  }
+}
 
-  const auto open_position{static_cast<std::streamoff>(tmp_fstream_.tellp())};
-
-  return static_cast<std::uint64_t>(open_position);
+void s3_storage_backend::do_write_data_portions_to_stream(
+    std::span<const util::const_byte_span> portions) {
+  assert(!current_name_.empty());
+  if (journal_enabled_) {
+    journal_data_internal(portions);
+  } else {
+    // every S3 object update is a separate request (or even several of
+    // them), so all the portions must be sent as a single update rather
+    // than one update per portion
+    upload_to_stream_internal(portions);
+  }
 }
 
-void s3_storage_backend::do_write_data_to_stream(util::const_byte_span data) {
-  assert(tmp_fstream_.is_open());
-  const auto data_sv{util::as_string_view(data)};
-  if (!tmp_fstream_.write(std::data(data_sv),
-                          static_cast<std::streamoff>(std::size(data_sv)))) {
-    util::exception_location().raise<std::runtime_error>(
-        "cannot write data to the temporary file for S3 object");
+void s3_storage_backend::do_sync_stream() {
+  if (!journal_enabled_) {
+    // intentional no-op: every 'do_write_data_to_stream' call finishes
+    // with a successful upload, which is itself the durability point
+    return;
   }
-  if (!tmp_fstream_.flush()) {
-    util::exception_location().raise<std::runtime_error>(
-        "cannot flush the temporary file for S3 object");
+  journal_.sync();
+
+  // when the background uploads have caught up with the journal, its
+  // records are no longer needed
+  if (journal_.get_end_offset() == journal_.get_begin_offset()) {
+    return;
+  }
+  const std::lock_guard lock{pending_upload_mutex_};
+  if (uploaded_offset_ == journal_.get_end_offset()) {
+    journal_.reset(uploaded_offset_);
   }
-  upload_tmp_stream_internal();
 }
 
 void s3_storage_backend::do_close_stream() {
-  assert(tmp_fstream_.is_open());
+  assert(!current_name_.empty());
+  if (journal_enabled_) {
+    upload_worker_->wait();
+  }
+  finish_stream_internal();
+  if (journal_enabled_) {
+    // the journal is removed only after all the data is uploaded (if the
+    // upload fails, the journal is kept for replaying on the next run)
+    journal_.discard();
+  }
   close_stream_internal();
-  current_tmp_file_path_.clear();
-  current_name_.clear();
+}
+
+void s3_storage_backend::do_prepare_for_streaming() {
+  // the data acknowledged during the previous run but not uploaded to S3
+  // before it terminated must be uploaded before anything else is done:
+  // first, the multipart uploads that were not completed are, and then the
+  // rest of the data is uploaded from the journals
+  complete_pending_uploads_internal();
+  if (journal_enabled_) {
+    replay_journals();
+  }
 }
 
 [[nodiscard]] std::string s3_storage_backend::do_get_description() const {
@@ -798,6 +1682,19 @@ void s3_storage_backend::do_close_stream() {
   res += root_path_.generic_string();
   res += ", credentials: ";
   res += (impl_->has_credentials() ? "***hidden***" : "none");
+  res += ", throughput target: ";
+  res += boost::lexical_cast<std::string>(impl_->get_throughput_target_gbps());
+  res += " Gbps, part size: ";
+  res += std::to_string(impl_->get_part_size());
+  res += ", max connections: ";
+  res += std::to_string(impl_->get_max_connections());
+  res += ", memory limit: ";
+  const auto memory_limit{impl_->get_memory_limit()};
+  res += (memory_limit == 0ULL ? "default" : std::to_string(memory_limit));
+  res += ", staging memory limit: ";
+  res += std::to_string(staging_memory_limit_);
+  res += ", write-ahead journal: ";
+  res += (journal_enabled_ ? "enabled" : "disabled");
 
   return res;
 }
@@ -834,19 +1731,425 @@ s3_storage_backend::generate_tmp_file_path() {
   return tmp_file_directory_ / boost::uuids::to_string(uuid_generator_());
 }
 
-void s3_storage_backend::upload_tmp_stream_internal() {
-  // S3 object may already exist, it is OK to overwrite it here
-  impl_->put_object_from_stream(
-      {.bucket = bucket_, .object_path = get_object_path(current_name_)},
-      tmp_fstream_);
+[[nodiscard]] std::uint64_t s3_storage_backend::open_stream_internal(
+    std::string_view name, storage_backend_open_stream_mode mode) {
+  assert(current_name_.empty());
+  current_name_ = name;
+  const boost::scope::scope_fail close_guard{
+      [this]() noexcept { close_stream_internal(); }};
+
+  committed_size_ = 0ULL;
+  committed_etag_.clear();
+  staged_offset_ = 0ULL;
+  staging_buffer_.clear();
+  if (mode == storage_backend_open_stream_mode::create) {
+    if (staging_memory_limit_ == 0ULL) {
+      open_tmp_stream_internal(false);
+    }
+    return committed_size_;
+  }
+
+  const qualified_object_path source{
+      .bucket = bucket_, .object_path = get_object_path(current_name_)};
+  // objects that are large enough to be server-side copied into the first
+  // part(s) of a multipart upload do not need to be downloaded at all - all
+  // subsequent writes will upload only new data
+  auto attributes{impl_->get_object_attributes(source)};
+  if (attributes.size >= min_multipart_part_size) {
+    committed_size_ = attributes.size;
+    committed_etag_ = std::move(attributes.etag);
+    staged_offset_ = committed_size_;
+  } else if (attributes.size <= staging_memory_limit_) {
+    staging_buffer_ =
+        impl_->get_object_into_string(source, staging_memory_limit_);
+    committed_size_ = std::size(staging_buffer_);
+    committed_etag_ = std::move(attributes.etag);
+  } else {
+    current_tmp_file_path_ = generate_tmp_file_path();
+    committed_etag_ =
+        impl_->get_object_into_file(source, current_tmp_file_path_);
+    open_tmp_stream_internal(true);
+    const auto open_position{
+        static_cast<std::streamoff>(tmp_fstream_.tellp())};
+    committed_size_ = static_cast<std::uint64_t>(open_position);
+  }
+
+  return committed_size_;
+}
+
+void s3_storage_backend::forget_appendable_object_internal(
+    std::string_view name) noexcept {
+  if (name == appendable_object_name_) {
+    appendable_object_name_.clear();
+    appendable_object_content_.clear();
+  }
+}
+
+void s3_storage_backend::upload_to_stream_internal(
+    std::span<const util::const_byte_span> portions) {
+  assert(!current_name_.empty());
+  std::size_t data_size{0U};
+  for (const auto portion : portions) {
+    data_size += std::size(portion);
+  }
+  if (data_size == 0U) {
+    return;
+  }
+  const qualified_object_path dest{.bucket = bucket_,
+                                   .object_path =
+                                       get_object_path(current_name_)};
+  if (multipart_upload_id_.empty() && staged_offset_ == 0ULL &&
+      committed_size_ + data_size < min_multipart_part_size) {
+    // while the object is smaller than the minimal multipart upload part
+    // size, we append the new data to the staged copy of the object and
+    // simply re-upload the whole of it (which is bounded by 5MiB), so that
+    // the object itself stays up to date
+    // S3 object may already exist, it is OK to overwrite it here
+    committed_etag_ = stage_and_upload_internal(
+        portions, data_size,
+        [this, &dest](std::iostream &content_stream, std::uint64_t) {
+          return impl_->put_object_from_stream(dest, content_stream);
+        });
+    committed_size_ += data_size;
+    return;
+  }
+
+  if (multipart_upload_id_.empty()) {
+    begin_multipart_upload_internal();
+  }
+  const auto part_number{std::size(multipart_part_etags_) + 1U};
+  const auto staged_size{committed_size_ - staged_offset_};
+  if (staged_size + data_size < min_multipart_part_size) {
+    // the staged data is still too small to become a regular part, so the
+    // new data is appended to it and the whole of it (bounded by 5MiB)
+    // replaces the last part uploaded before
+    staged_part_etag_ = stage_and_upload_internal(
+        portions, data_size,
+        [this, &dest, part_number](std::iostream &content_stream,
+                                   std::uint64_t content_length) {
+          return impl_->upload_part_from_stream(dest, multipart_upload_id_,
+                                                part_number, content_stream,
+                                                content_length);
+        });
+    committed_size_ += data_size;
+    return;
+  }
+
+  // otherwise, the staged data followed by the new data form one or more
+  // regular parts, after which nothing remains staged
+  std::string staged_content;
+  if (tmp_fstream_.is_open()) {
+    staged_content.resize(staged_size);
+    if (!tmp_fstream_.seekg(0) ||
+        !tmp_fstream_.read(std::data(staged_content),
+                           static_cast<std::streamsize>(staged_size))) {
+      util::exception_location().raise<std::runtime_error>(
+          "cannot read the temporary file for S3 object");
+    }
+  } else {
+    staged_content.swap(staging_buffer_);
+  }
+  const boost::scope::scope_fail restore_guard{
+      [this, &staged_content]() noexcept {
+        if (!tmp_fstream_.is_open()) {
+          staging_buffer_.swap(staged_content);
+        }
+      }};
+  std::vector<util::const_byte_span> part_portions;
+  part_portions.reserve(std::size(portions) + 1U);
+  part_portions.push_back(util::as_const_byte_span(staged_content));
+  part_portions.insert(std::end(part_portions), std::begin(portions),
+                       std::end(portions));
+  const auto parts_size{staged_size + data_size};
+  std::vector<std::string> part_etags;
+  for_each_multipart_range(
+      parts_size, [&](std::uint64_t offset, std::uint64_t size) {
+        const auto current_part_number{part_number + std::size(part_etags)};
+        if (current_part_number > max_multipart_parts) {
+          util::exception_location().raise<std::runtime_error>(
+              "S3 object exceeds the maximum number of multipart upload "
+              "parts");
+        }
+        part_etags.push_back(impl_->upload_part_from_portions(
+            dest, multipart_upload_id_, current_part_number,
+            slice_portions(part_portions, offset, size)));
+      });
+  if (tmp_fstream_.is_open()) {
+    tmp_fstream_.close();
+    open_tmp_stream_internal(false);
+  }
+  multipart_part_etags_.insert(std::end(multipart_part_etags_),
+                               std::make_move_iterator(std::begin(part_etags)),
+                               std::make_move_iterator(std::end(part_etags)));
+  staged_part_etag_.clear();
+  committed_size_ += data_size;
+  staged_offset_ = committed_size_;
+}
+
+[[nodiscard]] std::string s3_storage_backend::stage_and_upload_internal(
+    std::span<const util::const_byte_span> portions, std::size_t data_size,
+    const staged_content_uploader &uploader) {
+  if (!tmp_fstream_.is_open() &&
+      std::size(staging_buffer_) + data_size > staging_memory_limit_) {
+    spill_staging_buffer_internal();
+  }
+  if (tmp_fstream_.is_open()) {
+    for (const auto portion : portions) {
+      append_to_tmp_stream_internal(portion);
+    }
+    const auto staged_size{committed_size_ - staged_offset_ + data_size};
+    return uploader(tmp_fstream_, staged_size);
+  }
+  const auto staged_size{std::size(staging_buffer_)};
+  const boost::scope::scope_fail rollback_guard{
+      [this, staged_size]() noexcept { staging_buffer_.resize(staged_size); }};
+  staging_buffer_.reserve(staged_size + data_size);
+  for (const auto portion : portions) {
+    staging_buffer_ += util::as_string_view(portion);
+  }
+  const_byte_span_iostream content_stream{
+      util::as_const_byte_span(staging_buffer_)};
+  return uploader(content_stream, std::size(staging_buffer_));
+}
+
+void s3_storage_backend::begin_multipart_upload_internal() {
+  assert(multipart_upload_id_.empty());
+  const qualified_object_path dest{.bucket = bucket_,
+                                   .object_path =
+                                       get_object_path(current_name_)};
+  auto upload_id{impl_->create_multipart_upload(dest)};
+  // in case of any error, make sure that we do not leave an incomplete
+  // multipart upload behind (its parts would be billed until aborted)
+  const boost::scope::scope_fail abort_guard{
+      [this, &dest, &upload_id]() noexcept {
+        impl_->abort_multipart_upload(dest, upload_id);
+      }};
+  // the part of the existing object that has not been downloaded when the
+  // stream was opened is server-side copied only once per stream
+  std::vector<std::string> part_etags;
+  if (staged_offset_ != 0ULL) {
+    for_each_multipart_range(
+        staged_offset_, [&](std::uint64_t offset, std::uint64_t size) {
+          part_etags.push_back(impl_->upload_part_copy(
+              dest, upload_id, std::size(part_etags) + 1U, committed_etag_,
+              offset, size));
+        });
+  }
+  multipart_upload_id_ = std::move(upload_id);
+  multipart_part_etags_ = std::move(part_etags);
+  staged_part_etag_.clear();
+}
+
+void s3_storage_backend::finish_stream_internal() {
+  if (multipart_upload_id_.empty()) {
+    return;
+  }
+  const qualified_object_path dest{.bucket = bucket_,
+                                   .object_path =
+                                       get_object_path(current_name_)};
+  if (multipart_part_etags_.empty() && staged_part_etag_.empty()) {
+    impl_->abort_multipart_upload(dest, multipart_upload_id_);
+  } else {
+    if (!staged_part_etag_.empty()) {
+      multipart_part_etags_.push_back(staged_part_etag_);
+    }
+    const boost::scope::scope_fail restore_guard{[this]() noexcept {
+      if (!staged_part_etag_.empty()) {
+        multipart_part_etags_.pop_back();
+      }
+    }};
+    committed_etag_ = impl_->complete_multipart_upload(
+        dest, multipart_upload_id_, multipart_part_etags_);
+  }
+  multipart_upload_id_.clear();
+  multipart_part_etags_.clear();
+  staged_part_etag_.clear();
+}
+
+void s3_storage_backend::complete_pending_uploads_internal() {
+  const auto uploads{impl_->list_multipart_uploads(
+      {.bucket = bucket_, .object_path = root_path_})};
+  for (auto upload_it{std::cbegin(uploads)}; upload_it != std::cend(uploads);
+       ++upload_it) {
+    const qualified_object_path dest{
+        .bucket = bucket_, .object_path = get_object_path(upload_it->name)};
+    // only the most recently initiated upload of an object may contain data
+    // newer than the object itself, the older ones are leftovers of failed
+    // attempts to abort them
+    const auto next_upload_it{std::next(upload_it)};
+    if (next_upload_it != std::cend(uploads) &&
+        next_upload_it->name == upload_it->name) {
+      impl_->abort_multipart_upload(dest, upload_it->upload_id);
+      continue;
+    }
+    const auto part_etags{impl_->list_part_etags(dest, upload_it->upload_id)};
+    if (part_etags.empty()) {
+      impl_->abort_multipart_upload(dest, upload_it->upload_id);
+    } else {
+      static_cast<void>(impl_->complete_multipart_upload(
+          dest, upload_it->upload_id, part_etags));
+    }
+  }
+}
+
+void s3_storage_backend::open_tmp_stream_internal(bool downloaded) {
+  if (current_tmp_file_path_.empty()) {
+    current_tmp_file_path_ = generate_tmp_file_path();
+  }
+  const auto open_mode{std::ios_base::in | std::ios_base::out |
+                       std::ios_base::binary |
+                       (downloaded ? std::ios_base::app | std::ios_base::ate
+                                   : std::ios_base::trunc)};
+  tmp_fstream_.open(current_tmp_file_path_, open_mode);
+  if (!tmp_fstream_.is_open()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot open temporary file for S3 object body stream");
+  }
+}
+
+void s3_storage_backend::spill_staging_buffer_internal() {
+  open_tmp_stream_internal(false);
+  append_to_tmp_stream_internal(util::as_const_byte_span(staging_buffer_));
+  std::string{}.swap(staging_buffer_);
+}
+
+void s3_storage_backend::append_to_tmp_stream_internal(
+    util::const_byte_span data) {
+  const auto data_sv{util::as_string_view(data)};
+  // the stream may have been read (and therefore repositioned) by the
+  // uploads in between
+  if (!tmp_fstream_.seekp(0, std::ios_base::end) ||
+      !tmp_fstream_.write(std::data(data_sv),
+                          static_cast<std::streamoff>(std::size(data_sv)))) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot write data to the temporary file for S3 object");
+  }
+  if (!tmp_fstream_.flush()) {
+    util::exception_location().raise<std::runtime_error>(
+        "cannot flush the temporary file for S3 object");
+  }
 }
 
 void s3_storage_backend::close_stream_internal() {
-  tmp_fstream_.close();
-  // we allow std::filesystem::remove() here to fail - worst case scenario
-  // we will have a temporary file not removed
-  std::error_code remove_ec;
-  std::filesystem::remove(current_tmp_file_path_, remove_ec);
+  if (tmp_fstream_.is_open()) {
+    tmp_fstream_.close();
+  }
+  if (!current_tmp_file_path_.empty()) {
+    // we allow std::filesystem::remove() here to fail - worst case scenario
+    // we will have a temporary file not removed
+    std::error_code remove_ec;
+    std::filesystem::remove(current_tmp_file_path_, remove_ec);
+    current_tmp_file_path_.clear();
+  }
+  std::string{}.swap(staging_buffer_);
+  current_name_.clear();
+  committed_size_ = 0ULL;
+  committed_etag_.clear();
+  // an unfinished multipart upload is intentionally not aborted here, as it
+  // may contain already acknowledged data - it is completed on the next
+  // 'do_prepare_for_streaming()' call instead
+  staged_offset_ = 0ULL;
+  multipart_upload_id_.clear();
+  multipart_part_etags_.clear();
+  staged_part_etag_.clear();
+}
+
+void s3_storage_backend::journal_data_internal(
+    std::span<const util::const_byte_span> portions) {
+  // large writes (e.g. spilled transactions) are journaled in groups of
+  // portions, so that the amount of data waiting in memory to be uploaded
+  // stays bounded
+  while (!portions.empty()) {
+    std::size_t number_of_portions{0U};
+    std::size_t group_size{0U};
+    while (number_of_portions < std::size(portions) &&
+           group_size < max_pending_upload_size) {
+      group_size += std::size(portions[number_of_portions]);
+      ++number_of_portions;
+    }
+    journal_portion_group_internal(portions.first(number_of_portions));
+    portions = portions.subspan(number_of_portions);
+  }
+}
+
+void s3_storage_backend::journal_portion_group_internal(
+    std::span<const util::const_byte_span> portions) {
+  journal_.append(portions);
+
+  bool schedule_upload{false};
+  bool too_much_pending_data{false};
+  {
+    const std::lock_guard lock{pending_upload_mutex_};
+    for (const auto portion : portions) {
+      pending_upload_data_ += util::as_string_view(portion);
+    }
+    schedule_upload = !upload_scheduled_;
+    upload_scheduled_ = true;
+    too_much_pending_data =
+        std::size(pending_upload_data_) > max_pending_upload_size;
+  }
+  // all the data accumulated by the time the upload task starts is uploaded
+  // as a single S3 object update, so at most one task is scheduled at a time
+  if (schedule_upload) {
+    upload_worker_->submit([this] { upload_pending_data(); });
+  }
+  if (too_much_pending_data) {
+    upload_worker_->wait();
+  }
+}
+
+void s3_storage_backend::upload_pending_data() {
+  std::string data;
+  {
+    const std::lock_guard lock{pending_upload_mutex_};
+    data.swap(pending_upload_data_);
+    upload_scheduled_ = false;
+  }
+  const auto data_span{util::as_const_byte_span(data)};
+  upload_to_stream_internal({&data_span, 1U});
+  const std::lock_guard lock{pending_upload_mutex_};
+  uploaded_offset_ += std::size(data);
+}
+
+void s3_storage_backend::replay_journals() {
+  // the objects are listed only if there is something to replay
+  std::optional<storage_object_name_container> objects;
+  util::write_ahead_journal::replay_all(
+      tmp_file_directory_,
+      [this, &objects](const util::write_ahead_journal_content &content) {
+        if (!objects.has_value()) {
+          objects = do_list_objects();
+        }
+        replay_journal_content(content, *objects);
+      });
+}
+
+void s3_storage_backend::replay_journal_content(
+    const util::write_ahead_journal_content &content,
+    const storage_object_name_container &objects) {
+  const auto object_it{objects.find(content.object_name)};
+  const bool object_exists{object_it != std::end(objects)};
+  const auto object_size{object_exists ? object_it->second : 0ULL};
+  const auto journal_end_offset{content.offset + std::size(content.data)};
+  if (journal_end_offset <= object_size) {
+    return;
+  }
+  if (content.offset > object_size) {
+    util::exception_location().raise<std::runtime_error>(
+        "write-ahead journal for S3 object \"" + content.object_name +
+        "\" does not cover the end of this object");
+  }
+
+  const util::const_byte_span data{content.data};
+  const auto missing_data{data.subspan(object_size - content.offset)};
+  static_cast<void>(open_stream_internal(
+      content.object_name, object_exists
+                               ? storage_backend_open_stream_mode::append
+                               : storage_backend_open_stream_mode::create));
+  const boost::scope::scope_exit close_guard{
+      [this]() noexcept { close_stream_internal(); }};
+  upload_to_stream_internal({&missing_data, 1U});
+  finish_stream_internal();
 }
 
 } // namespace binsrv
@@ -16,23 +16,46 @@
 #ifndef BINSRV_S3_STORAGE_BACKEND_HPP
 #define BINSRV_S3_STORAGE_BACKEND_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <boost/url/url_view_base.hpp>
 
 #include <boost/uuid/uuid_generators.hpp>
 
 #include "binsrv/basic_storage_backend.hpp" // IWYU pragma: export
+#include "binsrv/s3_storage_config_fwd.hpp"
 #include "binsrv/storage_config_fwd.hpp"
 
+#include "util/background_worker_fwd.hpp"
+#include "util/write_ahead_journal.hpp"
+
 namespace binsrv {
 
 class [[nodiscard]] s3_storage_backend final : public basic_storage_backend {
 public:
   static constexpr std::size_t max_memory_object_size{1048576U};
+  // S3 multipart upload limits: every part except for the last one must be
+  // at least 5MiB and no part can be larger than 5GiB
+  static constexpr std::uint64_t min_multipart_part_size{5242880ULL};
+  static constexpr std::uint64_t max_multipart_part_size{5368709120ULL};
+  static constexpr std::size_t max_multipart_parts{10000U};
+  // S3 DeleteObjects request limit
+  static constexpr std::size_t max_keys_per_delete_request{1000U};
+  static constexpr std::size_t max_concurrent_delete_requests{8U};
+  // when the write-ahead journal is enabled, the amount of data waiting to
+  // be uploaded in the background above which writing to the stream blocks
+  // until all of it is uploaded
+  static constexpr std::size_t max_pending_upload_size{67108864U};
 
   static constexpr std::string_view original_uri_schema{"s3"};
 
@@ -58,30 +81,87 @@ private:
   boost::uuids::random_generator uuid_generator_;
   std::filesystem::path tmp_file_directory_;
   bool owns_tmp_file_directory_{false};
+  // the part of the object that has not been turned into a regular multipart
+  // upload part yet (the whole object while it is smaller than
+  // 'min_multipart_part_size') is staged either in 'staging_buffer_' (as long
+  // as it fits in 'staging_memory_limit_' bytes) or in the temporary file
+  std::uint64_t staging_memory_limit_{0ULL};
+  std::string staging_buffer_;
   std::filesystem::path current_tmp_file_path_;
   std::fstream tmp_fstream_;
+  // the size of the object as of the last successful upload and the ETag of
+  // the object itself
+  std::uint64_t committed_size_{0ULL};
+  std::string committed_etag_;
+  // once the object reaches 'min_multipart_part_size', a single multipart
+  // upload is kept open until the stream is closed, so that every update
+  // sends only the new data over the wire: the regular parts cover the first
+  // 'staged_offset_' bytes of the object, and the staged rest of it is
+  // re-uploaded as the last part on every update until it grows large enough
+  // to become a regular part itself; the object is replaced only when the
+  // upload is completed (in 'do_close_stream()' or, after a crash, in
+  // 'do_prepare_for_streaming()'), so until then readers see its old version
+  std::uint64_t staged_offset_{0ULL};
+  std::string multipart_upload_id_;
+  std::vector<std::string> multipart_part_etags_;
+  std::string staged_part_etag_;
+  // as S3 does not support appending to existing objects, the content of the
+  // object most recently passed to 'do_append_to_object' is cached here so
+  // that subsequent appends to it do not need to download it again
+  std::string appendable_object_name_;
+  std::string appendable_object_content_;
+
+  // when enabled, the data written to the stream is acknowledged as soon as
+  // it is recorded in the local write-ahead journal (in the filesystem buffer
+  // directory) and is uploaded to S3 in the background
+  bool journal_enabled_{false};
+  util::write_ahead_journal journal_{};
+  // protects the 3 members below, which are shared with the upload worker
+  std::mutex pending_upload_mutex_{};
+  std::string pending_upload_data_{};
+  bool upload_scheduled_{false};
+  // the offset of the object up to which the data is known to be uploaded
+  std::uint64_t uploaded_offset_{0ULL};
+  using upload_worker_ptr = std::unique_ptr<util::background_worker>;
+  upload_worker_ptr upload_worker_{};
 
   class aws_context;
   using aws_context_ptr = std::unique_ptr<aws_context>;
   aws_context_ptr impl_;
 
-  void init_with_bucket_or_region(const boost::urls::url_view_base &uri);
-  void init_with_endpoint(const boost::urls::url_view_base &uri);
+  void init_with_bucket_or_region(const boost::urls::url_view_base &uri,
+                                  const optional_s3_storage_config &tuning);
+  void init_with_endpoint(const boost::urls::url_view_base &uri,
+                          const optional_s3_storage_config &tuning);
 
   [[nodiscard]] storage_object_name_container do_list_objects() override;
 
   [[nodiscard]] std::string do_get_object(std::string_view name) override;
   void do_put_object(std::string_view name,
                      util::const_byte_span content) override;
+  void do_append_to_object(std::string_view name,
+                           util::const_byte_span content) override;
+  void
+  do_put_object_from_file(std::string_view name,
+                          const std::filesystem::path &source_path) override;
+  void do_get_object_into_file(
+      std::string_view name,
+      const std::filesystem::path &destination_path) override;
   void do_remove_object(std::string_view name) override;
+  void do_remove_objects(std::span<const std::string> names) override;
   void do_fsync() override;
 
   [[nodiscard]] std::uint64_t
   do_open_stream(std::string_view name,
                  storage_backend_open_stream_mode mode) override;
   void do_write_data_to_stream(util::const_byte_span data) override;
+  void do_write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions) override;
+  void do_sync_stream() override;
   void do_close_stream() override;
 
+  void do_prepare_for_streaming() override;
+
   [[nodiscard]] std::string do_get_description() const override;
   [[nodiscard]] std::string
   do_get_object_uri(std::string_view name) const override;
@@ -89,8 +169,34 @@ private:
   [[nodiscard]] std::filesystem::path
   get_object_path(std::string_view name) const;
   [[nodiscard]] std::filesystem::path generate_tmp_file_path();
-  void upload_tmp_stream_internal();
+
+  void forget_appendable_object_internal(std::string_view name) noexcept;
+  [[nodiscard]] std::uint64_t
+  open_stream_internal(std::string_view name,
+                       storage_backend_open_stream_mode mode);
+  void upload_to_stream_internal(
+      std::span<const util::const_byte_span> portions);
+  using staged_content_uploader =
+      std::function<std::string(std::iostream &, std::uint64_t)>;
+  [[nodiscard]] std::string
+  stage_and_upload_internal(std::span<const util::const_byte_span> portions,
+                            std::size_t data_size,
+                            const staged_content_uploader &uploader);
+  void begin_multipart_upload_internal();
+  void finish_stream_internal();
+  void complete_pending_uploads_internal();
+  void open_tmp_stream_internal(bool downloaded);
+  void spill_staging_buffer_internal();
+  void append_to_tmp_stream_internal(util::const_byte_span data);
   void close_stream_internal();
+
+  void journal_data_internal(std::span<const util::const_byte_span> portions);
+  void journal_portion_group_internal(
+      std::span<const util::const_byte_span> portions);
+  void upload_pending_data();
+  void replay_journals();
+  void replay_journal_content(const util::write_ahead_journal_content &content,
+                              const storage_object_name_container &objects);
 };
 
 } // namespace binsrv
@@ -0,0 +1,57 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+#include "binsrv/s3_storage_config.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "binsrv/s3_storage_backend.hpp"
+
+#include "util/exception_location_helpers.hpp"
+
+namespace binsrv {
+
+void s3_storage_config::validate() const {
+  const auto &optional_throughput_target_gbps{get<"throughput_target_gbps">()};
+  if (optional_throughput_target_gbps.has_value() &&
+      !(*optional_throughput_target_gbps > 0.0)) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating s3 storage config: throughput target must be "
+        "positive");
+  }
+
+  static constexpr auto min_part_size{
+      s3_storage_backend::min_multipart_part_size};
+  static constexpr auto max_part_size{
+      s3_storage_backend::max_multipart_part_size};
+  const auto &optional_part_size{get<"part_size">()};
+  if (optional_part_size.has_value() &&
+      (optional_part_size->get_value() < min_part_size ||
+       optional_part_size->get_value() > max_part_size)) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating s3 storage config: part size must be in the [" +
+        std::to_string(min_part_size) + ", " + std::to_string(max_part_size) +
+        "] bytes range");
+  }
+
+  const auto &optional_max_connections{get<"max_connections">()};
+  if (optional_max_connections.has_value() && *optional_max_connections == 0U) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating s3 storage config: max connections must be "
+        "positive");
+  }
+}
+
+} // namespace binsrv
@@ -0,0 +1,48 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+#ifndef BINSRV_S3_STORAGE_CONFIG_HPP
+#define BINSRV_S3_STORAGE_CONFIG_HPP
+
+#include "binsrv/s3_storage_config_fwd.hpp" // IWYU pragma: export
+
+#include <optional>
+
+#include "binsrv/size_unit.hpp"
+
+#include "util/common_optional_types.hpp"
+#include "util/nv_tuple.hpp"
+
+namespace binsrv {
+
+// Tuning parameters of the AWS S3 CRT client - every parameter that is not
+// specified keeps the AWS SDK default value - and of the S3 storage backend
+// itself.
+// clang-format off
+struct [[nodiscard]] s3_storage_config
+    : util::nv_tuple<
+          util::nv<"throughput_target_gbps", std::optional<double>>,
+          util::nv<"part_size", optional_size_unit>,
+          util::nv<"max_connections", util::optional_uint32_t>,
+          util::nv<"memory_limit", optional_size_unit>,
+          util::nv<"staging_memory_limit", optional_size_unit>,
+          util::nv<"write_ahead_journal", util::optional_bool>
+      > {
+  void validate() const;
+};
+// clang-format on
+
+} // namespace binsrv
+
+#endif // BINSRV_S3_STORAGE_CONFIG_HPP
@@ -16,6 +16,7 @@
 #include "binsrv/storage.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -23,18 +24,25 @@
 #include <exception>
 #include <filesystem>
 #include <iterator>
+#include <mutex>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <stop_token>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "binsrv/basic_storage_backend.hpp"
 #include "binsrv/binlog_file_metadata.hpp"
+#include "binsrv/binlog_file_metadata_delta.hpp"
 #include "binsrv/replication_mode_type.hpp"
 #include "binsrv/storage_backend_factory.hpp"
 #include "binsrv/storage_config.hpp"
+#include "binsrv/storage_manifest.hpp"
 #include "binsrv/storage_metadata.hpp"
 
 #include "binsrv/events/common_types.hpp"
@@ -44,9 +52,11 @@
 #include "binsrv/gtids/gtid.hpp"
 #include "binsrv/gtids/gtid_set.hpp"
 
+#include "util/background_worker.hpp"
 #include "util/byte_span.hpp"
 #include "util/ctime_timestamp.hpp"
 #include "util/exception_location_helpers.hpp"
+#include "util/thread_pool.hpp"
 
 namespace binsrv {
 
@@ -60,13 +70,65 @@ storage::storage(const storage_config &config,
     checkpoint_size_bytes_ = checkpoint_size_opt->get_value();
   }
 
+  event_buffer_ = util::chunked_byte_buffer{
+      event_buffer_chunk_size,
+      size_checkpointing_enabled()
+          ? static_cast<std::size_t>(std::min<std::uint64_t>(
+                checkpoint_size_bytes_, max_event_buffer_spare_size))
+          : default_event_buffer_spare_size};
+
+  const auto &event_buffer_memory_limit_opt{
+      config.get<"event_buffer_memory_limit">()};
+  if (event_buffer_memory_limit_opt.has_value()) {
+    event_buffer_memory_limit_ = event_buffer_memory_limit_opt->get_value();
+  }
+  if (event_buffer_memory_limit_enabled()) {
+    const auto &fs_buffer_directory_opt{config.get<"fs_buffer_directory">()};
+    spill_directory_ = fs_buffer_directory_opt.has_value()
+                           ? std::filesystem::path{*fs_buffer_directory_opt}
+                           : std::filesystem::temp_directory_path();
+  }
+
   const auto &checkpoint_interval_opt{config.get<"checkpoint_interval">()};
   if (checkpoint_interval_opt.has_value()) {
     checkpoint_interval_seconds_ =
         std::chrono::seconds{checkpoint_interval_opt->get_value()};
   }
 
+  manifest_update_rotations_ =
+      config.get<"manifest_update_rotations">().value_or(0U);
+  metadata_load_concurrency_ =
+      config.get<"metadata_load_concurrency">().value_or(
+          default_metadata_load_concurrency);
+  metadata_journal_snapshot_interval_ =
+      config.get<"metadata_journal_snapshot_interval">().value_or(0U);
+  preallocate_binlog_files_ =
+      config.get<"preallocate_binlog_files">().value_or(false);
+
   backend_ = storage_backend_factory::create(config);
+  if (construction_mode_ == storage_construction_mode_type::streaming) {
+    backend_->prepare_for_streaming();
+  }
+
+  const auto &checkpoint_batching_window_opt{
+      config.get<"checkpoint_batching_window_ms">()};
+  if (checkpoint_batching_window_opt.has_value()) {
+    checkpoint_batching_window_ =
+        std::chrono::milliseconds{*checkpoint_batching_window_opt};
+  }
+
+  const auto &checkpoint_queue_size_opt{config.get<"checkpoint_queue_size">()};
+  if (construction_mode_ == storage_construction_mode_type::streaming &&
+      checkpoint_queue_size_opt.value_or(0U) != 0U) {
+    checkpoint_worker_ =
+        std::make_unique<util::background_worker>(*checkpoint_queue_size_opt);
+  }
+  if (construction_mode_ == storage_construction_mode_type::streaming &&
+      (interval_checkpointing_enabled() || checkpoint_batching_enabled())) {
+    checkpoint_timer_ = std::jthread{[this](const std::stop_token &stoken) {
+      run_checkpoint_timer(stoken);
+    }};
+  }
 
   auto storage_objects{backend_->list_objects()};
   if (storage_objects.empty()) {
@@ -108,8 +170,20 @@ storage::storage(const storage_config &config,
   }
   storage_objects.erase(binlog_index_it);
 
-  // extracting all binlog file metadata files into a separate container
+  // the manifest is optional; its extension deliberately differs from the one
+  // of binlog file metadata objects, so that it can never be mistaken for
+  // one of them (neither here nor by older versions of the utility)
+  binlog_record_container manifest_records;
+  const auto manifest_it{storage_objects.find(manifest_name)};
+  if (manifest_it != std::cend(storage_objects)) {
+    storage_objects.erase(manifest_it);
+    manifest_records = load_manifest();
+  }
+
+  // extracting all binlog file metadata files and binlog file metadata
+  // journals into separate containers
   storage_object_name_container storage_metadata_objects;
+  storage_object_name_container storage_metadata_journal_objects;
   for (auto storage_object_it{std::cbegin(storage_objects)};
        storage_object_it != std::cend(storage_objects);) {
     const std::filesystem::path object_name{storage_object_it->first};
@@ -117,6 +191,10 @@ storage::storage(const storage_config &config,
         object_name.extension() == binlog_metadata_extension) {
       auto object_node = storage_objects.extract(storage_object_it++);
       storage_metadata_objects.insert(std::move(object_node));
+    } else if (object_name.has_extension() &&
+               object_name.extension() == binlog_metadata_journal_extension) {
+      auto object_node = storage_objects.extract(storage_object_it++);
+      storage_metadata_journal_objects.insert(std::move(object_node));
     } else {
       ++storage_object_it;
     }
@@ -124,13 +202,18 @@ storage::storage(const storage_config &config,
   load_binlog_index();
   validate_binlog_index(storage_objects);
 
-  load_and_validate_binlog_metadata_set(storage_objects,
-                                        storage_metadata_objects);
+  load_and_validate_binlog_metadata_set(
+      storage_objects, storage_metadata_objects,
+      storage_metadata_journal_objects, std::move(manifest_records));
   assert(!binlog_records_.front().added_gtids.has_value() ||
          purged_gtids_ == binlog_records_.front().added_gtids);
 }
 
 storage::~storage() {
+  if (checkpoint_timer_.joinable()) {
+    checkpoint_timer_.request_stop();
+    checkpoint_timer_.join();
+  }
   if (construction_mode_ == storage_construction_mode_type::streaming) {
     // bugprone-empty-catch should not be that strict in destructors
     try {
@@ -156,17 +239,69 @@ void storage::set_purged_gtids(const gtids::gtid_set &purged_gtids) {
   return backend_->get_description();
 }
 
+[[nodiscard]] std::vector<std::string> storage::extract_backend_warnings() {
+  return backend_->extract_warnings();
+}
+
 [[nodiscard]] bool storage::is_in_gtid_replication_mode() const noexcept {
   return replication_mode_ == replication_mode_type::gtid;
 }
 
 [[nodiscard]] bool storage::is_binlog_open() const noexcept {
-  return backend_->is_stream_open();
+  return binlog_open_;
+}
+
+void storage::begin_idle() {
+  if (!checkpoint_timer_.joinable()) {
+    return;
+  }
+  // the deadline depends on the state modified only by this thread, so it is
+  // published here for the checkpoint timer thread
+  const auto deadline{
+      get_idle_checkpoint_deadline().time_since_epoch().count()};
+  idle_checkpoint_deadline_.store(deadline);
+  idle_state_.store(idle_state_type::idle);
+  // the checkpoint timer thread is woken up only when it is going to sleep
+  // past the deadline; the wake time is lowered here so that this happens
+  // once per checkpoint rather than on every event
+  auto wake_time{checkpoint_timer_wake_time_.load()};
+  while (deadline < wake_time) {
+    if (checkpoint_timer_wake_time_.compare_exchange_weak(wake_time,
+                                                          deadline)) {
+      {
+        const std::lock_guard lock{checkpoint_timer_mutex_};
+        checkpoint_timer_wakeup_requested_ = true;
+      }
+      checkpoint_timer_wakeup_.notify_one();
+      break;
+    }
+  }
+}
+
+void storage::end_idle() noexcept {
+  if (!checkpoint_timer_.joinable()) {
+    return;
+  }
+  auto expected{idle_state_type::idle};
+  while (!idle_state_.compare_exchange_weak(expected,
+                                            idle_state_type::active)) {
+    if (expected == idle_state_type::active) {
+      break;
+    }
+    // blocks only while the checkpoint timer thread is performing a
+    // checkpoint
+    if (expected == idle_state_type::checkpointing) {
+      idle_state_.wait(idle_state_type::checkpointing);
+    }
+    expected = idle_state_type::idle;
+  }
 }
 
 [[nodiscard]] open_binlog_status
 storage::open_binlog(const events::composite_binlog_name &binlog_name) {
   ensure_streaming_mode();
+  rethrow_idle_checkpoint_error();
+  wait_for_pending_checkpoints();
 
   auto result{open_binlog_status::opened_with_data_present};
 
@@ -194,6 +329,14 @@ storage::open_binlog(const events::composite_binlog_name &binlog_name) {
   const auto mode{binlog_exists ? storage_backend_open_stream_mode::append
                                 : storage_backend_open_stream_mode::create};
   const auto open_stream_offset{backend_->open_stream(binlog_name.str(), mode)};
+  binlog_open_ = true;
+  // reserving space for the whole binlog file in advance keeps it contiguous
+  // on disk and saves a filesystem metadata update on every append that
+  // would otherwise extend the file (the space left unused is released by
+  // the backend when the stream is closed)
+  if (preallocate_binlog_files_ && expected_binlog_file_size_ != 0ULL) {
+    backend_->preallocate_stream(expected_binlog_file_size_);
+  }
 
   if (binlog_exists) {
     result = open_existing_binlog_file_internal(open_stream_offset);
@@ -208,8 +351,7 @@ storage::open_binlog(const events::composite_binlog_name &binlog_name) {
   }
   update_last_checkpoint_info();
 
-  assert(std::size(event_buffer_) == 0U);
-  event_buffer_.reserve(default_event_buffer_size_in_bytes);
+  assert(get_buffered_size() == 0ULL);
   assert(!has_event_data_to_flush());
   assert(gtids_in_event_buffer_.is_empty());
   assert(ready_to_flush_timestamps_.is_empty());
@@ -224,9 +366,70 @@ void storage::write_event(util::const_byte_span event_data,
                           const util::ctime_timestamp &event_timestamp,
                           events::seq_no_t transaction_sequence_number) {
   ensure_streaming_mode();
+  rethrow_idle_checkpoint_error();
+
+  reserved_event_size_.reset();
+  buffer_event_data(event_data);
+  register_buffered_event(at_transaction_boundary, transaction_gtid,
+                          event_timestamp, transaction_sequence_number);
+}
+
+[[nodiscard]] util::byte_span storage::reserve_event(std::size_t size) {
+  ensure_streaming_mode();
+  rethrow_idle_checkpoint_error();
+
+  reserved_event_size_.reset();
+  // the early checkpoint (if any) is performed here rather than in
+  // 'commit_event()', as it would invalidate the reserved space
+  reserved_event_spilled_ = prepare_for_buffering_event_data(size);
+  util::byte_span result{};
+  if (reserved_event_spilled_) {
+    reserved_spilled_event_.resize(size);
+    result = util::byte_span{reserved_spilled_event_};
+  } else {
+    result = event_buffer_.prepare(size);
+  }
+  reserved_event_size_ = size;
+  return result;
+}
+
+void storage::commit_event(bool at_transaction_boundary,
+                           const gtids::gtid &transaction_gtid,
+                           const util::ctime_timestamp &event_timestamp,
+                           events::seq_no_t transaction_sequence_number) {
+  ensure_streaming_mode();
+  rethrow_idle_checkpoint_error();
+
+  if (!reserved_event_size_.has_value()) {
+    util::exception_location().raise<std::logic_error>(
+        "cannot commit an event that was not reserved");
+  }
+  const auto size{*reserved_event_size_};
+  reserved_event_size_.reset();
+  if (reserved_event_spilled_) {
+    if (!spill_file_.is_open()) {
+      spill_file_.open(spill_directory_);
+    }
+    spill_file_.append(util::const_byte_span{reserved_spilled_event_});
+    // only the events that do not fit into the memory limit get here, so
+    // there is no point in keeping the memory for the next one
+    reserved_spilled_event_ = std::vector<std::byte>{};
+  } else {
+    event_buffer_.commit(size);
+  }
+  register_buffered_event(at_transaction_boundary, transaction_gtid,
+                          event_timestamp, transaction_sequence_number);
+}
+
+void storage::cancel_reserved_event() noexcept {
+  reserved_event_size_.reset();
+  reserved_spilled_event_ = std::vector<std::byte>{};
+}
 
-  event_buffer_.insert(std::end(event_buffer_), std::cbegin(event_data),
-                       std::cend(event_data));
+void storage::register_buffered_event(
+    bool at_transaction_boundary, const gtids::gtid &transaction_gtid,
+    const util::ctime_timestamp &event_timestamp,
+    events::seq_no_t transaction_sequence_number) {
   incomplete_transaction_timestamps_.add_timestamp(event_timestamp);
   if (transaction_sequence_number != 0ULL) {
     incomplete_transaction_last_sequence_number_ = transaction_sequence_number;
@@ -234,7 +437,7 @@ void storage::write_event(util::const_byte_span event_data,
 
   if (at_transaction_boundary) {
     last_transaction_boundary_position_in_event_buffer_ =
-        std::size(event_buffer_);
+        get_buffered_size();
     if (is_in_gtid_replication_mode() && !transaction_gtid.is_empty()) {
       gtids_in_event_buffer_ += transaction_gtid;
     }
@@ -259,40 +462,72 @@ void storage::write_event(util::const_byte_span event_data,
     // calculated "ready_to_flush_position" instead of
     // "get_current_position()" directly to take into account that some event
     // data may remain buffered
-    const bool needs_flush{
+    bool needs_flush{
         (size_checkpointing_enabled() &&
          (ready_to_flush_position >=
           last_checkpoint_position_ + checkpoint_size_bytes_)) ||
         (interval_checkpointing_enabled() &&
          (now_ts >=
           last_checkpoint_timestamp_ + checkpoint_interval_seconds_))};
+    // group commit: with a high transaction rate, postponing a checkpoint
+    // until the batching window has passed allows to make several
+    // transactions durable with a single sync instead of one sync per
+    // transaction (if no more events arrive, the postponed checkpoint is
+    // performed by the checkpoint timer thread when the window expires)
+    checkpoint_postponed_ =
+        needs_flush && checkpoint_batching_enabled() &&
+        now_ts < last_checkpoint_timestamp_ + checkpoint_batching_window_;
+    if (checkpoint_postponed_) {
+      needs_flush = false;
+    }
+    // spilled data is written out as soon as the transaction it belongs to
+    // is complete (regardless of the checkpointing settings), so that the
+    // spill file never contains more than one transaction
+    if (has_spilled_event_data()) {
+      needs_flush = true;
+    }
 
     if (needs_flush) {
       flush_event_buffer_internal();
 
       last_checkpoint_position_ = ready_to_flush_position;
       last_checkpoint_timestamp_ = now_ts;
+      checkpoint_postponed_ = false;
     }
   }
 }
 
 void storage::close_binlog() {
   ensure_streaming_mode();
+  rethrow_idle_checkpoint_error();
 
   // This flush is the only path that guarantees the file-final ROTATE/STOP
   // event lands on the backend.
   flush_event_buffer();
-  event_buffer_.clear();
-  event_buffer_.shrink_to_fit();
+  // the chunks of the event buffer are kept for the next binlog file
+  clear_event_buffer();
+
+  // the metadata of a closed binlog file is never going to change, so its
+  // journal (if any) is folded into a regular metadata object here
+  if (metadata_journal_entries_ != 0U) {
+    save_binlog_metadata_snapshot(get_current_binlog_record());
+  }
 
   backend_->close_stream();
+  binlog_open_ = false;
   update_last_checkpoint_info();
 }
 
 void storage::discard_incomplete_transaction_events() {
   ensure_streaming_mode();
 
-  event_buffer_.resize(last_transaction_boundary_position_in_event_buffer_);
+  if (has_spilled_event_data()) {
+    // spilled data always belongs to the incomplete transaction
+    assert(last_transaction_boundary_position_in_event_buffer_ <=
+           event_buffer_.size());
+    spill_file_.truncate(0ULL);
+  }
+  event_buffer_.truncate(last_transaction_boundary_position_in_event_buffer_);
   incomplete_transaction_timestamps_.clear();
   incomplete_transaction_last_sequence_number_ =
       ready_to_flush_last_sequence_number_;
@@ -300,10 +535,12 @@ void storage::discard_incomplete_transaction_events() {
 
 void storage::flush_event_buffer() {
   ensure_streaming_mode();
+  rethrow_idle_checkpoint_error();
 
   if (has_event_data_to_flush()) {
     flush_event_buffer_internal();
   }
+  wait_for_pending_checkpoints();
 }
 
 [[nodiscard]] std::pair<storage::binlog_record_container, std::string>
@@ -385,17 +622,30 @@ storage::purge_binlogs(const events::composite_binlog_name &target) {
     victim_object_names.emplace_back(victim.name.str());
   }
   std::string cleanup_warning_message;
+  if (manifest_enabled()) {
+    // the manifest is merely a cache (entries that are not present in the
+    // binlog index are ignored), so failing to update it does not make
+    // the purge unsuccessful
+    try {
+      save_manifest();
+    } catch (const std::exception &e) {
+      cleanup_warning_message = e.what();
+    }
+  }
   try {
     backend_->remove_objects(victim_object_names);
   } catch (const std::exception &e) {
-    // 'remove_objects' re-raises the first per-name failure (if any)
-    // after running the durability barrier; we do not propagate it
+    // 'remove_objects' re-raises a per-name failure (if any) after
+    // running the durability barrier; we do not propagate it
     // to the caller because the index has already been committed
     // and any leftover payload/metadata files will be picked up by
     // the constructor's validators on the next startup. We just
     // capture the underlying message so the caller can surface it
     // under a 'warning' status in the JSON response.
-    cleanup_warning_message = e.what();
+    if (!cleanup_warning_message.empty()) {
+      cleanup_warning_message += "; ";
+    }
+    cleanup_warning_message += e.what();
   }
 
   return {std::move(removed_records), std::move(cleanup_warning_message)};
@@ -424,9 +674,10 @@ void storage::update_last_checkpoint_info() {
   if (size_checkpointing_enabled()) {
     last_checkpoint_position_ = get_current_position();
   }
-  if (interval_checkpointing_enabled()) {
+  if (interval_checkpointing_enabled() || checkpoint_batching_enabled()) {
     last_checkpoint_timestamp_ = std::chrono::steady_clock::now();
   }
+  checkpoint_postponed_ = false;
 }
 
 [[nodiscard]] open_binlog_status storage::open_new_binlog_file_internal(
@@ -434,6 +685,7 @@ void storage::update_last_checkpoint_info() {
   // writing the magic binlog footprint only if this is a newly
   // created file
   backend_->write_data_to_stream(events::magic_binlog_payload);
+  backend_->sync_stream();
 
   gtids::optional_gtid_set previous_binlog_gtids{};
   gtids::optional_gtid_set added_binlog_gtids{};
@@ -447,7 +699,22 @@ void storage::update_last_checkpoint_info() {
                                std::move(added_binlog_gtids),
                                util::ctime_timestamp_range{});
   save_binlog_metadata(get_current_binlog_record());
-  save_binlog_index();
+  // rotations only add a single line to the end of the binlog index, so
+  // instead of rewriting it as a whole (which would make a long series of
+  // rotations quadratic) we just append it there
+  if (std::size(binlog_records_) == 1U) {
+    save_binlog_index();
+  } else {
+    append_to_binlog_index(get_current_binlog_record());
+  }
+
+  if (manifest_enabled() && std::size(binlog_records_) > 1U) {
+    // the previous binlog file has just become a closed one
+    ++binlogs_missing_from_manifest_;
+    if (binlogs_missing_from_manifest_ >= manifest_update_rotations_) {
+      save_manifest();
+    }
+  }
   return open_binlog_status::created;
 }
 [[nodiscard]] open_binlog_status
@@ -465,37 +732,61 @@ storage::open_existing_binlog_file_internal(std::uint64_t open_stream_offset) {
 }
 
 void storage::flush_event_buffer_internal() {
-  assert(!event_buffer_.empty());
+  assert(has_event_data_to_flush());
   assert(last_transaction_boundary_position_in_event_buffer_ <=
-         std::size(event_buffer_));
-
-  const util::const_byte_span transactions_data{
-      std::data(event_buffer_),
-      last_transaction_boundary_position_in_event_buffer_};
-  // writing <last_transaction_boundary_position_in_event_buffer_> bytes from
-  // the beginning of the event buffer
-  backend_->write_data_to_stream(transactions_data);
-  get_current_binlog_record().size +=
-      last_transaction_boundary_position_in_event_buffer_;
-  if (is_in_gtid_replication_mode()) {
-    auto &optional_added_gtids{get_current_binlog_record().added_gtids};
-    if (optional_added_gtids.has_value()) {
-      *optional_added_gtids += gtids_in_event_buffer_;
+         get_buffered_size());
+
+  if (checkpoint_worker_ && !has_spilled_event_data()) {
+    // detaching the first <last_transaction_boundary_position_in_event_buffer_>
+    // bytes of the event buffer (instead of copying them) and leaving only
+    // the incomplete transaction data in it
+    auto transactions_data{event_buffer_.detach_front(
+        last_transaction_boundary_position_in_event_buffer_)};
+
+    update_current_binlog_record_on_flush();
+    // binlog metadata snapshot must be saved only after the corresponding
+    // event data is written, so both operations are performed by the same
+    // task
+    // submit() blocks when there are too many pending checkpoints, which
+    // slows down the receiving thread to the speed of the storage backend
+    checkpoint_worker_->submit(
+        [this, data = std::move(transactions_data),
+         record = get_current_binlog_record(),
+         added_gtids = get_gtids_in_event_buffer()] {
+          backend_->write_data_portions_to_stream(data.get_portions());
+          backend_->sync_stream();
+          checkpoint_binlog_metadata(record, added_gtids);
+        });
+  } else {
+    if (has_spilled_event_data()) {
+      // spilled data cannot be handed over to the checkpoint worker, so
+      // such checkpoints are always performed synchronously (after all the
+      // pending ones)
+      wait_for_pending_checkpoints();
+      write_spilled_event_buffer_internal();
+    } else {
+      // writing <last_transaction_boundary_position_in_event_buffer_> bytes
+      // from the beginning of the event buffer
+      backend_->write_data_portions_to_stream(event_buffer_.get_portions(
+          last_transaction_boundary_position_in_event_buffer_));
     }
-  }
-  get_current_binlog_record().timestamps.add_range(ready_to_flush_timestamps_);
-  get_current_binlog_record().last_sequence_number =
-      ready_to_flush_last_sequence_number_;
+    // event data must be durable before the metadata referring to it
+    backend_->sync_stream();
+    update_current_binlog_record_on_flush();
 
-  save_binlog_metadata(get_current_binlog_record());
+    checkpoint_binlog_metadata(get_current_binlog_record(),
+                               get_gtids_in_event_buffer());
 
-  const auto begin_it{std::cbegin(event_buffer_)};
-  const auto portion_it{std::next(
-      begin_it, static_cast<std::ptrdiff_t>(
-                    last_transaction_boundary_position_in_event_buffer_))};
-  // erasing those <last_transaction_boundary_position_in_event_buffer_> bytes
-  // from the beginning of this buffer
-  event_buffer_.erase(begin_it, portion_it);
+    if (has_spilled_event_data()) {
+      clear_event_buffer();
+    } else {
+      // removing those <last_transaction_boundary_position_in_event_buffer_>
+      // bytes from the beginning of this buffer (the remaining data is not
+      // moved)
+      event_buffer_.consume(
+          last_transaction_boundary_position_in_event_buffer_);
+    }
+  }
   last_transaction_boundary_position_in_event_buffer_ = 0U;
   if (is_in_gtid_replication_mode()) {
     gtids_in_event_buffer_.clear();
@@ -503,6 +794,207 @@ void storage::flush_event_buffer_internal() {
   ready_to_flush_timestamps_.clear();
 }
 
+void storage::write_spilled_event_buffer_internal() {
+  // spilling starts only after all complete transactions are flushed from
+  // the event buffer and the spilled data is flushed as soon as its
+  // transaction is complete, so here the whole buffered data is flushed
+  assert(last_transaction_boundary_position_in_event_buffer_ ==
+         get_buffered_size());
+
+  // the spill file is mapped into memory and passed to the backend together
+  // with the event buffer in a single call, so that backends that perform a
+  // remote request per call (S3) upload the whole transaction at once rather
+  // than block by block
+  const auto spill_mapping{spill_file_.map()};
+  const auto spilled_data{spill_mapping.get_content()};
+  auto portions{event_buffer_.get_portions()};
+  portions.reserve(std::size(portions) +
+                   (std::size(spilled_data) + spill_portion_size - 1U) /
+                       spill_portion_size);
+  for (std::size_t offset{0U}; offset < std::size(spilled_data);
+       offset += spill_portion_size) {
+    portions.push_back(spilled_data.subspan(
+        offset, std::min(spill_portion_size, std::size(spilled_data) - offset)));
+  }
+  backend_->write_data_portions_to_stream(portions);
+}
+
+[[nodiscard]] bool
+storage::prepare_for_buffering_event_data(std::size_t size) {
+  if (!event_buffer_memory_limit_enabled()) {
+    return false;
+  }
+
+  const auto exceeds_memory_limit{[this, size] {
+    return event_buffer_.size() + size > event_buffer_memory_limit_;
+  }};
+  if (!has_spilled_event_data() && exceeds_memory_limit() &&
+      has_event_data_to_flush()) {
+    // making room by performing an early checkpoint for the complete
+    // transactions present in the event buffer
+    const auto ready_to_flush_position{get_ready_to_flush_position()};
+    flush_event_buffer_internal();
+    last_checkpoint_position_ = ready_to_flush_position;
+    last_checkpoint_timestamp_ = std::chrono::steady_clock::now();
+    checkpoint_postponed_ = false;
+  }
+
+  // once spilling has started, all the remaining events of the transaction
+  // go to the spill file to keep the data in order
+  return has_spilled_event_data() || exceeds_memory_limit();
+}
+
+void storage::buffer_event_data(util::const_byte_span event_data) {
+  if (prepare_for_buffering_event_data(std::size(event_data))) {
+    if (!spill_file_.is_open()) {
+      spill_file_.open(spill_directory_);
+    }
+    spill_file_.append(event_data);
+  } else {
+    event_buffer_.append(event_data);
+  }
+}
+
+void storage::clear_event_buffer() {
+  reserved_event_size_.reset();
+  event_buffer_.clear();
+  if (has_spilled_event_data()) {
+    spill_file_.truncate(0ULL);
+  }
+}
+
+[[nodiscard]] std::chrono::steady_clock::time_point
+storage::get_idle_checkpoint_deadline() const noexcept {
+  auto deadline{std::chrono::steady_clock::time_point::max()};
+  if (idle_checkpoint_error_ || !is_binlog_open() ||
+      !has_event_data_to_flush()) {
+    // nothing can be flushed until new events are received
+    return deadline;
+  }
+  if (interval_checkpointing_enabled()) {
+    deadline = last_checkpoint_timestamp_ + checkpoint_interval_seconds_;
+  }
+  // a checkpoint postponed by the batching window must not wait for the
+  // next event
+  if (checkpoint_postponed_) {
+    deadline = std::min(deadline, last_checkpoint_timestamp_ +
+                                      checkpoint_batching_window_);
+  }
+  return deadline;
+}
+
+void storage::run_checkpoint_timer(const std::stop_token &stoken) {
+  using time_point = std::chrono::steady_clock::time_point;
+  const auto to_ticks{[](const time_point &tp) noexcept {
+    return tp.time_since_epoch().count();
+  }};
+
+  auto wake_time{time_point::max()};
+  std::unique_lock lock{checkpoint_timer_mutex_};
+  while (!stoken.stop_requested()) {
+    // the wake time is published before the idle state is checked, and
+    // 'begin_idle()' publishes the idle state before checking the wake time,
+    // so either this thread sees the new deadline here or 'begin_idle()'
+    // wakes it up
+    checkpoint_timer_wake_time_.store(to_ticks(wake_time));
+    const bool idle{idle_state_.load() == idle_state_type::idle};
+    const time_point deadline{
+        std::chrono::steady_clock::duration{idle_checkpoint_deadline_.load()}};
+    // a deadline published during an earlier idle period can only move
+    // forward, so waking up at it is harmless unless it has already passed
+    if (deadline < wake_time &&
+        (idle || deadline > std::chrono::steady_clock::now())) {
+      wake_time = deadline;
+      continue;
+    }
+
+    const auto wakeup_requested{
+        [this] { return checkpoint_timer_wakeup_requested_; }};
+    if (wake_time == time_point::max()) {
+      checkpoint_timer_wakeup_.wait(lock, stoken, wakeup_requested);
+    } else {
+      checkpoint_timer_wakeup_.wait_until(lock, stoken, wake_time,
+                                          wakeup_requested);
+    }
+    checkpoint_timer_wakeup_requested_ = false;
+    if (stoken.stop_requested() ||
+        std::chrono::steady_clock::now() < wake_time) {
+      // woken up early, the new deadline is picked up above
+      continue;
+    }
+
+    auto expected{idle_state_type::idle};
+    if (!idle_state_.compare_exchange_strong(
+            expected, idle_state_type::checkpointing)) {
+      // the thread receiving binlog events is active and performs due
+      // checkpoints itself, sleeping until it becomes idle again
+      wake_time = time_point::max();
+      continue;
+    }
+    wake_time = perform_idle_checkpoint();
+    idle_checkpoint_deadline_.store(to_ticks(wake_time));
+    idle_state_.store(idle_state_type::idle);
+    idle_state_.notify_all();
+  }
+}
+
+[[nodiscard]] std::chrono::steady_clock::time_point
+storage::perform_idle_checkpoint() {
+  // the state of this object can be accessed here as the thread receiving
+  // binlog events cannot leave the idle state until 'idle_state_' is
+  // switched back from 'checkpointing'
+  const auto now_ts{std::chrono::steady_clock::now()};
+  if (now_ts >= get_idle_checkpoint_deadline()) {
+    try {
+      const auto ready_to_flush_position{get_ready_to_flush_position()};
+      flush_event_buffer_internal();
+      last_checkpoint_position_ = ready_to_flush_position;
+      last_checkpoint_timestamp_ = now_ts;
+      checkpoint_postponed_ = false;
+    } catch (...) {
+      idle_checkpoint_error_ = std::current_exception();
+    }
+  }
+  return get_idle_checkpoint_deadline();
+}
+
+void storage::rethrow_idle_checkpoint_error() const {
+  // no synchronization is needed here as 'idle_checkpoint_error_' is
+  // modified only between 'begin_idle()' and 'end_idle()'
+  if (idle_checkpoint_error_) {
+    std::rethrow_exception(idle_checkpoint_error_);
+  }
+}
+
+void storage::update_current_binlog_record_on_flush() {
+  auto &current_record{get_current_binlog_record()};
+  current_record.size += last_transaction_boundary_position_in_event_buffer_;
+  if (is_in_gtid_replication_mode()) {
+    auto &optional_added_gtids{current_record.added_gtids};
+    if (optional_added_gtids.has_value()) {
+      *optional_added_gtids += gtids_in_event_buffer_;
+    }
+  }
+  current_record.timestamps.add_range(ready_to_flush_timestamps_);
+  current_record.last_sequence_number = ready_to_flush_last_sequence_number_;
+}
+
+[[nodiscard]] gtids::optional_gtid_set
+storage::get_gtids_in_event_buffer() const {
+  if (!is_in_gtid_replication_mode()) {
+    return {};
+  }
+  return gtids_in_event_buffer_;
+}
+
+void storage::wait_for_pending_checkpoints() {
+  if (checkpoint_worker_) {
+    // rethrows the first error that happened in any of the asynchronous
+    // checkpoints
+    checkpoint_worker_->wait();
+  }
+}
+
 void storage::load_binlog_index() {
   const auto index_content{backend_->get_object(default_binlog_index_name)};
   // opening in text mode
@@ -568,18 +1060,34 @@ void storage::validate_binlog_index(
   //       files in the index
 }
 
+[[nodiscard]] std::string
+storage::generate_binlog_index_entry(const binlog_record &record) {
+  std::filesystem::path binlog_path{default_binlog_index_entry_path};
+  binlog_path /= record.name.str();
+  auto result{binlog_path.generic_string()};
+  result += '\n';
+  return result;
+}
+
 void storage::save_binlog_index() const {
-  std::ostringstream oss;
+  std::string content;
   for (const auto &record : binlog_records_) {
-    std::filesystem::path binlog_path{default_binlog_index_entry_path};
-    binlog_path /= record.name.str();
-    oss << binlog_path.generic_string() << '\n';
+    content += generate_binlog_index_entry(record);
   }
-  const auto content{oss.str()};
   backend_->put_object(default_binlog_index_name,
                        util::as_const_byte_span(content));
 }
 
+void storage::append_to_binlog_index(const binlog_record &record) const {
+  // appending is not atomic, so a crash here may leave an incomplete
+  // last line in the binlog index - in this case the storage will be
+  // rejected on the next startup the same way as if the crash happened
+  // before this call (binlog file not referenced in the binlog index)
+  const auto entry{generate_binlog_index_entry(record)};
+  backend_->append_to_object(default_binlog_index_name,
+                             util::as_const_byte_span(entry));
+}
+
 void storage::load_metadata() {
   const auto metadata_content{backend_->get_object(metadata_name)};
   const storage_metadata metadata{metadata_content};
@@ -667,22 +1175,209 @@ void storage::save_binlog_metadata(const binlog_record &record) const {
                        util::as_const_byte_span(content));
 }
 
+[[nodiscard]] std::string storage::generate_binlog_metadata_journal_name(
+    const events::composite_binlog_name &binlog_name) {
+  auto result{binlog_name.str()};
+  result += binlog_metadata_journal_extension;
+  return result;
+}
+
+void storage::apply_binlog_metadata_journal(std::string_view journal_content,
+                                            binlog_record &record) {
+  std::string_view remaining_content{journal_content};
+  auto line_end{remaining_content.find('\n')};
+  // an incomplete last line (without a trailing newline) can only be the
+  // result of an interrupted append - it is ignored the same way as if the
+  // corresponding checkpoint did not happen at all
+  while (line_end != std::string_view::npos) {
+    const auto line{remaining_content.substr(0U, line_end)};
+    remaining_content.remove_prefix(line_end + 1U);
+    line_end = remaining_content.find('\n');
+
+    const binlog_file_metadata_delta delta{line};
+    const auto &delta_root{delta.root()};
+    // entries that are already reflected in the record (e.g. because they
+    // were written before the metadata snapshot the record was loaded from)
+    // are skipped
+    if (delta_root.get<"size">() <= record.size) {
+      continue;
+    }
+    record.size = delta_root.get<"size">();
+    const auto &optional_delta_added_gtids{delta_root.get<"added_gtids">()};
+    if (record.added_gtids.has_value() &&
+        optional_delta_added_gtids.has_value()) {
+      *record.added_gtids += *optional_delta_added_gtids;
+    }
+    record.timestamps = {delta_root.get<"min_timestamp">(),
+                         delta_root.get<"max_timestamp">()};
+    record.last_sequence_number = delta_root.get<"last_sequence_number">();
+  }
+}
+
+void storage::checkpoint_binlog_metadata(
+    const binlog_record &record, const gtids::optional_gtid_set &added_gtids) {
+  if (!metadata_journal_enabled() ||
+      metadata_journal_entries_ >= metadata_journal_snapshot_interval_) {
+    save_binlog_metadata_snapshot(record);
+    return;
+  }
+
+  binlog_file_metadata_delta delta{};
+  auto &delta_root{delta.root()};
+  delta_root.get<"size">() = record.size;
+  delta_root.get<"added_gtids">() = added_gtids;
+  delta_root.get<"min_timestamp">() =
+      util::ctime_timestamp{record.timestamps.get_min_timestamp()};
+  delta_root.get<"max_timestamp">() =
+      util::ctime_timestamp{record.timestamps.get_max_timestamp()};
+  delta_root.get<"last_sequence_number">() = record.last_sequence_number;
+  auto content{delta.str()};
+  content += '\n';
+
+  const auto journal_name{generate_binlog_metadata_journal_name(record.name)};
+  if (metadata_journal_entries_ == 0U) {
+    // this also overwrites a stale journal that may have been left behind if
+    // we crashed right after saving the previous metadata snapshot
+    backend_->put_object(journal_name, util::as_const_byte_span(content));
+  } else {
+    backend_->append_to_object(journal_name,
+                               util::as_const_byte_span(content));
+  }
+  ++metadata_journal_entries_;
+}
+
+void storage::save_binlog_metadata_snapshot(const binlog_record &record) {
+  save_binlog_metadata(record);
+  // the journal is removed only after the snapshot is saved - if we crash
+  // in between, the journal will be replayed on top of the snapshot on the
+  // next startup, which is harmless
+  if (metadata_journal_entries_ != 0U) {
+    backend_->remove_object(generate_binlog_metadata_journal_name(record.name));
+    metadata_journal_entries_ = 0U;
+  }
+}
+
+[[nodiscard]] storage::binlog_record_container storage::load_manifest() const {
+  binlog_record_container result;
+  try {
+    const auto content{backend_->get_object(manifest_name)};
+    const storage_manifest manifest{content};
+    const auto &entries{manifest.root().get<"binlogs">()};
+    result.reserve(std::size(entries));
+    for (const auto &entry : entries) {
+      result.push_back(binlog_record{
+          .name = events::composite_binlog_name::parse(entry.get<"name">()),
+          .size = entry.get<"size">(),
+          .previous_gtids = entry.get<"previous_gtids">(),
+          .added_gtids = entry.get<"added_gtids">(),
+          .timestamps = {entry.get<"min_timestamp">(),
+                         entry.get<"max_timestamp">()},
+          .last_sequence_number = entry.get<"last_sequence_number">()});
+    }
+  } catch (const std::exception &) {
+    // the manifest is merely a cache - if it cannot be loaded, individual
+    // binlog metadata objects will be used instead
+    result.clear();
+  }
+  return result;
+}
+
+void storage::save_manifest() {
+  storage_manifest manifest{};
+  auto &entries{manifest.root().get<"binlogs">()};
+  // the last binlog file may still be appended to, so only the closed ones
+  // are included
+  const auto number_of_closed_binlogs{
+      std::empty(binlog_records_) ? 0U : std::size(binlog_records_) - 1U};
+  entries.reserve(number_of_closed_binlogs);
+  for (const auto &record : std::span{binlog_records_}.first(
+           number_of_closed_binlogs)) {
+    auto &entry{entries.emplace_back()};
+    entry.get<"name">() = record.name.str();
+    entry.get<"size">() = record.size;
+    entry.get<"previous_gtids">() = record.previous_gtids;
+    entry.get<"added_gtids">() = record.added_gtids;
+    entry.get<"min_timestamp">() =
+        util::ctime_timestamp{record.timestamps.get_min_timestamp()};
+    entry.get<"max_timestamp">() =
+        util::ctime_timestamp{record.timestamps.get_max_timestamp()};
+    entry.get<"last_sequence_number">() = record.last_sequence_number;
+  }
+  const auto content{manifest.str()};
+  backend_->put_object(manifest_name, util::as_const_byte_span(content));
+  binlogs_missing_from_manifest_ = 0U;
+}
+
 void storage::load_and_validate_binlog_metadata_set(
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
     const storage_object_name_container &object_names,
-    const storage_object_name_container &object_metadata_names) {
+    const storage_object_name_container &object_metadata_names,
+    const storage_object_name_container &object_metadata_journal_names,
+    binlog_record_container &&manifest_records) {
+  std::unordered_map<std::string, std::size_t> manifest_record_index;
+  manifest_record_index.reserve(std::size(manifest_records));
+  for (std::size_t index{0U}; index < std::size(manifest_records); ++index) {
+    manifest_record_index.emplace(manifest_records[index].name.str(), index);
+  }
+
+  // at first, metadata for all binlog files is obtained (either from the
+  // manifest or from individual metadata objects) in parallel - neither
+  // 'binlog_records_' nor 'manifest_records' change their size here, and
+  // every item handler touches only its own elements
+  struct loaded_binlog_metadata_type {
+    binlog_record record{};
+    bool missing_from_manifest{false};
+    bool has_journal{false};
+    std::exception_ptr error{};
+  };
+  std::vector<loaded_binlog_metadata_type> loaded_binlog_metadata_set(
+      std::size(binlog_records_));
+  // the pool is needed only while the storage is being opened
+  util::thread_pool metadata_load_pool{
+      std::min(std::size_t{metadata_load_concurrency_},
+               std::size(binlog_records_))};
+  metadata_load_pool.parallel_for(
+      std::size(binlog_records_), [&](std::size_t index) {
+        const auto &binlog_name{binlog_records_[index].name};
+        auto &loaded_binlog_metadata{loaded_binlog_metadata_set[index]};
+        try {
+          const auto binlog_metadata_name{
+              generate_binlog_metadata_name(binlog_name)};
+          if (!object_metadata_names.contains(binlog_metadata_name)) {
+            util::exception_location().raise<std::logic_error>(
+                "missing metadata for a binlog listed in the binlog index");
+          }
+          const auto manifest_record_it{
+              manifest_record_index.find(binlog_name.str())};
+          if (manifest_record_it != std::cend(manifest_record_index)) {
+            loaded_binlog_metadata.record =
+                std::move(manifest_records[manifest_record_it->second]);
+          } else {
+            loaded_binlog_metadata.record = load_binlog_metadata(binlog_name);
+            loaded_binlog_metadata.missing_from_manifest = true;
+          }
+          const auto binlog_metadata_journal_name{
+              generate_binlog_metadata_journal_name(binlog_name)};
+          if (object_metadata_journal_names.contains(
+                  binlog_metadata_journal_name)) {
+            apply_binlog_metadata_journal(
+                backend_->get_object(binlog_metadata_journal_name),
+                loaded_binlog_metadata.record);
+            loaded_binlog_metadata.has_journal = true;
+          }
+        } catch (const std::exception &) {
+          loaded_binlog_metadata.error = std::current_exception();
+        }
+      });
+
+  // then, the results are validated sequentially in the binlog index order
+  std::uint32_t binlogs_missing_from_manifest{0U};
+  std::size_t binlogs_with_journal{0U};
+  auto loaded_binlog_metadata_it{std::begin(loaded_binlog_metadata_set)};
   auto record_it{std::begin(binlog_records_)};
   while (record_it != std::end(binlog_records_)) {
-    storage::binlog_record loaded_binlog_metadata{};
-    try {
-      const auto binlog_metadata_name{
-          generate_binlog_metadata_name(record_it->name)};
-      if (!object_metadata_names.contains(binlog_metadata_name)) {
-        util::exception_location().raise<std::logic_error>(
-            "missing metadata for a binlog listed in the binlog index");
-      }
-      loaded_binlog_metadata = load_binlog_metadata(record_it->name);
-    } catch (const std::exception &) {
+    auto &loaded_binlog_metadata{*loaded_binlog_metadata_it++};
+    if (loaded_binlog_metadata.error) {
       if (construction_mode_ == storage_construction_mode_type::querying_only) {
         // in the querying_only mode we just skip invalid metadata and the
         // corresponding binlog file - this allows to query an otherwise
@@ -691,31 +1386,53 @@ void storage::load_and_validate_binlog_metadata_set(
         record_it = binlog_records_.erase(record_it);
         continue;
       }
-      throw;
+      std::rethrow_exception(loaded_binlog_metadata.error);
+    }
+    if (loaded_binlog_metadata.missing_from_manifest) {
+      ++binlogs_missing_from_manifest;
     }
-    validate_binlog_metadata(loaded_binlog_metadata);
+    validate_binlog_metadata(loaded_binlog_metadata.record);
     // validating binlog size from the metadata only makes sense if we are not
     // in the querying_only mode
     if (construction_mode_ != storage_construction_mode_type::querying_only) {
       // validating that the size stored in the metadata matches the actual size
-      if (loaded_binlog_metadata.size !=
+      if (loaded_binlog_metadata.record.size !=
           object_names.at(record_it->name.str())) {
         util::exception_location().raise<std::logic_error>(
             "size from the binlog metadata does not match the actual binlog "
             "size");
       }
     }
-    *record_it = std::move(loaded_binlog_metadata);
+    if (loaded_binlog_metadata.has_journal) {
+      ++binlogs_with_journal;
+      // in the modes that are allowed to modify the storage, the journal is
+      // folded into a regular metadata object right away
+      if (construction_mode_ != storage_construction_mode_type::querying_only) {
+        save_binlog_metadata(loaded_binlog_metadata.record);
+        backend_->remove_object(
+            generate_binlog_metadata_journal_name(record_it->name));
+      }
+    }
+    *record_it = std::move(loaded_binlog_metadata.record);
     ++record_it;
   }
   // after this loop position_ and gtids_ should store the values from the last
   // binlog file metadata
 
+  // the last binlog file is never included in the manifest
+  if (binlogs_missing_from_manifest != 0U) {
+    binlogs_missing_from_manifest_ = binlogs_missing_from_manifest - 1U;
+  }
+
   if (construction_mode_ != storage_construction_mode_type::querying_only) {
     if (std::size(object_metadata_names) != std::size(binlog_records_)) {
       util::exception_location().raise<std::logic_error>(
           "found metadata for a non-existing binlog");
     }
+    if (std::size(object_metadata_journal_names) != binlogs_with_journal) {
+      util::exception_location().raise<std::logic_error>(
+          "found metadata journal for a non-existing binlog");
+    }
   }
 
   // if we are in GTID replication mode, then we can consider GTIDs from the
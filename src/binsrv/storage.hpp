@@ -18,9 +18,20 @@
 
 #include "binsrv/storage_fwd.hpp" // IWYU pragma: export
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -35,9 +46,12 @@
 
 #include "binsrv/events/common_types.hpp"
 
+#include "util/background_worker_fwd.hpp"
 #include "util/byte_span_fwd.hpp"
+#include "util/chunked_byte_buffer.hpp"
 #include "util/ctime_timestamp_fwd.hpp"
 #include "util/ctime_timestamp_range.hpp"
+#include "util/native_file_operations_helpers.hpp"
 
 namespace binsrv {
 
@@ -64,9 +78,22 @@ public:
   static constexpr std::string_view default_binlog_index_name{"binlog.index"};
   static constexpr std::string_view default_binlog_index_entry_path{"."};
   static constexpr std::string_view metadata_name{"metadata.json"};
+  static constexpr std::string_view manifest_name{"binlog.manifest"};
   static constexpr std::string_view binlog_metadata_extension{".json"};
-
-  static constexpr std::size_t default_event_buffer_size_in_bytes{16384U};
+  static constexpr std::string_view binlog_metadata_journal_extension{
+      ".journal"};
+
+  static constexpr std::size_t event_buffer_chunk_size{65536U};
+  // the maximum amount of memory kept allocated by the event buffer between
+  // checkpoints (and between binlog files) - 'checkpoint_size' bytes if
+  // size-based checkpointing is enabled but no more than the max value
+  static constexpr std::size_t default_event_buffer_spare_size{1048576U};
+  static constexpr std::size_t max_event_buffer_spare_size{67108864U};
+  // the size of the portions into which the memory-mapped spilled event data
+  // is split when it is passed to the storage backend (backends that copy
+  // the data they are given, like the mirrored one, do it portion by portion)
+  static constexpr std::size_t spill_portion_size{1048576U};
+  static constexpr std::uint32_t default_metadata_load_concurrency{8U};
 
   // passing by value as we are going to move from this unique_ptr
   storage(const storage_config &config,
@@ -88,6 +115,9 @@ public:
   void set_purged_gtids(const gtids::gtid_set &purged_gtids);
 
   [[nodiscard]] std::string get_backend_description() const;
+  // returns the non-fatal storage backend errors (e.g. a disabled storage
+  // mirror) that happened since the previous call
+  [[nodiscard]] std::vector<std::string> extract_backend_warnings();
 
   [[nodiscard]] replication_mode_type get_replication_mode() const noexcept {
     return replication_mode_;
@@ -107,7 +137,7 @@ public:
                       : get_current_binlog_record().name;
   }
   [[nodiscard]] std::uint64_t get_current_position() const noexcept {
-    return get_flushed_position() + std::size(event_buffer_);
+    return get_flushed_position() + get_buffered_size();
   }
 
   [[nodiscard]] gtids::gtid_set get_gtids() const {
@@ -136,8 +166,27 @@ public:
     return incomplete_transaction_last_sequence_number_;
   }
 
+  // the size binlog files are expected to reach before rotation (known in
+  // the rewrite mode), used for preallocating binlog files when
+  // <storage.preallocate_binlog_files> is enabled
+  void set_expected_binlog_file_size(std::uint64_t size) noexcept {
+    expected_binlog_file_size_ = size;
+  }
+
   [[nodiscard]] bool is_binlog_open() const noexcept;
 
+  // Marks the period during which the caller does not access this object
+  // (e.g. while waiting for the next event from the MySQL server). When
+  // interval-based checkpointing or checkpoint batching is enabled, a
+  // checkpoint that becomes due (or whose batching window expires) during
+  // such a period is performed by the checkpoint timer thread, so
+  // that completed transactions do not stay in the event buffer while the
+  // source is idle. 'end_idle()' waits for such a checkpoint to finish. An
+  // error that happened during it is rethrown from the next call that
+  // modifies the storage.
+  void begin_idle();
+  void end_idle() noexcept;
+
   [[nodiscard]] open_binlog_status
   open_binlog(const events::composite_binlog_name &binlog_name);
   void write_event(util::const_byte_span event_data,
@@ -145,6 +194,18 @@ public:
                    const gtids::gtid &transaction_gtid,
                    const util::ctime_timestamp &event_timestamp,
                    events::seq_no_t transaction_sequence_number);
+  // The same as 'write_event()', but without an intermediate copy of the
+  // event data: 'reserve_event()' returns space for an event of 'size' bytes
+  // at the end of the event buffer, which the caller fills in place (e.g. by
+  // rewriting a received event directly into it), and then 'commit_event()'
+  // appends it or 'cancel_reserved_event()' discards it. No other modifying
+  // methods may be called in between, otherwise the reservation is lost.
+  [[nodiscard]] util::byte_span reserve_event(std::size_t size);
+  void commit_event(bool at_transaction_boundary,
+                    const gtids::gtid &transaction_gtid,
+                    const util::ctime_timestamp &event_timestamp,
+                    events::seq_no_t transaction_sequence_number);
+  void cancel_reserved_event() noexcept;
   void close_binlog();
 
   void discard_incomplete_transaction_events();
@@ -178,6 +239,10 @@ private:
   events::composite_binlog_name binlog_name_sentinel_{};
   gtids::gtid_set purged_gtids_{};
   binlog_record_container binlog_records_{};
+  // mirrors the stream state of the backend but, unlike the latter, is never
+  // accessed by the checkpoint worker thread, so it can be checked while
+  // an asynchronous checkpoint is writing to the backend
+  bool binlog_open_{false};
 
   std::uint64_t checkpoint_size_bytes_{0ULL};
   std::uint64_t last_checkpoint_position_{0ULL};
@@ -185,8 +250,42 @@ private:
   std::chrono::steady_clock::duration checkpoint_interval_seconds_{};
   std::chrono::steady_clock::time_point last_checkpoint_timestamp_{};
 
-  using event_buffer_type = std::vector<std::byte>;
-  event_buffer_type event_buffer_{};
+  std::chrono::steady_clock::duration checkpoint_batching_window_{};
+  // set when a due checkpoint has been postponed because of the batching
+  // window
+  bool checkpoint_postponed_{false};
+
+  std::uint32_t manifest_update_rotations_{0U};
+  // the number of closed binlog files whose metadata is not yet included
+  // in the manifest
+  std::uint32_t binlogs_missing_from_manifest_{0U};
+
+  std::uint32_t metadata_load_concurrency_{default_metadata_load_concurrency};
+
+  std::uint32_t metadata_journal_snapshot_interval_{0U};
+  // the number of entries in the metadata journal of the current binlog file
+  // (accessed from the checkpoint worker thread when asynchronous
+  // checkpointing is enabled)
+  std::uint32_t metadata_journal_entries_{0U};
+
+  bool preallocate_binlog_files_{false};
+  std::uint64_t expected_binlog_file_size_{0ULL};
+
+  util::chunked_byte_buffer event_buffer_{};
+  // when 'event_buffer_memory_limit_' is set, events of an incomplete
+  // transaction that do not fit into the limit are appended to this unnamed
+  // local file instead of 'event_buffer_' - the spilled data always follows
+  // the data in 'event_buffer_' and belongs to the last (incomplete)
+  // transaction
+  std::uint64_t event_buffer_memory_limit_{0ULL};
+  std::filesystem::path spill_directory_{};
+  util::native_temporary_file spill_file_{};
+  // the size of the event reserved by 'reserve_event()' and whether it is
+  // going to be spilled (in which case it is reserved in
+  // 'reserved_spilled_event_' rather than in 'event_buffer_')
+  std::optional<std::size_t> reserved_event_size_{};
+  bool reserved_event_spilled_{false};
+  std::vector<std::byte> reserved_spilled_event_{};
   std::size_t last_transaction_boundary_position_in_event_buffer_{};
   gtids::gtid_set gtids_in_event_buffer_{};
   util::ctime_timestamp_range ready_to_flush_timestamps_{};
@@ -194,6 +293,36 @@ private:
   events::seq_no_t ready_to_flush_last_sequence_number_{0ULL};
   events::seq_no_t incomplete_transaction_last_sequence_number_{0ULL};
 
+  // when asynchronous checkpointing is enabled, all event data writes to
+  // the backend stream (followed by the corresponding binlog metadata
+  // updates) are performed on this worker thread, so that the thread
+  // receiving binlog events does not wait for them; must be declared after
+  // 'backend_' as pending tasks refer to it
+  using checkpoint_worker_ptr = std::unique_ptr<util::background_worker>;
+  checkpoint_worker_ptr checkpoint_worker_{};
+
+  // the thread receiving binlog events switches 'idle_state_' between
+  // 'active' and 'idle' without any locking; the checkpoint timer thread may
+  // access the state of this object only after switching it from 'idle' to
+  // 'checkpointing'
+  enum class idle_state_type : std::uint8_t { active, idle, checkpointing };
+  std::atomic<idle_state_type> idle_state_{idle_state_type::active};
+  // the time point (in 'steady_clock' ticks) at which an idle checkpoint
+  // becomes due, published by 'begin_idle()'
+  std::atomic<std::chrono::steady_clock::rep> idle_checkpoint_deadline_{};
+  // the time point (in 'steady_clock' ticks) the checkpoint timer thread is
+  // going to sleep until, so that 'begin_idle()' wakes it up only when an
+  // earlier checkpoint becomes due
+  std::atomic<std::chrono::steady_clock::rep> checkpoint_timer_wake_time_{};
+  // used only for putting the checkpoint timer thread to sleep and for
+  // waking it up
+  std::mutex checkpoint_timer_mutex_{};
+  std::condition_variable_any checkpoint_timer_wakeup_{};
+  bool checkpoint_timer_wakeup_requested_{false};
+  std::exception_ptr idle_checkpoint_error_{};
+  // must be declared after all the members it refers to
+  std::jthread checkpoint_timer_{};
+
   void ensure_streaming_mode() const;
   void ensure_purging_mode() const;
 
@@ -213,8 +342,39 @@ private:
     return checkpoint_interval_seconds_ !=
            std::chrono::steady_clock::duration{};
   }
+  [[nodiscard]] bool checkpoint_batching_enabled() const noexcept {
+    return checkpoint_batching_window_ != std::chrono::steady_clock::duration{};
+  }
   void update_last_checkpoint_info();
 
+  [[nodiscard]] bool manifest_enabled() const noexcept {
+    return manifest_update_rotations_ != 0U;
+  }
+
+  [[nodiscard]] bool metadata_journal_enabled() const noexcept {
+    return metadata_journal_snapshot_interval_ != 0U;
+  }
+
+  [[nodiscard]] bool event_buffer_memory_limit_enabled() const noexcept {
+    return event_buffer_memory_limit_ != 0ULL;
+  }
+  [[nodiscard]] bool has_spilled_event_data() const noexcept {
+    return spill_file_.get_size() != 0ULL;
+  }
+  [[nodiscard]] std::uint64_t get_buffered_size() const noexcept {
+    return event_buffer_.size() + spill_file_.get_size();
+  }
+  // performs an early checkpoint if needed to keep the event buffer within
+  // the memory limit and returns true if the next 'size' bytes of event data
+  // must go to the spill file
+  [[nodiscard]] bool prepare_for_buffering_event_data(std::size_t size);
+  void buffer_event_data(util::const_byte_span event_data);
+  void register_buffered_event(bool at_transaction_boundary,
+                               const gtids::gtid &transaction_gtid,
+                               const util::ctime_timestamp &event_timestamp,
+                               events::seq_no_t transaction_sequence_number);
+  void clear_event_buffer();
+
   [[nodiscard]] bool has_event_data_to_flush() const noexcept {
     return last_transaction_boundary_position_in_event_buffer_ != 0ULL;
   }
@@ -231,11 +391,24 @@ private:
   open_existing_binlog_file_internal(std::uint64_t open_stream_offset);
 
   void flush_event_buffer_internal();
+  [[nodiscard]] std::chrono::steady_clock::time_point
+  get_idle_checkpoint_deadline() const noexcept;
+  void run_checkpoint_timer(const std::stop_token &stoken);
+  [[nodiscard]] std::chrono::steady_clock::time_point
+  perform_idle_checkpoint();
+  void rethrow_idle_checkpoint_error() const;
+  void write_spilled_event_buffer_internal();
+  void update_current_binlog_record_on_flush();
+  [[nodiscard]] gtids::optional_gtid_set get_gtids_in_event_buffer() const;
+  void wait_for_pending_checkpoints();
 
   void load_binlog_index();
   void validate_binlog_index(
       const storage_object_name_container &object_names) const;
+  [[nodiscard]] static std::string
+  generate_binlog_index_entry(const binlog_record &record);
   void save_binlog_index() const;
+  void append_to_binlog_index(const binlog_record &record) const;
 
   void load_metadata();
   void validate_metadata(replication_mode_type replication_mode) const;
@@ -248,9 +421,23 @@ private:
   void validate_binlog_metadata(const binlog_record &record) const;
   void save_binlog_metadata(const binlog_record &record) const;
 
+  [[nodiscard]] static std::string generate_binlog_metadata_journal_name(
+      const events::composite_binlog_name &binlog_name);
+  static void
+  apply_binlog_metadata_journal(std::string_view journal_content,
+                                binlog_record &record);
+  void checkpoint_binlog_metadata(const binlog_record &record,
+                                  const gtids::optional_gtid_set &added_gtids);
+  void save_binlog_metadata_snapshot(const binlog_record &record);
+
+  [[nodiscard]] binlog_record_container load_manifest() const;
+  void save_manifest();
+
   void load_and_validate_binlog_metadata_set(
       const storage_object_name_container &object_names,
-      const storage_object_name_container &object_metadata_names);
+      const storage_object_name_container &object_metadata_names,
+      const storage_object_name_container &object_metadata_journal_names,
+      binlog_record_container &&manifest_records);
 };
 
 } // namespace binsrv
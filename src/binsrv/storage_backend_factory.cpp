@@ -17,17 +17,22 @@
 
 #include <cassert>
 #include <memory>
+#include <utility>
 
 #include "binsrv/basic_storage_backend_fwd.hpp"
 #include "binsrv/filesystem_storage_backend.hpp"
+#include "binsrv/io_uring_filesystem_storage_backend.hpp"
+#include "binsrv/mirrored_storage_backend.hpp"
 #include "binsrv/s3_storage_backend.hpp"
 #include "binsrv/storage_backend_type.hpp"
 #include "binsrv/storage_config.hpp"
+#include "binsrv/tiered_storage_backend.hpp"
 
 namespace binsrv {
 
-basic_storage_backend_ptr
-storage_backend_factory::create(const storage_config &config) {
+namespace {
+
+basic_storage_backend_ptr create_standalone(const storage_config &config) {
   const auto storage_backend = config.get<"backend">();
 
   switch (storage_backend) {
@@ -35,10 +40,27 @@ storage_backend_factory::create(const storage_config &config) {
     return std::make_unique<filesystem_storage_backend>(config);
   case storage_backend_type::s3:
     return std::make_unique<s3_storage_backend>(config);
+  case storage_backend_type::io_uring:
+    return std::make_unique<io_uring_filesystem_storage_backend>(config);
+  case storage_backend_type::tiered:
+    return std::make_unique<tiered_storage_backend>(config);
   default:
     assert(false);
   }
   return {}; // should never get here
 }
 
+} // anonymous namespace
+
+basic_storage_backend_ptr
+storage_backend_factory::create(const storage_config &config) {
+  auto primary{create_standalone(config)};
+  const auto &optional_mirrors{config.get<"mirrors">()};
+  if (!optional_mirrors.has_value() || optional_mirrors->empty()) {
+    return primary;
+  }
+  return std::make_unique<mirrored_storage_backend>(std::move(primary),
+                                                    config);
+}
+
 } // namespace binsrv
@@ -31,9 +31,11 @@ namespace binsrv {
 
 // NOLINTBEGIN(cppcoreguidelines-macro-usage)
 // clang-format off
-#define BINSRV_STORAGE_BACKEND_TYPE_X_SEQUENCE() \
-  BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(file),  \
-  BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(s3)
+#define BINSRV_STORAGE_BACKEND_TYPE_X_SEQUENCE()    \
+  BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(file),     \
+  BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(s3),       \
+  BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(io_uring), \
+  BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(tiered)
 // clang-format on
 
 #define BINSRV_STORAGE_BACKEND_TYPE_X_MACRO(X) X
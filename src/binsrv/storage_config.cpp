@@ -15,10 +15,15 @@
 
 #include "binsrv/storage_config.hpp"
 
+#include <stdexcept>
 #include <string>
 
 #include <boost/url/url.hpp>
 
+#include "binsrv/storage_backend_type.hpp"
+
+#include "util/exception_location_helpers.hpp"
+
 namespace binsrv {
 
 [[nodiscard]] std::string storage_config::get_masked_uri() const {
@@ -29,4 +34,49 @@ namespace binsrv {
   return masked_uri.c_str();
 }
 
+void storage_config::validate() const {
+  const auto backend{get<"backend">()};
+  const auto &optional_s3{get<"s3">()};
+  if (optional_s3.has_value()) {
+    // the S3 tier of the tiered storage backend can be tuned as well
+    if (backend != storage_backend_type::s3 &&
+        backend != storage_backend_type::tiered) {
+      util::exception_location().raise<std::invalid_argument>(
+          "error validating storage config: "
+          "s3 section can only be specified for s3 or tiered storage "
+          "backend");
+    }
+
+    optional_s3->validate();
+
+    // the journal must survive restarts, so it cannot be kept in the
+    // auto-created temporary directory removed on exit
+    if (optional_s3->get<"write_ahead_journal">().value_or(false) &&
+        !get<"fs_buffer_directory">().has_value()) {
+      util::exception_location().raise<std::invalid_argument>(
+          "error validating storage config: "
+          "s3 write-ahead journal requires fs_buffer_directory to be "
+          "specified");
+    }
+  }
+
+  const auto &optional_tiered{get<"tiered">()};
+  if (optional_tiered.has_value() != (backend == storage_backend_type::tiered)) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating storage config: "
+        "tiered section must be specified for tiered storage backend and "
+        "only for it");
+  }
+  if (optional_tiered.has_value()) {
+    optional_tiered->validate();
+  }
+
+  const auto &optional_mirrors{get<"mirrors">()};
+  if (optional_mirrors.has_value()) {
+    for (const auto &mirror : *optional_mirrors) {
+      mirror.validate();
+    }
+  }
+}
+
 } // namespace binsrv
@@ -20,8 +20,11 @@
 
 #include <string>
 
+#include "binsrv/s3_storage_config.hpp" // IWYU pragma: export
 #include "binsrv/size_unit.hpp"
 #include "binsrv/storage_backend_type_fwd.hpp"
+#include "binsrv/storage_mirror_config.hpp" // IWYU pragma: export
+#include "binsrv/tiered_storage_config.hpp" // IWYU pragma: export
 #include "binsrv/time_unit.hpp"
 
 #include "util/common_optional_types.hpp"
@@ -36,9 +39,21 @@ struct [[nodiscard]] storage_config
           util::nv<"uri", std::string>,
           util::nv<"fs_buffer_directory", util::optional_string>,
           util::nv<"checkpoint_size", optional_size_unit>,
-          util::nv<"checkpoint_interval", optional_time_unit>
+          util::nv<"checkpoint_interval", optional_time_unit>,
+          util::nv<"checkpoint_batching_window_ms", util::optional_uint32_t>,
+          util::nv<"checkpoint_queue_size", util::optional_uint32_t>,
+          util::nv<"manifest_update_rotations", util::optional_uint32_t>,
+          util::nv<"metadata_load_concurrency", util::optional_uint32_t>,
+          util::nv<"metadata_journal_snapshot_interval", util::optional_uint32_t>,
+          util::nv<"preallocate_binlog_files", util::optional_bool>,
+          util::nv<"event_buffer_memory_limit", optional_size_unit>,
+          util::nv<"s3", optional_s3_storage_config>,
+          util::nv<"tiered", optional_tiered_storage_config>,
+          util::nv<"mirrors", optional_storage_mirror_config_container>
       > {
   [[nodiscard]] std::string get_masked_uri() const;
+
+  void validate() const;
 };
 // clang-format on
 
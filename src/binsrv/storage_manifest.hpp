@@ -0,0 +1,82 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#ifndef BINSRV_STORAGE_MANIFEST_HPP
+#define BINSRV_STORAGE_MANIFEST_HPP
+
+#include "binsrv/storage_manifest_fwd.hpp" // IWYU pragma: export
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binsrv/events/common_types.hpp"
+
+#include "binsrv/gtids/gtid_set.hpp"
+
+#include "util/ctime_timestamp.hpp"
+#include "util/nv_tuple.hpp"
+
+namespace binsrv {
+
+// A consolidated copy of the metadata of all closed binlog files (i.e. the
+// ones that are no longer going to be changed), which allows to load the
+// whole storage state with a single request instead of one request per
+// binlog file. This is merely a cache - entries for binlog files that are
+// not listed in the binlog index are ignored and binlog files that are
+// missing from it are loaded from their individual metadata objects.
+class [[nodiscard]] storage_manifest {
+public:
+  using entry_type = util::nv_tuple<
+      // clang-format off
+      util::nv<"name", std::string>,
+      util::nv<"size", std::uint64_t>,
+      util::nv<"previous_gtids", gtids::optional_gtid_set>,
+      util::nv<"added_gtids", gtids::optional_gtid_set>,
+      util::nv<"min_timestamp", util::ctime_timestamp>,
+      util::nv<"max_timestamp", util::ctime_timestamp>,
+      util::nv<"last_sequence_number", events::seq_no_t>
+      // clang-format on
+      >;
+  using entry_container = std::vector<entry_type>;
+
+private:
+  using impl_type = util::nv_tuple<
+      // clang-format off
+      util::nv<"version", std::uint32_t>,
+      util::nv<"binlogs", entry_container>
+      // clang-format on
+      >;
+
+public:
+  storage_manifest();
+
+  explicit storage_manifest(std::string_view data);
+
+  [[nodiscard]] std::string str() const;
+
+  [[nodiscard]] auto &root() noexcept { return impl_; }
+  [[nodiscard]] const auto &root() const noexcept { return impl_; }
+
+private:
+  impl_type impl_;
+
+  void validate() const;
+};
+
+} // namespace binsrv
+
+#endif // BINSRV_STORAGE_MANIFEST_HPP
@@ -0,0 +1,71 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include "binsrv/storage_mirror_config.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <boost/url/url.hpp>
+
+#include "binsrv/storage_backend_type.hpp"
+
+#include "util/exception_location_helpers.hpp"
+
+namespace binsrv {
+
+[[nodiscard]] std::string storage_mirror_config::get_masked_uri() const {
+  boost::urls::url masked_uri{get<"uri">()};
+  if (masked_uri.has_userinfo()) {
+    masked_uri.set_userinfo("***:***");
+  }
+  return masked_uri.c_str();
+}
+
+void storage_mirror_config::validate() const {
+  const auto backend{get<"backend">()};
+  // a tiered mirror would need its own tiered section, and a mirror is
+  // already a copy of the main storage
+  if (backend == storage_backend_type::tiered) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating storage mirror config: "
+        "mirror cannot use tiered storage backend");
+  }
+  if (get<"queue_size">().value_or(1U) == 0U) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating storage mirror config: "
+        "queue size must be greater than zero");
+  }
+
+  const auto &optional_s3{get<"s3">()};
+  if (optional_s3.has_value()) {
+    if (backend != storage_backend_type::s3) {
+      util::exception_location().raise<std::invalid_argument>(
+          "error validating storage mirror config: "
+          "s3 section can only be specified for s3 storage backend");
+    }
+    optional_s3->validate();
+    // mirrors are replicated asynchronously anyway, and their journals
+    // would share the filesystem buffer directory with the main backend
+    if (optional_s3->get<"write_ahead_journal">().value_or(false)) {
+      util::exception_location().raise<std::invalid_argument>(
+          "error validating storage mirror config: "
+          "s3 write-ahead journal cannot be enabled for a mirror");
+    }
+  }
+}
+
+} // namespace binsrv
@@ -0,0 +1,55 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#ifndef BINSRV_STORAGE_MIRROR_CONFIG_HPP
+#define BINSRV_STORAGE_MIRROR_CONFIG_HPP
+
+#include "binsrv/storage_mirror_config_fwd.hpp" // IWYU pragma: export
+
+#include <string>
+
+#include "binsrv/s3_storage_config.hpp"
+#include "binsrv/storage_backend_type_fwd.hpp"
+
+#include "util/common_optional_types.hpp"
+#include "util/nv_tuple.hpp"
+
+namespace binsrv {
+
+// Parameters of an additional storage backend every change made to the
+// main storage backend is replicated to. 'backend', 'uri' and 's3' have the
+// same meaning as in the main storage config, 'queue_size' limits the number
+// of operations waiting to be replicated to this particular backend,
+// 'required' makes an error in this backend fatal (by default, the mirror is
+// disabled until the next start instead).
+// clang-format off
+struct [[nodiscard]] storage_mirror_config
+    : util::nv_tuple<
+          util::nv<"backend", storage_backend_type>,
+          util::nv<"uri", std::string>,
+          util::nv<"queue_size", util::optional_uint32_t>,
+          util::nv<"required", util::optional_bool>,
+          util::nv<"s3", optional_s3_storage_config>
+      > {
+  [[nodiscard]] std::string get_masked_uri() const;
+
+  void validate() const;
+};
+// clang-format on
+
+} // namespace binsrv
+
+#endif // BINSRV_STORAGE_MIRROR_CONFIG_HPP
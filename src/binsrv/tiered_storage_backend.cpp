@@ -0,0 +1,563 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include "binsrv/tiered_storage_backend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <boost/scope/scope_exit.hpp>
+#include <boost/scope/scope_fail.hpp>
+
+#include "binsrv/basic_storage_backend_fwd.hpp"
+#include "binsrv/filesystem_storage_backend.hpp"
+#include "binsrv/s3_storage_backend.hpp"
+#include "binsrv/storage_config.hpp"
+#include "binsrv/tiered_storage_config.hpp"
+
+#include "util/background_worker.hpp"
+#include "util/byte_span_fwd.hpp"
+#include "util/exception_location_helpers.hpp"
+#include "util/native_file_operations_helpers.hpp"
+
+namespace binsrv {
+
+namespace {
+
+// the same suffix 'filesystem_storage_backend' uses for its temporary files
+// (such files are never listed as objects)
+constexpr std::string_view restored_object_suffix{".tmp"};
+
+[[nodiscard]] const tiered_storage_config &
+get_tiered_config(const storage_config &config) {
+  const auto &optional_tiered_config{config.get<"tiered">()};
+  if (!optional_tiered_config.has_value()) {
+    util::exception_location().raise<std::invalid_argument>(
+        "tiered storage backend requires tiered section in storage config");
+  }
+  return *optional_tiered_config;
+}
+
+[[nodiscard]] basic_storage_backend_ptr
+create_cold_backend(const storage_config &config) {
+  // the cold tier is configured exactly as a standalone S3 storage backend,
+  // except for its URI
+  auto cold_config{config};
+  cold_config.get<"uri">() = get_tiered_config(config).get<"cold_uri">();
+  return std::make_unique<s3_storage_backend>(cold_config);
+}
+
+} // anonymous namespace
+
+tiered_storage_backend::tiered_storage_backend(const storage_config &config)
+    : tiered_storage_backend{config, create_cold_backend(config)} {}
+
+tiered_storage_backend::tiered_storage_backend(const storage_config &config,
+                                               basic_storage_backend_ptr cold)
+    : hot_{std::make_unique<filesystem_storage_backend>(config)},
+      cold_{std::move(cold)} {
+  const auto &tiered_config{get_tiered_config(config)};
+
+  const auto &optional_max_local_size{tiered_config.get<"max_local_size">()};
+  if (optional_max_local_size.has_value()) {
+    max_hot_size_ = optional_max_local_size->get_value();
+  }
+  const auto &optional_max_local_age{tiered_config.get<"max_local_age">()};
+  if (optional_max_local_age.has_value()) {
+    max_hot_age_seconds_ = optional_max_local_age->get_value();
+  }
+
+  cold_objects_ = cold_->list_objects();
+  migration_worker_ =
+      std::make_unique<util::background_worker>(max_pending_migrations);
+}
+
+tiered_storage_backend::~tiered_storage_backend() {
+  // bugprone-empty-catch should not be that strict in destructors
+  try {
+    // waiting for the pending migrations before destroying the tiers (the
+    // objects not migrated because of an error are migrated on the next run)
+    migration_worker_.reset();
+  } catch (...) { // NOLINT(bugprone-empty-catch)
+  }
+}
+
+void tiered_storage_backend::do_prepare_for_streaming() {
+  hot_->prepare_for_streaming();
+
+  // the objects modified in the hot tier after their last migration (e.g.
+  // when the previous run terminated before the migration was finished);
+  // this is never done by the storages opened for querying, as they may
+  // share the tiers with a running streaming process
+  for (const auto &[name, size] : hot_->list_objects()) {
+    const auto cold_it{cold_objects_.find(name)};
+    if (cold_it == std::end(cold_objects_) || cold_it->second != size) {
+      bool submit_needed{false};
+      {
+        const std::lock_guard lock{state_mutex_};
+        submit_needed = mark_for_migration(name);
+      }
+      if (submit_needed) {
+        submit_migration(name);
+      }
+    }
+  }
+  // applying the eviction policy to the objects left by the previous run
+  migration_worker_->submit([this] { run_eviction_task(); });
+}
+
+[[nodiscard]] storage_object_name_container
+tiered_storage_backend::do_list_objects() {
+  auto result{hot_->list_objects()};
+  const std::lock_guard lock{state_mutex_};
+  // hot copies (if any) are always at least as recent as the cold ones
+  for (const auto &[name, size] : cold_objects_) {
+    result.emplace(name, size);
+  }
+  return result;
+}
+
+[[nodiscard]] std::string
+tiered_storage_backend::do_get_object(std::string_view name) {
+  // this method may be called from several threads simultaneously, so no
+  // shared state is modified here
+  if (has_hot_copy(name)) {
+    try {
+      return hot_->get_object(name);
+    } catch (...) {
+      // the hot copy may have been evicted in the meantime
+      if (has_hot_copy(name)) {
+        throw;
+      }
+    }
+  }
+  return cold_->get_object(name);
+}
+
+void tiered_storage_backend::do_put_object(std::string_view name,
+                                           util::const_byte_span content) {
+  reserve_hot_copy(name);
+  const boost::scope::scope_exit hot_copy_guard{
+      [this, name]() noexcept { release_hot_copy(name); }};
+  hot_->put_object(name, content);
+  bool submit_needed{false};
+  {
+    const std::lock_guard lock{state_mutex_};
+    submit_needed = mark_for_migration(name);
+  }
+  if (submit_needed) {
+    submit_migration(std::string{name});
+  }
+}
+
+void tiered_storage_backend::do_append_to_object(
+    std::string_view name, util::const_byte_span content) {
+  reserve_hot_copy(name);
+  const boost::scope::scope_exit hot_copy_guard{
+      [this, name]() noexcept { release_hot_copy(name); }};
+  restore_hot_copy_if_evicted(name);
+  hot_->append_to_object(name, content);
+  bool submit_needed{false};
+  {
+    const std::lock_guard lock{state_mutex_};
+    submit_needed = mark_for_migration(name);
+  }
+  if (submit_needed) {
+    submit_migration(std::string{name});
+  }
+}
+
+void tiered_storage_backend::do_remove_object(std::string_view name) {
+  const std::array<std::string, 1U> names{std::string{name}};
+  do_remove_objects(names);
+}
+
+void tiered_storage_backend::do_remove_objects(
+    std::span<const std::string> names) {
+  // no migration can be in progress while the cold tier lock is held, so an
+  // object removed here cannot be re-uploaded to the cold tier afterwards
+  const std::lock_guard cold_lock{cold_mutex_};
+  std::vector<std::string> hot_names;
+  std::vector<std::string> cold_names;
+  {
+    const std::lock_guard lock{state_mutex_};
+    for (const auto &name : names) {
+      pending_migrations_.erase(name);
+      failed_migrations_.erase(name);
+      if (has_hot_copy(name)) {
+        hot_names.push_back(name);
+      }
+      if (cold_objects_.contains(name)) {
+        cold_names.push_back(name);
+      }
+    }
+  }
+
+  // best-effort in both tiers, the first failure is re-raised at the end
+  std::exception_ptr first_error;
+  if (!hot_names.empty()) {
+    try {
+      hot_->remove_objects(hot_names);
+    } catch (...) {
+      first_error = std::current_exception();
+    }
+  }
+  if (!cold_names.empty()) {
+    try {
+      cold_->remove_objects(cold_names);
+    } catch (...) {
+      if (!first_error) {
+        first_error = std::current_exception();
+      }
+    }
+    // a failed removal leaves the object in the cold tier in an unknown
+    // state, it is forgotten anyway so that it is not served as a valid one
+    const std::lock_guard lock{state_mutex_};
+    for (const auto &name : cold_names) {
+      cold_objects_.erase(name);
+    }
+  }
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+}
+
+void tiered_storage_backend::do_fsync() {
+  // intentional no-op: every operation performed on the tiers in
+  // 'do_remove_object()' / 'do_remove_objects()' already includes their own
+  // durability barriers
+}
+
+[[nodiscard]] std::uint64_t
+tiered_storage_backend::do_open_stream(std::string_view name,
+                                       storage_backend_open_stream_mode mode) {
+  {
+    std::unique_lock lock{state_mutex_};
+    // the hot copy of the object must not be modified while it is being
+    // uploaded to the cold tier or evicted (once it becomes the stream, it
+    // is never evicted)
+    object_released_.wait(lock, [this, name] {
+      return migrating_name_ != name && !reserved_hot_copies_.contains(name);
+    });
+    stream_name_ = name;
+  }
+  const boost::scope::scope_fail stream_name_guard{[this]() noexcept {
+    const std::lock_guard lock{state_mutex_};
+    stream_name_.clear();
+  }};
+  if (mode == storage_backend_open_stream_mode::append) {
+    restore_hot_copy_if_evicted(name);
+  }
+  return hot_->open_stream(name, mode);
+}
+
+void tiered_storage_backend::do_write_data_to_stream(
+    util::const_byte_span data) {
+  hot_->write_data_to_stream(data);
+}
+
+void tiered_storage_backend::do_write_data_portions_to_stream(
+    std::span<const util::const_byte_span> portions) {
+  hot_->write_data_portions_to_stream(portions);
+}
+
+void tiered_storage_backend::do_preallocate_stream(std::uint64_t size) {
+  hot_->preallocate_stream(size);
+}
+
+void tiered_storage_backend::do_sync_stream() { hot_->sync_stream(); }
+
+void tiered_storage_backend::do_close_stream() {
+  hot_->close_stream();
+  std::string name;
+  bool submit_needed{false};
+  {
+    const std::lock_guard lock{state_mutex_};
+    name = std::move(stream_name_);
+    stream_name_.clear();
+    submit_needed = mark_for_migration(name);
+  }
+  if (submit_needed) {
+    submit_migration(std::move(name));
+  }
+}
+
+[[nodiscard]] std::string tiered_storage_backend::do_get_description() const {
+  std::string res{"tiered - hot tier: "};
+  res += hot_->get_description();
+  res += ", cold tier: ";
+  res += cold_->get_description();
+  res += ", max local size: ";
+  res += (max_hot_size_ == 0ULL ? "unlimited" : std::to_string(max_hot_size_));
+  res += ", max local age: ";
+  res += (max_hot_age_seconds_ == 0ULL
+              ? "unlimited"
+              : std::to_string(max_hot_age_seconds_) + "s");
+  return res;
+}
+
+[[nodiscard]] std::string
+tiered_storage_backend::do_get_object_uri(std::string_view name) const {
+  // the URI of the tier the object is currently available in
+  return has_hot_copy(name) ? hot_->get_object_uri(name)
+                            : cold_->get_object_uri(name);
+}
+
+[[nodiscard]] std::filesystem::path
+tiered_storage_backend::get_hot_object_path(std::string_view name) const {
+  auto result{hot_->get_root_path()};
+  result /= name;
+  return result;
+}
+
+[[nodiscard]] bool
+tiered_storage_backend::has_hot_copy(std::string_view name) const {
+  std::error_code exists_ec;
+  return std::filesystem::exists(get_hot_object_path(name), exists_ec);
+}
+
+void tiered_storage_backend::reserve_hot_copy(std::string_view name) {
+  std::unique_lock lock{state_mutex_};
+  object_released_.wait(
+      lock, [this, name] { return !reserved_hot_copies_.contains(name); });
+  reserved_hot_copies_.emplace(name);
+}
+
+void tiered_storage_backend::release_hot_copy(std::string_view name) noexcept {
+  {
+    const std::lock_guard lock{state_mutex_};
+    const auto reserved_it{reserved_hot_copies_.find(name)};
+    if (reserved_it != std::end(reserved_hot_copies_)) {
+      reserved_hot_copies_.erase(reserved_it);
+    }
+  }
+  object_released_.notify_all();
+}
+
+void tiered_storage_backend::restore_hot_copy_if_evicted(
+    std::string_view name) {
+  if (has_hot_copy(name)) {
+    return;
+  }
+  {
+    const std::lock_guard lock{state_mutex_};
+    if (!cold_objects_.contains(name)) {
+      return;
+    }
+  }
+  // downloading into a temporary file first, so that an interrupted restore
+  // never leaves a partial hot copy behind
+  const auto hot_object_path{get_hot_object_path(name)};
+  auto restored_object_path{hot_object_path};
+  restored_object_path += restored_object_suffix;
+  cold_->get_object_into_file(name, restored_object_path);
+  util::fsync(restored_object_path);
+  std::filesystem::rename(restored_object_path, hot_object_path);
+  util::fsync(hot_->get_root_path());
+}
+
+[[nodiscard]] bool
+tiered_storage_backend::mark_for_migration(std::string_view name) {
+  // a newly submitted migration supersedes the failed one (if any)
+  const auto failed_it{failed_migrations_.find(name)};
+  if (failed_it != std::end(failed_migrations_)) {
+    failed_migrations_.erase(failed_it);
+  }
+  return pending_migrations_.emplace(name).second;
+}
+
+void tiered_storage_backend::submit_migration(std::string name) {
+  migration_worker_->submit(
+      [this, name = std::move(name)] { run_migration_task(name); });
+}
+
+void tiered_storage_backend::run_migration_task(
+    const std::string &name) noexcept {
+  // retrying the objects whose previous migrations failed first, so that a
+  // transient cold tier outage does not leave them behind until the next run
+  object_name_set retried_names;
+  {
+    const std::lock_guard lock{state_mutex_};
+    retried_names.swap(failed_migrations_);
+  }
+  for (auto retried_it{std::begin(retried_names)};
+       retried_it != std::end(retried_names); ++retried_it) {
+    if (!try_migrate_object(*retried_it)) {
+      // the cold tier is most probably still unavailable, so the rest of
+      // the objects are not even tried this time
+      const std::lock_guard lock{state_mutex_};
+      for (auto remaining_it{std::next(retried_it)};
+           remaining_it != std::end(retried_names); ++remaining_it) {
+        if (!pending_migrations_.contains(*remaining_it)) {
+          failed_migrations_.insert(*remaining_it);
+        }
+      }
+      break;
+    }
+  }
+  static_cast<void>(try_migrate_object(name));
+  run_eviction_task();
+}
+
+void tiered_storage_backend::run_eviction_task() noexcept {
+  // bugprone-empty-catch should not be that strict here - the eviction
+  // policy is applied again after the next migration
+  try {
+    evict_hot_copies();
+  } catch (...) { // NOLINT(bugprone-empty-catch)
+  }
+}
+
+[[nodiscard]] bool
+tiered_storage_backend::try_migrate_object(const std::string &name) noexcept {
+  try {
+    migrate_object(name);
+    return true;
+  } catch (...) {
+    // the hot copy is kept (its cold copy is not up-to-date, so it is
+    // never evicted) and the migration is retried later unless the object
+    // has been modified (and therefore re-marked) or removed in the meantime
+    const std::lock_guard lock{state_mutex_};
+    if (!pending_migrations_.contains(name) && has_hot_copy(name)) {
+      failed_migrations_.insert(name);
+    }
+  }
+  return false;
+}
+
+void tiered_storage_backend::migrate_object(const std::string &name) {
+  {
+    const std::lock_guard lock{state_mutex_};
+    pending_migrations_.erase(name);
+    // the object is being streamed again - it will be migrated when the
+    // stream is closed
+    if (name == stream_name_) {
+      return;
+    }
+    migrating_name_ = name;
+  }
+  const boost::scope::scope_exit migrating_name_guard{[this]() noexcept {
+    {
+      const std::lock_guard lock{state_mutex_};
+      migrating_name_.clear();
+    }
+    object_released_.notify_all();
+  }};
+
+  {
+    const std::lock_guard cold_lock{cold_mutex_};
+    const auto hot_object_path{get_hot_object_path(name)};
+    std::error_code size_ec;
+    const auto size{std::filesystem::file_size(hot_object_path, size_ec)};
+    if (size_ec) {
+      // the object has been removed in the meantime
+      return;
+    }
+    // if the object is modified while it is being uploaded, it is marked for
+    // migration once again and its cold copy is not considered up-to-date
+    // (its size will not match) until that migration is finished
+    cold_->put_object_from_file(name, hot_object_path);
+    const std::lock_guard lock{state_mutex_};
+    cold_objects_.insert_or_assign(name, size);
+  }
+}
+
+void tiered_storage_backend::evict_hot_copies() {
+  if (max_hot_size_ == 0ULL && max_hot_age_seconds_ == 0ULL) {
+    return;
+  }
+
+  struct eviction_candidate {
+    std::string name;
+    std::uint64_t size;
+    std::filesystem::file_time_type last_write_time;
+  };
+  std::vector<eviction_candidate> candidates;
+  std::uint64_t hot_size{0ULL};
+  for (const auto &[name, size] : hot_->list_objects()) {
+    hot_size += size;
+    std::error_code time_ec;
+    const auto last_write_time{
+        std::filesystem::last_write_time(get_hot_object_path(name), time_ec)};
+    if (!time_ec) {
+      candidates.push_back(
+          {.name = name, .size = size, .last_write_time = last_write_time});
+    }
+  }
+
+  // evicting the least recently modified objects first
+  std::ranges::sort(candidates, {}, &eviction_candidate::last_write_time);
+  const auto now{std::filesystem::file_time_type::clock::now()};
+  const std::chrono::seconds max_age{max_hot_age_seconds_};
+  std::vector<std::string> victims;
+  {
+    // the victims are reserved under the lock, so that they cannot be
+    // modified by other threads until they are removed without holding it
+    const std::lock_guard lock{state_mutex_};
+    for (auto &candidate : candidates) {
+      const bool too_old{max_hot_age_seconds_ != 0ULL &&
+                         now - candidate.last_write_time > max_age};
+      const bool too_large{max_hot_size_ != 0ULL && hot_size > max_hot_size_};
+      if (!too_old && !too_large) {
+        break;
+      }
+      if (candidate.name == stream_name_ ||
+          pending_migrations_.contains(candidate.name) ||
+          reserved_hot_copies_.contains(candidate.name)) {
+        continue;
+      }
+      // the size listed above must still be the size of the up-to-date cold
+      // copy (otherwise the object has been modified in the meantime)
+      const auto cold_it{cold_objects_.find(candidate.name)};
+      if (cold_it == std::end(cold_objects_) ||
+          cold_it->second != candidate.size) {
+        continue;
+      }
+      hot_size -= candidate.size;
+      reserved_hot_copies_.insert(candidate.name);
+      victims.push_back(std::move(candidate.name));
+    }
+  }
+  if (victims.empty()) {
+    return;
+  }
+  const boost::scope::scope_exit victims_guard{[this, &victims]() noexcept {
+    {
+      const std::lock_guard lock{state_mutex_};
+      for (const auto &victim : victims) {
+        reserved_hot_copies_.erase(victim);
+      }
+    }
+    object_released_.notify_all();
+  }};
+  hot_->remove_objects(victims);
+}
+
+} // namespace binsrv
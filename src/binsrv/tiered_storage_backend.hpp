@@ -0,0 +1,153 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#ifndef BINSRV_TIERED_STORAGE_BACKEND_HPP
+#define BINSRV_TIERED_STORAGE_BACKEND_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "binsrv/basic_storage_backend.hpp" // IWYU pragma: export
+#include "binsrv/filesystem_storage_backend.hpp"
+#include "binsrv/storage_config_fwd.hpp"
+
+#include "util/background_worker_fwd.hpp"
+
+namespace binsrv {
+
+// A storage backend composed of a local filesystem (hot) tier and an S3
+// (cold) tier. All writes go to the hot tier. Every object modified via
+// 'put_object()' / 'append_to_object()' and every object closed after
+// streaming is then copied to the cold tier by a background migration
+// worker. Once an object has an up-to-date copy in the cold tier, its local
+// copy may be evicted according to the size / age policy. Reads of evicted
+// objects are served from the cold tier, and evicted objects that need to be
+// modified again are restored into the hot tier first. Removals are applied
+// to both tiers.
+// Migration failures never affect the hot tier operations: an object whose
+// migration failed keeps its hot copy and is retried by the next migration
+// task (or by the next run, which compares the tiers on startup).
+class [[nodiscard]] tiered_storage_backend final
+    : public basic_storage_backend {
+public:
+  static constexpr std::size_t max_pending_migrations{64U};
+
+  explicit tiered_storage_backend(const storage_config &config);
+  // the same as above, but with the given cold tier instead of the S3 one
+  // created from '<storage.tiered.cold_uri>'
+  tiered_storage_backend(const storage_config &config,
+                         basic_storage_backend_ptr cold);
+  tiered_storage_backend(const tiered_storage_backend &) = delete;
+  tiered_storage_backend &operator=(const tiered_storage_backend &) = delete;
+  tiered_storage_backend(tiered_storage_backend &&) = delete;
+  tiered_storage_backend &operator=(tiered_storage_backend &&) = delete;
+  ~tiered_storage_backend() override;
+
+private:
+  using hot_backend_ptr = std::unique_ptr<filesystem_storage_backend>;
+  hot_backend_ptr hot_;
+  basic_storage_backend_ptr cold_;
+  std::uint64_t max_hot_size_{0ULL};
+  std::uint64_t max_hot_age_seconds_{0ULL};
+
+  // serializes modifications of the cold tier made by the migration worker
+  // and by removals, must be locked before 'state_mutex_'
+  std::mutex cold_mutex_{};
+  // protects the members below, which are shared with the migration worker
+  std::mutex state_mutex_{};
+  // notified whenever an object stops being migrated or its hot copy stops
+  // being reserved
+  std::condition_variable object_released_{};
+  // the names and the sizes of the objects in the cold tier
+  storage_object_name_container cold_objects_{};
+  using object_name_set = std::set<std::string, std::less<>>;
+  object_name_set pending_migrations_{};
+  // the objects whose last migration attempt failed
+  object_name_set failed_migrations_{};
+  // the objects whose hot copies are being modified or evicted (such I/O is
+  // performed without holding 'state_mutex_'), see 'reserve_hot_copy()'
+  object_name_set reserved_hot_copies_{};
+  std::string migrating_name_{};
+  std::string stream_name_{};
+
+  // must be declared after all the members the migration tasks refer to
+  using migration_worker_ptr = std::unique_ptr<util::background_worker>;
+  migration_worker_ptr migration_worker_{};
+
+  [[nodiscard]] storage_object_name_container do_list_objects() override;
+
+  [[nodiscard]] std::string do_get_object(std::string_view name) override;
+  void do_put_object(std::string_view name,
+                     util::const_byte_span content) override;
+  void do_append_to_object(std::string_view name,
+                           util::const_byte_span content) override;
+  void do_remove_object(std::string_view name) override;
+  void do_remove_objects(std::span<const std::string> names) override;
+  void do_fsync() override;
+
+  [[nodiscard]] std::uint64_t
+  do_open_stream(std::string_view name,
+                 storage_backend_open_stream_mode mode) override;
+  void do_write_data_to_stream(util::const_byte_span data) override;
+  void do_write_data_portions_to_stream(
+      std::span<const util::const_byte_span> portions) override;
+  void do_preallocate_stream(std::uint64_t size) override;
+  void do_sync_stream() override;
+  void do_close_stream() override;
+
+  void do_prepare_for_streaming() override;
+
+  [[nodiscard]] std::string do_get_description() const override;
+  [[nodiscard]] std::string
+  do_get_object_uri(std::string_view name) const override;
+
+  [[nodiscard]] std::filesystem::path
+  get_hot_object_path(std::string_view name) const;
+  [[nodiscard]] bool has_hot_copy(std::string_view name) const;
+  // waits until no other thread modifies or evicts the hot copy of the
+  // object and reserves it for the calling one
+  void reserve_hot_copy(std::string_view name);
+  void release_hot_copy(std::string_view name) noexcept;
+  // must be called with the hot copy reserved (or with the object being
+  // streamed)
+  void restore_hot_copy_if_evicted(std::string_view name);
+  // must be called with 'state_mutex_' locked, returns true if a new
+  // migration task must be submitted
+  [[nodiscard]] bool mark_for_migration(std::string_view name);
+  void submit_migration(std::string name);
+
+  // migration tasks must never throw, as the first exception escaping from a
+  // task would make every subsequent 'submit()' call (performed on the hot
+  // tier write path) throw as well
+  void run_migration_task(const std::string &name) noexcept;
+  void run_eviction_task() noexcept;
+  [[nodiscard]] bool try_migrate_object(const std::string &name) noexcept;
+  void migrate_object(const std::string &name);
+  void evict_hot_copies();
+};
+
+} // namespace binsrv
+
+#endif // BINSRV_TIERED_STORAGE_BACKEND_HPP
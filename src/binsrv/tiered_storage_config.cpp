@@ -0,0 +1,43 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include "binsrv/tiered_storage_config.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <boost/url/url.hpp>
+
+#include "util/exception_location_helpers.hpp"
+
+namespace binsrv {
+
+[[nodiscard]] std::string tiered_storage_config::get_masked_cold_uri() const {
+  boost::urls::url masked_uri{get<"cold_uri">()};
+  if (masked_uri.has_userinfo()) {
+    masked_uri.set_userinfo("***:***");
+  }
+  return masked_uri.c_str();
+}
+
+void tiered_storage_config::validate() const {
+  if (get<"cold_uri">().empty()) {
+    util::exception_location().raise<std::invalid_argument>(
+        "error validating tiered storage config: cold URI must not be empty");
+  }
+}
+
+} // namespace binsrv
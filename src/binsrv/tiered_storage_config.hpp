@@ -0,0 +1,48 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#ifndef BINSRV_TIERED_STORAGE_CONFIG_HPP
+#define BINSRV_TIERED_STORAGE_CONFIG_HPP
+
+#include "binsrv/tiered_storage_config_fwd.hpp" // IWYU pragma: export
+
+#include <string>
+
+#include "binsrv/size_unit.hpp"
+#include "binsrv/time_unit.hpp"
+
+#include "util/nv_tuple.hpp"
+
+namespace binsrv {
+
+// Parameters of the tiered storage backend: the main storage URI points to
+// the local (hot) tier, 'cold_uri' points to the S3 (cold) tier.
+// clang-format off
+struct [[nodiscard]] tiered_storage_config
+    : util::nv_tuple<
+          util::nv<"cold_uri", std::string>,
+          util::nv<"max_local_size", optional_size_unit>,
+          util::nv<"max_local_age", optional_time_unit>
+      > {
+  [[nodiscard]] std::string get_masked_cold_uri() const;
+
+  void validate() const;
+};
+// clang-format on
+
+} // namespace binsrv
+
+#endif // BINSRV_TIERED_STORAGE_CONFIG_HPP
@@ -0,0 +1,101 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "util/background_worker.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <utility>
+
+#include "util/exception_location_helpers.hpp"
+
+namespace util {
+
+background_worker::background_worker(std::size_t max_pending_tasks)
+    : max_pending_tasks_{max_pending_tasks}, mutex_{}, task_available_{},
+      task_finished_{}, tasks_{}, error_{}, thread_{} {
+  if (max_pending_tasks_ == 0U) {
+    exception_location().raise<std::invalid_argument>(
+        "background worker queue size must be greater than zero");
+  }
+  thread_ = std::jthread{
+      [this](const std::stop_token &stoken) { process_tasks(stoken); }};
+}
+
+background_worker::~background_worker() {
+  {
+    std::unique_lock lock{mutex_};
+    task_finished_.wait(lock, [this] { return tasks_.empty() && !busy_; });
+  }
+  // 'std::jthread' destructor will request stop and join the thread
+}
+
+void background_worker::submit(task_type task) {
+  std::unique_lock lock{mutex_};
+  task_finished_.wait(lock, [this] {
+    return error_ || std::size(tasks_) < max_pending_tasks_;
+  });
+  rethrow_error_if_any();
+  tasks_.push_back(std::move(task));
+  lock.unlock();
+  task_available_.notify_one();
+}
+
+void background_worker::wait() {
+  std::unique_lock lock{mutex_};
+  task_finished_.wait(lock, [this] { return tasks_.empty() && !busy_; });
+  rethrow_error_if_any();
+}
+
+void background_worker::process_tasks(const std::stop_token &stoken) {
+  std::unique_lock lock{mutex_};
+  while (task_available_.wait(lock, stoken,
+                              [this] { return !tasks_.empty(); })) {
+    auto task{std::move(tasks_.front())};
+    tasks_.pop_front();
+    busy_ = true;
+    const bool skip{static_cast<bool>(error_)};
+    lock.unlock();
+
+    std::exception_ptr task_error{};
+    if (!skip) {
+      try {
+        task();
+      } catch (...) {
+        task_error = std::current_exception();
+      }
+    }
+    // releasing resources captured by the task outside of the lock
+    task = nullptr;
+
+    lock.lock();
+    busy_ = false;
+    if (task_error && !error_) {
+      error_ = std::move(task_error);
+    }
+    task_finished_.notify_all();
+  }
+}
+
+void background_worker::rethrow_error_if_any() const {
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+} // namespace util
@@ -0,0 +1,81 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#ifndef UTIL_BACKGROUND_WORKER_HPP
+#define UTIL_BACKGROUND_WORKER_HPP
+
+#include "util/background_worker_fwd.hpp" // IWYU pragma: export
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace util {
+
+// A single background thread executing submitted tasks one by one in
+// submission order. The number of tasks waiting in the queue is bounded -
+// 'submit()' blocks the caller until there is free space in the queue
+// (back-pressure).
+// The first exception thrown from a task is captured and rethrown from every
+// subsequent 'submit()' / 'wait()' call. All tasks submitted after a failure
+// are discarded without being executed.
+// The destructor waits for all pending tasks to be finished.
+class [[nodiscard]] background_worker {
+public:
+  // TODO: change to std::move_only_function when libc++ supports it
+  using task_type = std::function<void()>;
+
+  explicit background_worker(std::size_t max_pending_tasks);
+
+  background_worker(const background_worker &) = delete;
+  background_worker &operator=(const background_worker &) = delete;
+  background_worker(background_worker &&) = delete;
+  background_worker &operator=(background_worker &&) = delete;
+
+  ~background_worker();
+
+  [[nodiscard]] std::size_t get_max_pending_tasks() const noexcept {
+    return max_pending_tasks_;
+  }
+
+  void submit(task_type task);
+  // blocks until all submitted tasks are finished
+  void wait();
+
+private:
+  std::size_t max_pending_tasks_;
+
+  std::mutex mutex_;
+  std::condition_variable_any task_available_;
+  std::condition_variable task_finished_;
+  std::deque<task_type> tasks_;
+  bool busy_{false};
+  std::exception_ptr error_;
+
+  // must be declared last so that the thread is joined before any of the
+  // members above are destroyed
+  std::jthread thread_;
+
+  void process_tasks(const std::stop_token &stoken);
+  void rethrow_error_if_any() const;
+};
+
+} // namespace util
+
+#endif // UTIL_BACKGROUND_WORKER_HPP
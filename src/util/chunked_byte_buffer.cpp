@@ -0,0 +1,259 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "util/chunked_byte_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "util/byte_span_fwd.hpp"
+#include "util/exception_location_helpers.hpp"
+
+namespace util {
+
+chunked_byte_buffer::chunked_byte_buffer(std::size_t chunk_size,
+                                         std::size_t max_spare_size)
+    : chunk_size_{chunk_size},
+      max_spare_chunks_{chunk_size == 0U ? 0U : max_spare_size / chunk_size} {
+  if (chunk_size_ == 0U) {
+    exception_location().raise<std::invalid_argument>(
+        "chunked byte buffer chunk size must be greater than zero");
+  }
+}
+
+void chunked_byte_buffer::append(const_byte_span data) {
+  reset_prepared();
+  while (!data.empty()) {
+    auto tail_used{chunks_.empty() ? chunk_size_ : get_tail_used()};
+    if (tail_used == chunk_size_) {
+      chunks_.push_back(acquire_chunk());
+      tail_used = 0U;
+    }
+    const auto portion_size{
+        std::min(chunk_size_ - tail_used, std::size(data))};
+    std::ranges::copy(data.first(portion_size),
+                      std::next(std::begin(chunks_.back()),
+                                static_cast<std::ptrdiff_t>(tail_used)));
+    size_ += portion_size;
+    data = data.subspan(portion_size);
+  }
+}
+
+[[nodiscard]] byte_span chunked_byte_buffer::prepare(std::size_t length) {
+  reset_prepared();
+  const auto tail_free{chunks_.empty() ? 0U : chunk_size_ - get_tail_used()};
+  byte_span result{};
+  if (tail_free != 0U && length <= tail_free) {
+    result = byte_span{chunks_.back()}.subspan(chunk_size_ - tail_free, length);
+    prepared_location_ = prepared_location_type::last_chunk;
+  } else if (tail_free == 0U && length <= chunk_size_) {
+    if (next_chunk_.empty()) {
+      next_chunk_ = acquire_chunk();
+    }
+    result = byte_span{next_chunk_}.first(length);
+    prepared_location_ = prepared_location_type::next_chunk;
+  } else {
+    // the data would cross a chunk boundary, so it cannot be constructed in
+    // place
+    staging_.resize(length);
+    result = byte_span{staging_};
+    prepared_location_ = prepared_location_type::staging;
+  }
+  prepared_size_ = length;
+  return result;
+}
+
+void chunked_byte_buffer::commit(std::size_t length) {
+  if (prepared_location_ == prepared_location_type::none) {
+    exception_location().raise<std::logic_error>(
+        "no data was prepared in chunked byte buffer");
+  }
+  if (length > prepared_size_) {
+    exception_location().raise<std::out_of_range>(
+        "cannot commit more data than was prepared in chunked byte buffer");
+  }
+  switch (prepared_location_) {
+  case prepared_location_type::last_chunk:
+    size_ += length;
+    break;
+  case prepared_location_type::next_chunk:
+    if (length != 0U) {
+      chunks_.push_back(std::move(next_chunk_));
+      next_chunk_ = chunk_type{};
+      size_ += length;
+    }
+    break;
+  case prepared_location_type::staging:
+    append(const_byte_span{staging_}.first(length));
+    // staging areas larger than a chunk are needed only for large portions
+    // of data and are not kept
+    if (std::size(staging_) > chunk_size_) {
+      staging_ = chunk_type{};
+    }
+    break;
+  default:
+    assert(false);
+  }
+  reset_prepared();
+}
+
+void chunked_byte_buffer::truncate(std::size_t new_size) {
+  reset_prepared();
+  if (new_size > size_) {
+    exception_location().raise<std::out_of_range>(
+        "cannot truncate chunked byte buffer to a larger size");
+  }
+  size_ = new_size;
+  if (size_ == 0U) {
+    release_all_chunks();
+    return;
+  }
+  const auto required_chunks{(head_offset_ + size_ + chunk_size_ - 1U) /
+                             chunk_size_};
+  while (std::size(chunks_) > required_chunks) {
+    release_chunk(std::move(chunks_.back()));
+    chunks_.pop_back();
+  }
+}
+
+void chunked_byte_buffer::consume(std::size_t length) {
+  reset_prepared();
+  if (length > size_) {
+    exception_location().raise<std::out_of_range>(
+        "cannot consume more data than chunked byte buffer contains");
+  }
+  size_ -= length;
+  if (size_ == 0U) {
+    release_all_chunks();
+    return;
+  }
+  head_offset_ += length;
+  while (head_offset_ >= chunk_size_) {
+    release_chunk(std::move(chunks_.front()));
+    chunks_.pop_front();
+    head_offset_ -= chunk_size_;
+  }
+}
+
+[[nodiscard]] chunked_byte_buffer
+chunked_byte_buffer::detach_front(std::size_t length) {
+  reset_prepared();
+  if (length > size_) {
+    exception_location().raise<std::out_of_range>(
+        "cannot detach more data than chunked byte buffer contains");
+  }
+  chunked_byte_buffer result{chunk_size_, 0U};
+  if (length == 0U) {
+    return result;
+  }
+  result.head_offset_ = head_offset_;
+  result.size_ = length;
+  if (length == size_) {
+    // the most common case - all the data is detached and no copying is
+    // needed
+    result.chunks_.swap(chunks_);
+    head_offset_ = 0U;
+    size_ = 0U;
+    return result;
+  }
+
+  const auto end_offset{head_offset_ + length};
+  const auto full_chunks{end_offset / chunk_size_};
+  const auto remainder{end_offset % chunk_size_};
+  const auto full_chunks_end{
+      std::next(std::begin(chunks_), static_cast<std::ptrdiff_t>(full_chunks))};
+  std::move(std::begin(chunks_), full_chunks_end,
+            std::back_inserter(result.chunks_));
+  chunks_.erase(std::begin(chunks_), full_chunks_end);
+  if (remainder != 0U) {
+    // the chunk shared by the detached and the remaining data stays in this
+    // buffer, its detached part is copied
+    auto &partial_chunk{result.chunks_.emplace_back(chunk_size_)};
+    const auto partial_begin{std::begin(chunks_.front())};
+    std::copy(partial_begin,
+              std::next(partial_begin, static_cast<std::ptrdiff_t>(remainder)),
+              std::begin(partial_chunk));
+  }
+  head_offset_ = remainder;
+  size_ -= length;
+  return result;
+}
+
+void chunked_byte_buffer::clear() noexcept {
+  reset_prepared();
+  release_all_chunks();
+}
+
+[[nodiscard]] std::vector<const_byte_span>
+chunked_byte_buffer::get_portions(std::size_t length) const {
+  if (length > size_) {
+    exception_location().raise<std::out_of_range>(
+        "cannot get more data than chunked byte buffer contains");
+  }
+  std::vector<const_byte_span> result;
+  result.reserve((head_offset_ + length + chunk_size_ - 1U) / chunk_size_);
+  std::size_t offset{head_offset_};
+  for (const auto &chunk : chunks_) {
+    if (length == 0U) {
+      break;
+    }
+    const auto portion_size{std::min(chunk_size_ - offset, length)};
+    result.emplace_back(const_byte_span{chunk}.subspan(offset, portion_size));
+    length -= portion_size;
+    offset = 0U;
+  }
+  return result;
+}
+
+[[nodiscard]] chunked_byte_buffer::chunk_type
+chunked_byte_buffer::acquire_chunk() {
+  if (!next_chunk_.empty()) {
+    // a chunk acquired by 'prepare()' but not committed
+    return std::exchange(next_chunk_, chunk_type{});
+  }
+  if (spare_chunks_.empty()) {
+    return chunk_type(chunk_size_);
+  }
+  auto result{std::move(spare_chunks_.back())};
+  spare_chunks_.pop_back();
+  return result;
+}
+
+void chunked_byte_buffer::release_chunk(chunk_type &&chunk) noexcept {
+  if (std::size(spare_chunks_) < max_spare_chunks_) {
+    // deque::push_back may throw only on allocation failure, in which case
+    // the chunk is simply freed
+    try {
+      spare_chunks_.push_back(std::move(chunk));
+    } catch (...) { // NOLINT(bugprone-empty-catch)
+    }
+  }
+}
+
+void chunked_byte_buffer::release_all_chunks() noexcept {
+  while (!chunks_.empty()) {
+    release_chunk(std::move(chunks_.back()));
+    chunks_.pop_back();
+  }
+  head_offset_ = 0U;
+  size_ = 0U;
+}
+
+} // namespace util
@@ -0,0 +1,127 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#ifndef UTIL_CHUNKED_BYTE_BUFFER_HPP
+#define UTIL_CHUNKED_BYTE_BUFFER_HPP
+
+#include "util/chunked_byte_buffer_fwd.hpp" // IWYU pragma: export
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "util/byte_span_fwd.hpp"
+
+namespace util {
+
+// A FIFO byte buffer that stores its content in a sequence of fixed-size
+// chunks. In contrast to a plain 'std::vector<std::byte>', appending data
+// never moves the data already stored in the buffer, and removing data from
+// the front of the buffer ('consume()' / 'detach_front()') does not move the
+// remaining data either. The content is exposed as a list of spans suitable
+// for scatter-gather writes.
+// Chunks that become unused are kept for reuse (up to 'max_spare_size'
+// bytes worth of them), so that a buffer which is repeatedly filled and
+// drained does not allocate memory in the steady state.
+// Data can also be constructed in place at the end of the buffer with a
+// 'prepare()' / 'commit()' pair, which avoids copying it in the common case
+// when it fits into a single chunk.
+class [[nodiscard]] chunked_byte_buffer {
+public:
+  static constexpr std::size_t default_chunk_size{65536U};
+
+  chunked_byte_buffer() : chunked_byte_buffer{default_chunk_size, 0U} {}
+  chunked_byte_buffer(std::size_t chunk_size, std::size_t max_spare_size);
+
+  [[nodiscard]] std::size_t get_chunk_size() const noexcept {
+    return chunk_size_;
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0U; }
+
+  void append(const_byte_span data);
+  // returns a contiguous writable area of 'length' bytes for the data that
+  // is going to be appended next - if the data fits into the free space of
+  // the last chunk (or into a new chunk when the last one is full), the area
+  // is located right there, otherwise it is a separate staging area, which
+  // is copied on 'commit()' (valid until the next modification of the
+  // buffer)
+  [[nodiscard]] byte_span prepare(std::size_t length);
+  // appends the first 'length' bytes of the area returned by the preceding
+  // 'prepare()' call
+  void commit(std::size_t length);
+  // removes the last 'size() - new_size' bytes
+  void truncate(std::size_t new_size);
+  // removes the first 'length' bytes
+  void consume(std::size_t length);
+  // removes the first 'length' bytes and returns them as a separate buffer
+  // (without spare chunks) - whole chunks are moved to the result, at most
+  // one partially consumed chunk is copied
+  [[nodiscard]] chunked_byte_buffer detach_front(std::size_t length);
+  // removes all the data, keeping the chunks for reuse
+  void clear() noexcept;
+
+  // returns the first 'length' bytes of the buffer as a list of spans
+  // (valid until the next modification of the buffer)
+  [[nodiscard]] std::vector<const_byte_span>
+  get_portions(std::size_t length) const;
+  [[nodiscard]] std::vector<const_byte_span> get_portions() const {
+    return get_portions(size_);
+  }
+
+private:
+  using chunk_type = std::vector<std::byte>;
+  using chunk_container = std::deque<chunk_type>;
+
+  std::size_t chunk_size_;
+  std::size_t max_spare_chunks_;
+  chunk_container chunks_{};
+  chunk_container spare_chunks_{};
+  // offset of the first byte of data in 'chunks_.front()'
+  std::size_t head_offset_{0U};
+  std::size_t size_{0U};
+
+  enum class prepared_location_type : std::uint8_t {
+    none,
+    last_chunk,
+    next_chunk,
+    staging
+  };
+  prepared_location_type prepared_location_{prepared_location_type::none};
+  std::size_t prepared_size_{0U};
+  // a chunk acquired by 'prepare()' when the last chunk is full, it becomes
+  // the last chunk on 'commit()'
+  chunk_type next_chunk_{};
+  // prepared data that does not fit into the free space of the last chunk
+  chunk_type staging_{};
+
+  // the number of bytes used in the last chunk
+  [[nodiscard]] std::size_t get_tail_used() const noexcept {
+    return head_offset_ + size_ - (std::size(chunks_) - 1U) * chunk_size_;
+  }
+  void reset_prepared() noexcept {
+    prepared_location_ = prepared_location_type::none;
+    prepared_size_ = 0U;
+  }
+
+  [[nodiscard]] chunk_type acquire_chunk();
+  void release_chunk(chunk_type &&chunk) noexcept;
+  void release_all_chunks() noexcept;
+};
+
+} // namespace util
+
+#endif // UTIL_CHUNKED_BYTE_BUFFER_HPP
@@ -22,6 +22,8 @@
 
 namespace util {
 
+using optional_bool = std::optional<bool>;
+
 using optional_string = std::optional<std::string>;
 
 using optional_uint8_t = std::optional<std::uint8_t>;
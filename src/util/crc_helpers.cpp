@@ -15,22 +15,268 @@
 
 #include "util/crc_helpers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #include <zconf.h>
 #include <zlib.h>
 
 #include "util/byte_span_fwd.hpp"
+#include "util/crc_kernels_private.hpp"
+#include "util/thread_pool.hpp"
 
 namespace util {
 
-std::uint32_t calculate_crc32(const_byte_span portion) noexcept {
-  auto crc = crc32_z(0UL, Z_NULL, 0U);
+namespace detail {
+
+std::uint32_t update_crc32_zlib(std::uint32_t crc,
+                                const_byte_span portion) noexcept {
   return static_cast<std::uint32_t>(
       // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
       crc32_z(crc, reinterpret_cast<const Bytef *>(std::data(portion)),
               std::size(portion)));
 }
 
+std::uint32_t copy_and_update_crc32_zlib(std::uint32_t crc,
+                                         const_byte_span source,
+                                         std::byte *destination) noexcept {
+  // zlib has no fused kernel, so the data is processed in chunks small
+  // enough to still be in L1 cache when the checksum is calculated over
+  // the copy
+  constexpr std::size_t chunk_size{16U * 1024U};
+  while (!source.empty()) {
+    const auto chunk{source.first(std::min(std::size(source), chunk_size))};
+    std::memcpy(destination, std::data(chunk), std::size(chunk));
+    crc = update_crc32_zlib(crc,
+                            const_byte_span{destination, std::size(chunk)});
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    destination += std::size(chunk);
+    source = source.subspan(std::size(chunk));
+  }
+  return crc;
+}
+
+} // namespace detail
+
+namespace {
+
+using crc32_update_function = std::uint32_t (*)(std::uint32_t,
+                                                const_byte_span) noexcept;
+using crc32_copy_and_update_function =
+    std::uint32_t (*)(std::uint32_t, const_byte_span, std::byte *) noexcept;
+
+[[nodiscard]] crc32_update_function
+get_crc32_update_function(crc32_kernel_type kernel) noexcept {
+  switch (kernel) {
+#if defined(__x86_64__)
+  case crc32_kernel_type::pclmulqdq:
+    return &detail::update_crc32_pclmulqdq;
+  case crc32_kernel_type::vpclmulqdq:
+    return &detail::update_crc32_vpclmulqdq;
+#endif
+#if defined(__aarch64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  case crc32_kernel_type::armv8:
+    return &detail::update_crc32_armv8;
+#endif
+  default:
+    return &detail::update_crc32_zlib;
+  }
+}
+
+[[nodiscard]] crc32_copy_and_update_function
+get_crc32_copy_and_update_function(crc32_kernel_type kernel) noexcept {
+  switch (kernel) {
+#if defined(__x86_64__)
+  case crc32_kernel_type::pclmulqdq:
+    return &detail::copy_and_update_crc32_pclmulqdq;
+  case crc32_kernel_type::vpclmulqdq:
+    return &detail::copy_and_update_crc32_vpclmulqdq;
+#endif
+#if defined(__aarch64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  case crc32_kernel_type::armv8:
+    return &detail::copy_and_update_crc32_armv8;
+#endif
+  default:
+    return &detail::copy_and_update_crc32_zlib;
+  }
+}
+
+struct crc32_dispatch_entry {
+  crc32_kernel_type kernel;
+  crc32_update_function function;
+  crc32_copy_and_update_function copy_function;
+};
+
+[[nodiscard]] crc32_dispatch_entry select_crc32_kernel() noexcept {
+  // from the fastest to the slowest
+  for (const auto kernel :
+       {crc32_kernel_type::vpclmulqdq, crc32_kernel_type::pclmulqdq,
+        crc32_kernel_type::armv8}) {
+    if (is_crc32_kernel_supported(kernel)) {
+      return {.kernel = kernel,
+              .function = get_crc32_update_function(kernel),
+              .copy_function = get_crc32_copy_and_update_function(kernel)};
+    }
+  }
+  return {.kernel = crc32_kernel_type::generic,
+          .function = &detail::update_crc32_zlib,
+          .copy_function = &detail::copy_and_update_crc32_zlib};
+}
+
+[[nodiscard]] const crc32_dispatch_entry &get_active_crc32_entry() noexcept {
+  static const crc32_dispatch_entry active_entry{select_crc32_kernel()};
+  return active_entry;
+}
+
+} // anonymous namespace
+
+std::string_view get_crc32_kernel_name(crc32_kernel_type kernel) noexcept {
+  switch (kernel) {
+  case crc32_kernel_type::generic:
+    return "generic";
+  case crc32_kernel_type::pclmulqdq:
+    return "pclmulqdq";
+  case crc32_kernel_type::vpclmulqdq:
+    return "vpclmulqdq";
+  case crc32_kernel_type::armv8:
+    return "armv8";
+  default:
+    return "unknown";
+  }
+}
+
+bool is_crc32_kernel_supported(crc32_kernel_type kernel) noexcept {
+  switch (kernel) {
+  case crc32_kernel_type::generic:
+    return true;
+#if defined(__x86_64__)
+  case crc32_kernel_type::pclmulqdq:
+    return detail::is_crc32_pclmulqdq_supported();
+  case crc32_kernel_type::vpclmulqdq:
+    return detail::is_crc32_vpclmulqdq_supported();
+#endif
+#if defined(__aarch64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  case crc32_kernel_type::armv8:
+    return detail::is_crc32_armv8_supported();
+#endif
+  default:
+    return false;
+  }
+}
+
+crc32_kernel_type get_active_crc32_kernel() noexcept {
+  return get_active_crc32_entry().kernel;
+}
+
+std::uint32_t update_crc32(std::uint32_t crc,
+                           const_byte_span portion) noexcept {
+  return get_active_crc32_entry().function(crc, portion);
+}
+
+std::uint32_t update_crc32(crc32_kernel_type kernel, std::uint32_t crc,
+                           const_byte_span portion) noexcept {
+  return get_crc32_update_function(kernel)(crc, portion);
+}
+
+std::uint32_t copy_and_update_crc32(std::uint32_t crc, const_byte_span source,
+                                    byte_span destination) noexcept {
+  assert(std::size(destination) >= std::size(source));
+  return get_active_crc32_entry().copy_function(crc, source,
+                                                std::data(destination));
+}
+
+std::uint32_t copy_and_update_crc32(crc32_kernel_type kernel,
+                                    std::uint32_t crc, const_byte_span source,
+                                    byte_span destination) noexcept {
+  assert(std::size(destination) >= std::size(source));
+  return get_crc32_copy_and_update_function(kernel)(crc, source,
+                                                    std::data(destination));
+}
+
+std::uint32_t combine_crc32(std::uint32_t crc1, std::uint32_t crc2,
+                            std::size_t length2) noexcept {
+  return static_cast<std::uint32_t>(
+      crc32_combine(crc1, crc2, static_cast<z_off_t>(length2)));
+}
+
+std::uint32_t patch_crc32(std::uint32_t crc, const_byte_span original,
+                          const_byte_span updated,
+                          std::size_t trailing_length) noexcept {
+  assert(std::size(original) == std::size(updated));
+  // For sequences of the same length CRC32 is affine:
+  // 'crc(a ^ b) == crc(a) ^ crc(b) ^ crc(zeros)'. Therefore, the checksum
+  // changes by the linear part of CRC32 of the XOR difference between the
+  // original and the updated bytes, shifted by the number of bytes that
+  // follow them. The difference is processed in chunks to avoid allocations.
+  constexpr std::size_t chunk_size{64U};
+  static constexpr std::array<std::byte, chunk_size> zeros{};
+  std::array<std::byte, chunk_size> difference{};
+  std::uint32_t delta{0U};
+  for (std::size_t offset{0U}; offset < std::size(updated);
+       offset += chunk_size) {
+    const auto length{std::min(chunk_size, std::size(updated) - offset)};
+    for (std::size_t index{0U}; index < length; ++index) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      difference[index] = original[offset + index] ^ updated[offset + index];
+    }
+    const auto chunk_delta{
+        calculate_crc32(const_byte_span{std::data(difference), length}) ^
+        calculate_crc32(const_byte_span{std::data(zeros), length})};
+    delta = (offset == 0U ? chunk_delta
+                          : combine_crc32(delta, chunk_delta, length));
+  }
+  return crc ^ combine_crc32(delta, 0U, trailing_length);
+}
+
+std::uint32_t calculate_crc32(const_byte_span portion) noexcept {
+  return update_crc32(0U, portion);
+}
+
+std::uint32_t
+calculate_crc32(std::span<const const_byte_span> portions) noexcept {
+  const auto function{get_active_crc32_entry().function};
+  std::uint32_t crc{0U};
+  for (const auto portion : portions) {
+    crc = function(crc, portion);
+  }
+  return crc;
+}
+
+std::uint32_t calculate_crc32_parallel(const_byte_span portion,
+                                       std::size_t chunk_size,
+                                       thread_pool &pool) {
+  assert(chunk_size != 0U);
+  const auto number_of_chunks{(std::size(portion) + chunk_size - 1U) /
+                              chunk_size};
+  if (number_of_chunks <= 1U || pool.get_max_concurrency() <= 1U) {
+    return calculate_crc32(portion);
+  }
+
+  const auto get_chunk{[portion, chunk_size](std::size_t index) {
+    const auto offset{index * chunk_size};
+    return portion.subspan(offset,
+                           std::min(chunk_size, std::size(portion) - offset));
+  }};
+  // chunks are checksummed independently (starting from 0) and then
+  // combined in order, which is cheap compared to processing a chunk
+  std::vector<std::uint32_t> chunk_crcs(number_of_chunks);
+  pool.parallel_for(number_of_chunks,
+                    [&get_chunk, &chunk_crcs](std::size_t index) {
+                      chunk_crcs[index] = calculate_crc32(get_chunk(index));
+                    });
+  std::uint32_t crc{chunk_crcs.front()};
+  for (std::size_t index{1U}; index < number_of_chunks; ++index) {
+    crc = combine_crc32(crc, chunk_crcs[index], std::size(get_chunk(index)));
+  }
+  return crc;
+}
+
 } // namespace util
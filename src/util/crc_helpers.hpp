@@ -16,13 +16,88 @@
 #ifndef UTIL_CRC_HELPERS_HPP
 #define UTIL_CRC_HELPERS_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <string_view>
 
 #include "util/byte_span_fwd.hpp"
+#include "util/thread_pool_fwd.hpp"
 
 namespace util {
 
+// CRC32 implementations: 'generic' is zlib 'crc32_z()', the others rely on
+// CPU instruction set extensions and are used only when the CPU the program
+// is running on supports them
+enum class crc32_kernel_type : std::uint8_t {
+  generic,
+  pclmulqdq,
+  vpclmulqdq,
+  armv8
+};
+
+[[nodiscard]] std::string_view
+get_crc32_kernel_name(crc32_kernel_type kernel) noexcept;
+[[nodiscard]] bool is_crc32_kernel_supported(crc32_kernel_type kernel) noexcept;
+// the fastest supported kernel, selected once (on the first call) and used
+// by all the functions below
+[[nodiscard]] crc32_kernel_type get_active_crc32_kernel() noexcept;
+
+// updates 'crc' (0 for an empty sequence) with the bytes from 'portion',
+// so that 'update_crc32(calculate_crc32(a), b) == calculate_crc32(a + b)'
+[[nodiscard]] std::uint32_t update_crc32(std::uint32_t crc,
+                                         const_byte_span portion) noexcept;
+// the same as above, but with an explicitly specified kernel, which must be
+// supported (intended for tests / benchmarks)
+[[nodiscard]] std::uint32_t update_crc32(crc32_kernel_type kernel,
+                                         std::uint32_t crc,
+                                         const_byte_span portion) noexcept;
+
+// copies 'source' to the beginning of 'destination' (which must be at least
+// as large and must not overlap with 'source') and updates 'crc' with the
+// copied bytes in a single pass over the data - the result is the same as
+// from 'std::memcpy()' followed by 'update_crc32()', but large portions are
+// read from memory only once
+[[nodiscard]] std::uint32_t
+copy_and_update_crc32(std::uint32_t crc, const_byte_span source,
+                      byte_span destination) noexcept;
+// the same as above, but with an explicitly specified kernel, which must be
+// supported (intended for tests / benchmarks)
+[[nodiscard]] std::uint32_t
+copy_and_update_crc32(crc32_kernel_type kernel, std::uint32_t crc,
+                      const_byte_span source, byte_span destination) noexcept;
+
+// calculates CRC32 of two sequences concatenated one after another from
+// their individual CRC32 values and the length of the second one, so that
+// 'combine_crc32(calculate_crc32(a), calculate_crc32(b), size(b)) ==
+// calculate_crc32(a + b)' (takes O(log(length2)) time)
+[[nodiscard]] std::uint32_t combine_crc32(std::uint32_t crc1,
+                                          std::uint32_t crc2,
+                                          std::size_t length2) noexcept;
+
+// calculates CRC32 of a sequence from the CRC32 'crc' of its previous
+// version, in which the bytes located 'trailing_length' bytes before the
+// end of the sequence were 'original' and now are 'updated' (both of the
+// same size), without processing the rest of the sequence (takes
+// O(size(updated) + log(trailing_length)) time)
+[[nodiscard]] std::uint32_t patch_crc32(std::uint32_t crc,
+                                        const_byte_span original,
+                                        const_byte_span updated,
+                                        std::size_t trailing_length) noexcept;
+
 [[nodiscard]] std::uint32_t calculate_crc32(const_byte_span portion) noexcept;
+// calculates CRC32 of all the 'portions' concatenated one after another
+[[nodiscard]] std::uint32_t
+calculate_crc32(std::span<const const_byte_span> portions) noexcept;
+
+// calculates the same value as 'calculate_crc32(portion)', but splits
+// 'portion' into chunks of 'chunk_size' bytes, whose checksums are calculated
+// by the calling thread together with the threads of 'pool' and then
+// combined - intended for very large portions only, as handing the chunks
+// over to other threads and combining checksums has its own cost
+[[nodiscard]] std::uint32_t calculate_crc32_parallel(const_byte_span portion,
+                                                     std::size_t chunk_size,
+                                                     thread_pool &pool);
 
 } // namespace util
 
@@ -0,0 +1,137 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+// This translation unit is compiled on every platform but is empty
+// everywhere except little-endian AArch64. The CRC32 extension is enabled
+// per function via 'target' attributes, so that the rest of the program can
+// still run on CPUs without it.
+#if defined(__aarch64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+#include "util/crc_kernels_private.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include <arm_acle.h>
+
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+#include "util/byte_span_fwd.hpp"
+
+#if defined(__clang__)
+#define UTIL_CRC_TARGET_ARMV8_CRC __attribute__((target("crc")))
+#else
+#define UTIL_CRC_TARGET_ARMV8_CRC __attribute__((target("+crc")))
+#endif
+
+namespace util::detail {
+
+bool is_crc32_armv8_supported() noexcept {
+#if defined(__linux__)
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0UL;
+#elif defined(__APPLE__)
+  // every Apple Silicon CPU implements the CRC32 extension
+  return true;
+#else
+  return false;
+#endif
+}
+
+namespace {
+
+// when 'Copy' is true, every loaded word is also stored at the same offset
+// in the destination, so that the data passes through the CPU only once
+// ('destination' is null and never dereferenced or advanced otherwise)
+template <bool Copy>
+__attribute__((always_inline)) inline void
+store_copy(std::byte *&destination, const void *source,
+           std::size_t count) noexcept {
+  if constexpr (Copy) {
+    std::memcpy(destination, source, count);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    destination += count;
+  }
+}
+
+// The 'crc32x' / 'crc32b' instructions implement exactly the same
+// bit-reflected 0x04C11DB7 polynomial update as zlib (without the initial
+// and the final inversions).
+template <bool Copy>
+UTIL_CRC_TARGET_ARMV8_CRC std::uint32_t
+process_armv8(std::uint32_t crc, const std::byte *data, std::size_t size,
+              std::byte *destination) noexcept {
+  std::uint32_t state{~crc};
+
+  // the main loop is unrolled so that several independent loads are in
+  // flight, while the instructions themselves are serially dependent
+  constexpr std::size_t word_size{sizeof(std::uint64_t)};
+  constexpr std::size_t block_size{4U * word_size};
+  while (size >= block_size) {
+    std::array<std::uint64_t, 4U> words{};
+    std::memcpy(std::data(words), data, block_size);
+    store_copy<Copy>(destination, std::data(words), block_size);
+    state = __crc32d(state, words[0]);
+    state = __crc32d(state, words[1]);
+    state = __crc32d(state, words[2]);
+    state = __crc32d(state, words[3]);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    data += block_size;
+    size -= block_size;
+  }
+  while (size >= word_size) {
+    std::uint64_t word{};
+    std::memcpy(&word, data, word_size);
+    store_copy<Copy>(destination, &word, word_size);
+    state = __crc32d(state, word);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    data += word_size;
+    size -= word_size;
+  }
+  while (size != 0U) {
+    store_copy<Copy>(destination, data, 1U);
+    state = __crc32b(state, std::to_integer<std::uint8_t>(*data));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    ++data;
+    --size;
+  }
+  return ~state;
+}
+
+} // anonymous namespace
+
+UTIL_CRC_TARGET_ARMV8_CRC std::uint32_t
+update_crc32_armv8(std::uint32_t crc, const_byte_span portion) noexcept {
+  return process_armv8<false>(crc, std::data(portion), std::size(portion),
+                              nullptr);
+}
+
+UTIL_CRC_TARGET_ARMV8_CRC std::uint32_t
+copy_and_update_crc32_armv8(std::uint32_t crc, const_byte_span source,
+                            std::byte *destination) noexcept {
+  return process_armv8<true>(crc, std::data(source), std::size(source),
+                             destination);
+}
+
+} // namespace util::detail
+
+#undef UTIL_CRC_TARGET_ARMV8_CRC
+
+#endif // defined(__aarch64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
@@ -0,0 +1,74 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#ifndef UTIL_CRC_KERNELS_PRIVATE_HPP
+#define UTIL_CRC_KERNELS_PRIVATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/byte_span_fwd.hpp"
+
+namespace util::detail {
+
+// Every kernel updates 'crc' (a value in the same form as the one returned
+// from zlib 'crc32_z()', 0 for an empty sequence) with the bytes from
+// 'portion'. The 'is_..._supported()' functions check whether the CPU the
+// program is running on (and the OS) supports the instructions a kernel
+// relies on. Kernels that cannot be built for the target architecture are
+// not declared.
+// The 'copy_and_update_...()' variants additionally copy 'source' to
+// 'destination' (which must have room for 'std::size(source)' bytes and
+// must not overlap with 'source') while calculating the checksum, so that
+// the data is read only once.
+
+[[nodiscard]] std::uint32_t update_crc32_zlib(std::uint32_t crc,
+                                              const_byte_span portion) noexcept;
+[[nodiscard]] std::uint32_t
+copy_and_update_crc32_zlib(std::uint32_t crc, const_byte_span source,
+                           std::byte *destination) noexcept;
+
+#if defined(__x86_64__)
+
+[[nodiscard]] bool is_crc32_pclmulqdq_supported() noexcept;
+[[nodiscard]] std::uint32_t
+update_crc32_pclmulqdq(std::uint32_t crc, const_byte_span portion) noexcept;
+[[nodiscard]] std::uint32_t
+copy_and_update_crc32_pclmulqdq(std::uint32_t crc, const_byte_span source,
+                                std::byte *destination) noexcept;
+
+[[nodiscard]] bool is_crc32_vpclmulqdq_supported() noexcept;
+[[nodiscard]] std::uint32_t
+update_crc32_vpclmulqdq(std::uint32_t crc, const_byte_span portion) noexcept;
+[[nodiscard]] std::uint32_t
+copy_and_update_crc32_vpclmulqdq(std::uint32_t crc, const_byte_span source,
+                                 std::byte *destination) noexcept;
+
+#endif
+
+#if defined(__aarch64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+[[nodiscard]] bool is_crc32_armv8_supported() noexcept;
+[[nodiscard]] std::uint32_t
+update_crc32_armv8(std::uint32_t crc, const_byte_span portion) noexcept;
+[[nodiscard]] std::uint32_t
+copy_and_update_crc32_armv8(std::uint32_t crc, const_byte_span source,
+                            std::byte *destination) noexcept;
+
+#endif
+
+} // namespace util::detail
+
+#endif // UTIL_CRC_KERNELS_PRIVATE_HPP
@@ -0,0 +1,320 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+// This translation unit is compiled on every platform but is empty
+// everywhere except x86-64. Instruction set extensions are enabled per
+// function via 'target' attributes, so that the rest of the program can
+// still run on CPUs without them.
+#if defined(__x86_64__)
+
+#include "util/crc_kernels_private.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include <immintrin.h>
+
+#include "util/byte_span_fwd.hpp"
+
+// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic,portability-simd-intrinsics)
+
+namespace util::detail {
+
+namespace {
+
+// The kernels below implement CRC32 (bit-reflected 0x04C11DB7 polynomial)
+// folding via carry-less multiplication as described in "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+// (Intel, 2009). Every pair of constants is
+// {x^(D+32) mod P, x^(D-32) mod P}, bit-reflected and shifted left by one,
+// where D is the folding distance in bits.
+
+// D = 512 (4 x 128-bit lanes)
+constexpr std::uint64_t fold_512_lo{0x0154442BD4ULL};
+constexpr std::uint64_t fold_512_hi{0x01C6E41596ULL};
+// D = 128
+constexpr std::uint64_t fold_128_lo{0x01751997D0ULL};
+constexpr std::uint64_t fold_128_hi{0x00CCAA009EULL};
+// x^64 mod P, used for folding 96 bits into 64 bits
+constexpr std::uint64_t fold_64{0x0163CD6124ULL};
+// Barrett reduction constants: P' and mu = x^64 / P
+constexpr std::uint64_t barrett_poly{0x01DB710641ULL};
+constexpr std::uint64_t barrett_mu{0x01F7011641ULL};
+// D = 2048 (4 x 512-bit registers)
+constexpr std::uint64_t fold_2048_lo{0x011542778AULL};
+constexpr std::uint64_t fold_2048_hi{0x01322D1430ULL};
+
+constexpr std::size_t pclmulqdq_block_size{64U};
+constexpr std::size_t vpclmulqdq_block_size{256U};
+constexpr std::size_t lane_size{16U};
+
+// the value 'crc32_z()' would expect is the complement of the internal
+// state these kernels operate on
+template <bool Copy>
+[[nodiscard]] std::uint32_t
+finish_with_zlib(std::uint32_t state, const std::byte *data, std::size_t size,
+                 std::byte *destination) noexcept {
+  if constexpr (Copy) {
+    std::memcpy(destination, data, size);
+  }
+  return update_crc32_zlib(~state, const_byte_span{data, size});
+}
+
+// when 'Copy' is true, every loaded block is also stored at the same
+// offset in the destination, so that the data passes through the CPU
+// only once
+// ('destination' is null and never dereferenced or advanced otherwise)
+template <bool Copy>
+__attribute__((target("pclmul,sse4.1"), always_inline)) inline __m128i
+load_lane(const std::byte *data, std::byte *destination,
+          std::size_t offset = 0U) noexcept {
+  const auto lane{
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset))};
+  if constexpr (Copy) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + offset), lane);
+  }
+  return lane;
+}
+
+template <bool Copy>
+__attribute__((target("avx512f"), always_inline)) inline __m512i
+load_register(const std::byte *data, std::byte *destination,
+              std::size_t offset = 0U) noexcept {
+  const auto reg{_mm512_loadu_si512(data + offset)};
+  if constexpr (Copy) {
+    _mm512_storeu_si512(destination + offset, reg);
+  }
+  return reg;
+}
+
+template <bool Copy>
+__attribute__((always_inline)) inline void
+advance(const std::byte *&data, std::size_t &size, std::byte *&destination,
+        std::size_t count) noexcept {
+  data += count;
+  size -= count;
+  if constexpr (Copy) {
+    destination += count;
+  }
+}
+
+__attribute__((target("pclmul,sse4.1"), always_inline)) inline __m128i
+fold_lane(__m128i lane, __m128i constants, __m128i next) noexcept {
+  const auto lo{_mm_clmulepi64_si128(lane, constants, 0x00)};
+  const auto hi{_mm_clmulepi64_si128(lane, constants, 0x11)};
+  return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+// the same pair of constants in every 128-bit lane
+__attribute__((target("avx512f"))) inline __m512i
+broadcast_constants(std::uint64_t lo, std::uint64_t hi) noexcept {
+  const auto lo_ll{static_cast<long long>(lo)};
+  const auto hi_ll{static_cast<long long>(hi)};
+  return _mm512_set_epi64(hi_ll, lo_ll, hi_ll, lo_ll, hi_ll, lo_ll, hi_ll,
+                          lo_ll);
+}
+
+__attribute__((target("avx512f,vpclmulqdq"))) inline __m512i
+fold_register(__m512i reg, __m512i constants, __m512i next) noexcept {
+  const auto lo{_mm512_clmulepi64_epi128(reg, constants, 0x00)};
+  const auto hi{_mm512_clmulepi64_epi128(reg, constants, 0x11)};
+  // 0x96 - three-way XOR
+  return _mm512_ternarylogic_epi64(lo, hi, next, 0x96);
+}
+
+// Folds four 128-bit lanes holding the state for the first 64 bytes into
+// one, consumes the remaining whole 16-byte blocks and reduces the result to
+// a 32-bit CRC. Returns the internal state, 'size' is updated to the
+// number of unprocessed bytes (less than 16).
+// Always inlined, so that in the AVX-512 kernel it is VEX-encoded as well -
+// executing legacy SSE instructions while the upper parts of the ZMM
+// registers are dirty costs hundreds of cycles on every call.
+template <bool Copy>
+__attribute__((target("pclmul,sse4.1"), always_inline)) inline std::uint32_t
+fold_and_reduce(__m128i lane0, __m128i lane1, __m128i lane2, __m128i lane3,
+                const std::byte *&data, std::size_t &size,
+                std::byte *&destination) noexcept {
+  auto constants{_mm_set_epi64x(static_cast<long long>(fold_128_hi),
+                                static_cast<long long>(fold_128_lo))};
+  auto acc{fold_lane(lane0, constants, lane1)};
+  acc = fold_lane(acc, constants, lane2);
+  acc = fold_lane(acc, constants, lane3);
+
+  while (size >= lane_size) {
+    acc = fold_lane(acc, constants, load_lane<Copy>(data, destination));
+    advance<Copy>(data, size, destination, lane_size);
+  }
+
+  // 128 bits -> 64 bits
+  const auto mask32{_mm_setr_epi32(~0, 0, ~0, 0)};
+  auto tmp{_mm_clmulepi64_si128(acc, constants, 0x10)};
+  acc = _mm_xor_si128(_mm_srli_si128(acc, 8), tmp);
+  constants = _mm_set_epi64x(0LL, static_cast<long long>(fold_64));
+  tmp = _mm_srli_si128(acc, 4);
+  acc = _mm_and_si128(acc, mask32);
+  acc = _mm_xor_si128(_mm_clmulepi64_si128(acc, constants, 0x00), tmp);
+
+  // Barrett reduction, 64 bits -> 32 bits
+  constants = _mm_set_epi64x(static_cast<long long>(barrett_mu),
+                             static_cast<long long>(barrett_poly));
+  tmp = _mm_and_si128(acc, mask32);
+  tmp = _mm_clmulepi64_si128(tmp, constants, 0x10);
+  tmp = _mm_and_si128(tmp, mask32);
+  tmp = _mm_clmulepi64_si128(tmp, constants, 0x00);
+  acc = _mm_xor_si128(acc, tmp);
+  return static_cast<std::uint32_t>(_mm_extract_epi32(acc, 1));
+}
+
+template <bool Copy>
+__attribute__((target("pclmul,sse4.1"))) std::uint32_t
+process_pclmulqdq(std::uint32_t crc, const std::byte *data, std::size_t size,
+                  std::byte *destination) noexcept {
+  if (size < pclmulqdq_block_size) {
+    return finish_with_zlib<Copy>(~crc, data, size, destination);
+  }
+
+  auto lane0{load_lane<Copy>(data, destination)};
+  auto lane1{load_lane<Copy>(data, destination, lane_size)};
+  auto lane2{load_lane<Copy>(data, destination, 2 * lane_size)};
+  auto lane3{load_lane<Copy>(data, destination, 3 * lane_size)};
+  lane0 = _mm_xor_si128(lane0, _mm_cvtsi32_si128(static_cast<int>(~crc)));
+  advance<Copy>(data, size, destination, pclmulqdq_block_size);
+
+  const auto constants{_mm_set_epi64x(static_cast<long long>(fold_512_hi),
+                                      static_cast<long long>(fold_512_lo))};
+  while (size >= pclmulqdq_block_size) {
+    lane0 = fold_lane(lane0, constants, load_lane<Copy>(data, destination));
+    lane1 = fold_lane(lane1, constants,
+                      load_lane<Copy>(data, destination, lane_size));
+    lane2 = fold_lane(lane2, constants,
+                      load_lane<Copy>(data, destination, 2 * lane_size));
+    lane3 = fold_lane(lane3, constants,
+                      load_lane<Copy>(data, destination, 3 * lane_size));
+    advance<Copy>(data, size, destination, pclmulqdq_block_size);
+  }
+
+  const auto state{fold_and_reduce<Copy>(lane0, lane1, lane2, lane3, data,
+                                         size, destination)};
+  return finish_with_zlib<Copy>(state, data, size, destination);
+}
+
+template <bool Copy>
+__attribute__((target("avx512f,vpclmulqdq,pclmul,sse4.1"))) std::uint32_t
+process_vpclmulqdq(std::uint32_t crc, const std::byte *data, std::size_t size,
+                   std::byte *destination) noexcept {
+  if (size < vpclmulqdq_block_size) {
+    return process_pclmulqdq<Copy>(crc, data, size, destination);
+  }
+
+  // the same folding as in 'process_pclmulqdq()', but every 512-bit
+  // register holds four 128-bit lanes, so 16 lanes (256 bytes) are folded
+  // per iteration
+  constexpr std::size_t register_size{64U};
+  auto reg0{load_register<Copy>(data, destination)};
+  auto reg1{load_register<Copy>(data, destination, register_size)};
+  auto reg2{load_register<Copy>(data, destination, 2 * register_size)};
+  auto reg3{load_register<Copy>(data, destination, 3 * register_size)};
+  reg0 = _mm512_xor_si512(
+      reg0, _mm512_castsi128_si512(_mm_cvtsi32_si128(static_cast<int>(~crc))));
+  advance<Copy>(data, size, destination, vpclmulqdq_block_size);
+
+  auto constants{broadcast_constants(fold_2048_lo, fold_2048_hi)};
+  while (size >= vpclmulqdq_block_size) {
+    reg0 =
+        fold_register(reg0, constants, load_register<Copy>(data, destination));
+    reg1 = fold_register(
+        reg1, constants, load_register<Copy>(data, destination, register_size));
+    reg2 = fold_register(
+        reg2, constants,
+        load_register<Copy>(data, destination, 2 * register_size));
+    reg3 = fold_register(
+        reg3, constants,
+        load_register<Copy>(data, destination, 3 * register_size));
+    advance<Copy>(data, size, destination, vpclmulqdq_block_size);
+  }
+
+  // folding four registers into one (each step is a 512-bit distance, the
+  // same as between neighbouring 128-bit lanes in 'process_pclmulqdq()')
+  constants = broadcast_constants(fold_512_lo, fold_512_hi);
+  auto acc{fold_register(reg0, constants, reg1)};
+  acc = fold_register(acc, constants, reg2);
+  acc = fold_register(acc, constants, reg3);
+  while (size >= pclmulqdq_block_size) {
+    acc =
+        fold_register(acc, constants, load_register<Copy>(data, destination));
+    advance<Copy>(data, size, destination, pclmulqdq_block_size);
+  }
+
+  // splitting via memory rather than '_mm512_extracti32x4_epi32()', which
+  // triggers false 'maybe-uninitialized' warnings in GCC headers
+  std::array<std::byte, pclmulqdq_block_size> spilled{};
+  _mm512_storeu_si512(std::data(spilled), acc);
+  const auto *lanes{reinterpret_cast<const __m128i *>(std::data(spilled))};
+  const auto state{fold_and_reduce<Copy>(
+      _mm_loadu_si128(lanes), _mm_loadu_si128(lanes + 1),
+      _mm_loadu_si128(lanes + 2), _mm_loadu_si128(lanes + 3), data, size,
+      destination)};
+  return finish_with_zlib<Copy>(state, data, size, destination);
+}
+
+} // anonymous namespace
+
+bool is_crc32_pclmulqdq_supported() noexcept {
+  return __builtin_cpu_supports("pclmul") != 0 &&
+         __builtin_cpu_supports("sse4.1") != 0;
+}
+
+__attribute__((target("pclmul,sse4.1"))) std::uint32_t
+update_crc32_pclmulqdq(std::uint32_t crc, const_byte_span portion) noexcept {
+  return process_pclmulqdq<false>(crc, std::data(portion), std::size(portion),
+                                  nullptr);
+}
+
+__attribute__((target("pclmul,sse4.1"))) std::uint32_t
+copy_and_update_crc32_pclmulqdq(std::uint32_t crc, const_byte_span source,
+                                std::byte *destination) noexcept {
+  return process_pclmulqdq<true>(crc, std::data(source), std::size(source),
+                                 destination);
+}
+
+bool is_crc32_vpclmulqdq_supported() noexcept {
+  // '__builtin_cpu_supports()' also checks that the OS saves the AVX-512
+  // register state
+  return is_crc32_pclmulqdq_supported() &&
+         __builtin_cpu_supports("avx512f") != 0 &&
+         __builtin_cpu_supports("vpclmulqdq") != 0;
+}
+
+__attribute__((target("avx512f,vpclmulqdq,pclmul,sse4.1"))) std::uint32_t
+update_crc32_vpclmulqdq(std::uint32_t crc, const_byte_span portion) noexcept {
+  return process_vpclmulqdq<false>(crc, std::data(portion),
+                                   std::size(portion), nullptr);
+}
+
+__attribute__((target("avx512f,vpclmulqdq,pclmul,sse4.1"))) std::uint32_t
+copy_and_update_crc32_vpclmulqdq(std::uint32_t crc, const_byte_span source,
+                                 std::byte *destination) noexcept {
+  return process_vpclmulqdq<true>(crc, std::data(source), std::size(source),
+                                  destination);
+}
+
+} // namespace util::detail
+
+// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic,portability-simd-intrinsics)
+
+#endif // defined(__x86_64__)
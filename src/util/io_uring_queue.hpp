@@ -0,0 +1,86 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+#ifndef UTIL_IO_URING_QUEUE_HPP
+#define UTIL_IO_URING_QUEUE_HPP
+
+#include "util/io_uring_queue_fwd.hpp" // IWYU pragma: export
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "util/byte_span_fwd.hpp"
+
+namespace util {
+
+struct io_uring_completion {
+  std::uint64_t user_data;
+  // the result of the corresponding system call (negated errno on failure)
+  std::int32_t result;
+};
+
+// A minimal single-threaded wrapper around a Linux io_uring instance
+// (implemented directly on top of the io_uring_setup(2) / io_uring_enter(2)
+// system calls). Operations are first queued into the submission ring and
+// then passed to the kernel with a single 'submit()' call.
+//
+// The caller is responsible for not having more operations in flight than
+// 'get_capacity()' (so that the completion ring never overflows) and for
+// keeping write buffers alive until the corresponding completions are
+// received.
+//
+// Raises 'std::runtime_error' if io_uring is not available or if any of
+// the system calls fail.
+class [[nodiscard]] io_uring_queue {
+public:
+  // the length of a single operation is a 32-bit field, moreover Linux never
+  // transfers more than about 2 GiB in a single write - larger writes must
+  // be split by the caller
+  static constexpr std::size_t max_write_size{1024U * 1024U * 1024U};
+
+  explicit io_uring_queue(std::uint32_t capacity);
+  io_uring_queue(const io_uring_queue &) = delete;
+  io_uring_queue &operator=(const io_uring_queue &) = delete;
+  io_uring_queue(io_uring_queue &&) = delete;
+  io_uring_queue &operator=(io_uring_queue &&) = delete;
+  ~io_uring_queue();
+
+  [[nodiscard]] std::uint32_t get_capacity() const noexcept;
+
+  // 'data' must not be larger than 'max_write_size'
+  void queue_write(int file_descriptor, const_byte_span data,
+                   std::uint64_t offset, std::uint64_t user_data);
+  // the fdatasync(2) operation is queued with IOSQE_IO_DRAIN, so that it
+  // starts only after all previously submitted operations are finished
+  void queue_fdatasync(int file_descriptor, std::uint64_t user_data);
+
+  // passes all queued operations to the kernel and waits until at least
+  // 'min_completions' operations are completed
+  void submit(std::uint32_t min_completions = 0U);
+
+  // returns the next available completion (if any) without entering the
+  // kernel
+  [[nodiscard]] std::optional<io_uring_completion> pop_completion() noexcept;
+
+private:
+  class ring;
+  using ring_ptr = std::unique_ptr<ring>;
+  ring_ptr ring_;
+};
+
+} // namespace util
+
+#endif // UTIL_IO_URING_QUEUE_HPP
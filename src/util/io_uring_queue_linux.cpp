@@ -0,0 +1,281 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+#include "util/io_uring_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util/byte_span.hpp"
+#include "util/exception_location_helpers.hpp"
+
+namespace util {
+
+namespace {
+
+[[noreturn]] void raise_io_uring_error(std::string message, int error_number) {
+  message += ": ";
+  message += std::error_code{error_number, std::generic_category()}.message();
+  exception_location().raise<std::runtime_error>(message);
+}
+
+// glibc does not provide wrappers for io_uring system calls
+int io_uring_setup(std::uint32_t entries, io_uring_params &params) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int io_uring_enter(int ring_descriptor, std::uint32_t to_submit,
+                   std::uint32_t min_complete, std::uint32_t flags) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ring_descriptor,
+                                    to_submit, min_complete, flags, nullptr,
+                                    std::size_t{0U}));
+}
+
+template <typename T>
+[[nodiscard]] T *ring_field(void *ring_base, std::uint32_t offset) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return reinterpret_cast<T *>(static_cast<std::byte *>(ring_base) + offset);
+}
+
+} // namespace
+
+// ring indices shared with the kernel are accessed via std::atomic_ref with
+// acquire / release semantics as required by the io_uring protocol
+class io_uring_queue::ring {
+public:
+  explicit ring(std::uint32_t capacity) {
+    io_uring_params params{};
+    ring_descriptor_ = io_uring_setup(capacity, params);
+    if (ring_descriptor_ < 0) {
+      raise_io_uring_error("cannot set up io_uring", errno);
+    }
+    try {
+      map_rings(params);
+    } catch (...) {
+      unmap_rings();
+      ::close(ring_descriptor_);
+      throw;
+    }
+  }
+
+  ring(const ring &) = delete;
+  ring &operator=(const ring &) = delete;
+  ring(ring &&) = delete;
+  ring &operator=(ring &&) = delete;
+
+  ~ring() {
+    unmap_rings();
+    ::close(ring_descriptor_);
+  }
+
+  [[nodiscard]] std::uint32_t get_capacity() const noexcept {
+    return sq_entries_;
+  }
+
+  [[nodiscard]] io_uring_sqe &get_sqe() {
+    const auto tail{*sq_tail_};
+    if (tail - std::atomic_ref{*sq_head_}.load(std::memory_order_acquire) ==
+        sq_entries_) {
+      // the submission ring is full - passing the queued entries to the
+      // kernel (without SQPOLL it consumes all of them synchronously)
+      submit(0U);
+    }
+    const auto index{tail & sq_mask_};
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto &sqe{sqes_[index]};
+    sq_array_[index] = index;
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::memset(&sqe, 0, sizeof sqe);
+    return sqe;
+  }
+
+  void commit_sqe() noexcept {
+    std::atomic_ref{*sq_tail_}.store(*sq_tail_ + 1U, std::memory_order_release);
+    ++number_of_queued_;
+  }
+
+  void submit(std::uint32_t min_completions) {
+    const std::uint32_t flags{min_completions != 0U ? IORING_ENTER_GETEVENTS
+                                                    : 0U};
+    while (number_of_queued_ != 0U || min_completions != 0U) {
+      const auto result{io_uring_enter(ring_descriptor_, number_of_queued_,
+                                       min_completions, flags)};
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        raise_io_uring_error("cannot submit io_uring operations", errno);
+      }
+      number_of_queued_ -= static_cast<std::uint32_t>(result);
+      // 'min_completions' are guaranteed to be available after the very
+      // first successful call
+      min_completions = 0U;
+    }
+  }
+
+  [[nodiscard]] std::optional<io_uring_completion> pop_completion() noexcept {
+    const auto head{*cq_head_};
+    if (head == std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire)) {
+      return {};
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto &cqe{cqes_[head & cq_mask_]};
+    const io_uring_completion result{.user_data = cqe.user_data,
+                                     .result = cqe.res};
+    std::atomic_ref{*cq_head_}.store(head + 1U, std::memory_order_release);
+    return result;
+  }
+
+private:
+  int ring_descriptor_{-1};
+  std::uint32_t number_of_queued_{0U};
+
+  void *sq_ring_base_{MAP_FAILED};
+  std::size_t sq_ring_size_{0U};
+  void *cq_ring_base_{MAP_FAILED};
+  std::size_t cq_ring_size_{0U};
+  void *sqes_base_{MAP_FAILED};
+  std::size_t sqes_size_{0U};
+
+  std::uint32_t sq_entries_{0U};
+  std::uint32_t sq_mask_{0U};
+  std::uint32_t *sq_head_{nullptr};
+  std::uint32_t *sq_tail_{nullptr};
+  std::uint32_t *sq_array_{nullptr};
+  io_uring_sqe *sqes_{nullptr};
+
+  std::uint32_t cq_mask_{0U};
+  std::uint32_t *cq_head_{nullptr};
+  std::uint32_t *cq_tail_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+
+  [[nodiscard]] void *map_ring_region(std::size_t size,
+                                      std::uint64_t offset) const {
+    void *result{::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_descriptor_,
+                        static_cast<off_t>(offset))};
+    if (result == MAP_FAILED) {
+      raise_io_uring_error("cannot map io_uring ring", errno);
+    }
+    return result;
+  }
+
+  void map_rings(const io_uring_params &params) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap{(params.features & IORING_FEAT_SINGLE_MMAP) != 0U};
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_base_ = map_ring_region(sq_ring_size_, IORING_OFF_SQ_RING);
+    if (single_mmap) {
+      cq_ring_base_ = sq_ring_base_;
+    } else {
+      cq_ring_base_ = map_ring_region(cq_ring_size_, IORING_OFF_CQ_RING);
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_base_ = map_ring_region(sqes_size_, IORING_OFF_SQES);
+
+    sq_entries_ = params.sq_entries;
+    sq_mask_ =
+        *ring_field<std::uint32_t>(sq_ring_base_, params.sq_off.ring_mask);
+    sq_head_ = ring_field<std::uint32_t>(sq_ring_base_, params.sq_off.head);
+    sq_tail_ = ring_field<std::uint32_t>(sq_ring_base_, params.sq_off.tail);
+    sq_array_ = ring_field<std::uint32_t>(sq_ring_base_, params.sq_off.array);
+    sqes_ = static_cast<io_uring_sqe *>(sqes_base_);
+
+    cq_mask_ =
+        *ring_field<std::uint32_t>(cq_ring_base_, params.cq_off.ring_mask);
+    cq_head_ = ring_field<std::uint32_t>(cq_ring_base_, params.cq_off.head);
+    cq_tail_ = ring_field<std::uint32_t>(cq_ring_base_, params.cq_off.tail);
+    cqes_ = ring_field<io_uring_cqe>(cq_ring_base_, params.cq_off.cqes);
+  }
+
+  void unmap_rings() noexcept {
+    if (sqes_base_ != MAP_FAILED) {
+      ::munmap(sqes_base_, sqes_size_);
+    }
+    if (cq_ring_base_ != MAP_FAILED && cq_ring_base_ != sq_ring_base_) {
+      ::munmap(cq_ring_base_, cq_ring_size_);
+    }
+    if (sq_ring_base_ != MAP_FAILED) {
+      ::munmap(sq_ring_base_, sq_ring_size_);
+    }
+  }
+};
+
+io_uring_queue::io_uring_queue(std::uint32_t capacity)
+    : ring_{std::make_unique<ring>(capacity)} {}
+
+io_uring_queue::~io_uring_queue() = default;
+
+[[nodiscard]] std::uint32_t io_uring_queue::get_capacity() const noexcept {
+  return ring_->get_capacity();
+}
+
+void io_uring_queue::queue_write(int file_descriptor, const_byte_span data,
+                                 std::uint64_t offset,
+                                 std::uint64_t user_data) {
+  if (std::size(data) > max_write_size) {
+    exception_location().raise<std::invalid_argument>(
+        "io_uring write is too large");
+  }
+  auto &sqe{ring_->get_sqe()};
+  sqe.opcode = IORING_OP_WRITE;
+  sqe.fd = file_descriptor;
+  sqe.off = offset;
+  sqe.addr = reinterpret_cast<std::uintptr_t>(std::data(data));
+  sqe.len = static_cast<std::uint32_t>(std::size(data));
+  sqe.user_data = user_data;
+  ring_->commit_sqe();
+}
+
+void io_uring_queue::queue_fdatasync(int file_descriptor,
+                                     std::uint64_t user_data) {
+  auto &sqe{ring_->get_sqe()};
+  sqe.opcode = IORING_OP_FSYNC;
+  sqe.flags = IOSQE_IO_DRAIN;
+  sqe.fd = file_descriptor;
+  sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+  sqe.user_data = user_data;
+  ring_->commit_sqe();
+}
+
+void io_uring_queue::submit(std::uint32_t min_completions) {
+  ring_->submit(min_completions);
+}
+
+[[nodiscard]] std::optional<io_uring_completion>
+io_uring_queue::pop_completion() noexcept {
+  return ring_->pop_completion();
+}
+
+} // namespace util
@@ -16,7 +16,12 @@
 #ifndef UTIL_NATIVE_FILE_OPERATIONS_HELPERS_HPP
 #define UTIL_NATIVE_FILE_OPERATIONS_HELPERS_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <span>
+
+#include "util/byte_span_fwd.hpp"
 
 namespace util {
 
@@ -28,6 +33,120 @@ namespace util {
 // or closed.
 void fsync(const std::filesystem::path &path);
 
+// A move-only owner of a native file descriptor of a regular file opened
+// for writing at its end (either truncated or positioned at its end). The
+// file is not opened in O_APPEND mode, so that the descriptor can also be
+// used for writing at explicit offsets (e.g. via io_uring).
+//
+// All methods raise 'std::runtime_error' on failure.
+class [[nodiscard]] native_append_file {
+public:
+  native_append_file() noexcept = default;
+  native_append_file(const native_append_file &) = delete;
+  native_append_file &operator=(const native_append_file &) = delete;
+  native_append_file(native_append_file &&other) noexcept;
+  native_append_file &operator=(native_append_file &&other) noexcept;
+  ~native_append_file();
+
+  [[nodiscard]] bool is_open() const noexcept { return descriptor_ >= 0; }
+  [[nodiscard]] int get_descriptor() const noexcept { return descriptor_; }
+
+  // opens (creating if needed) the file at 'path' and returns its size
+  // (which is always 0 when 'truncate' is true)
+  std::uint64_t open(const std::filesystem::path &path, bool truncate);
+  // if 'preallocate()' was called, releases the preallocated space beyond
+  // the end of the file before closing it
+  void close();
+
+  // allocates disk space for the first 'size' bytes of the file without
+  // changing its size (fallocate(2) with FALLOC_FL_KEEP_SIZE), so that
+  // subsequent appends do not need to allocate new extents; does nothing
+  // on filesystems that do not support it
+  void preallocate(std::uint64_t size);
+
+  // writes all the 'portions' one after another with as few system calls
+  // as possible (writev(2)), retrying on partial writes
+  void write(std::span<const const_byte_span> portions);
+  void write(const_byte_span portion);
+
+  // makes all previously written data durable (fdatasync(2))
+  void datasync();
+
+  // changes the size of the file to 'size' bytes, subsequent writes append
+  // data at the new end of the file
+  void truncate(std::uint64_t size);
+
+  // tries to acquire an exclusive advisory lock on the file (flock(2)),
+  // returns false if it is held via another descriptor (either by this or
+  // by another process), the lock is released when the file is closed
+  [[nodiscard]] bool try_lock();
+
+private:
+  int descriptor_{-1};
+  std::uint64_t preallocated_size_{0ULL};
+};
+
+// A move-only owner of a read-only memory mapping of a file region. The
+// mapping stays valid after the file it was created from is closed.
+//
+// All methods raise 'std::runtime_error' on failure.
+class [[nodiscard]] native_file_mapping {
+public:
+  native_file_mapping() noexcept = default;
+  native_file_mapping(const native_file_mapping &) = delete;
+  native_file_mapping &operator=(const native_file_mapping &) = delete;
+  native_file_mapping(native_file_mapping &&other) noexcept;
+  native_file_mapping &operator=(native_file_mapping &&other) noexcept;
+  ~native_file_mapping();
+
+  // maps 'size' bytes of the file referred to by 'file_descriptor' starting
+  // from the beginning of the file ('size' may be 0, in which case nothing
+  // is actually mapped)
+  native_file_mapping(int file_descriptor, std::size_t size);
+
+  [[nodiscard]] const_byte_span get_content() const noexcept;
+
+private:
+  void *address_{nullptr};
+  std::size_t size_{0U};
+};
+
+// A move-only owner of a native file descriptor of an unnamed temporary file
+// used for keeping data that does not fit in memory. The file is created in
+// the specified directory, is never visible in the filesystem namespace
+// (O_TMPFILE, or unlinked immediately after creation on filesystems that do
+// not support it) and its space is reclaimed automatically when it is closed,
+// even if the process crashes.
+//
+// All methods raise 'std::runtime_error' on failure.
+class [[nodiscard]] native_temporary_file {
+public:
+  native_temporary_file() noexcept = default;
+  native_temporary_file(const native_temporary_file &) = delete;
+  native_temporary_file &operator=(const native_temporary_file &) = delete;
+  native_temporary_file(native_temporary_file &&other) noexcept;
+  native_temporary_file &operator=(native_temporary_file &&other) noexcept;
+  ~native_temporary_file();
+
+  [[nodiscard]] bool is_open() const noexcept { return descriptor_ >= 0; }
+  [[nodiscard]] std::uint64_t get_size() const noexcept { return size_; }
+
+  void open(const std::filesystem::path &directory);
+  void close();
+
+  void append(const_byte_span portion);
+  void truncate(std::uint64_t size);
+  // fills the whole 'destination' with the data starting at 'offset'
+  void read(std::uint64_t offset, byte_span destination) const;
+  // maps the whole current content of the file into memory, the file must
+  // not be truncated while the mapping is in use
+  [[nodiscard]] native_file_mapping map() const;
+
+private:
+  int descriptor_{-1};
+  std::uint64_t size_{0ULL};
+};
+
 } // namespace util
 
 #endif // UTIL_NATIVE_FILE_OPERATIONS_HELPERS_HPP
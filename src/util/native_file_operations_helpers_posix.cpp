@@ -15,17 +15,32 @@
 
 #include "util/native_file_operations_helpers.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
+#include <limits>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <system_error>
+#include <utility>
+#include <vector>
 
 #include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <boost/scope/scope_exit.hpp>
 
+#include "util/byte_span.hpp"
 #include "util/exception_location_helpers.hpp"
 
 namespace util {
@@ -53,4 +68,362 @@ void fsync(const std::filesystem::path &path) {
   }
 }
 
+namespace {
+
+[[noreturn]] void raise_errno_error(std::string message, int error_number) {
+  message += ": ";
+  message += std::error_code{error_number, std::generic_category()}.message();
+  exception_location().raise<std::runtime_error>(message);
+}
+
+} // namespace
+
+native_append_file::native_append_file(native_append_file &&other) noexcept
+    : descriptor_{std::exchange(other.descriptor_, -1)},
+      preallocated_size_{std::exchange(other.preallocated_size_, 0ULL)} {}
+
+native_append_file &
+native_append_file::operator=(native_append_file &&other) noexcept {
+  if (this != &other) {
+    if (is_open()) {
+      ::close(descriptor_);
+    }
+    descriptor_ = std::exchange(other.descriptor_, -1);
+    preallocated_size_ = std::exchange(other.preallocated_size_, 0ULL);
+  }
+  return *this;
+}
+
+native_append_file::~native_append_file() {
+  if (is_open()) {
+    ::close(descriptor_);
+  }
+}
+
+std::uint64_t native_append_file::open(const std::filesystem::path &path,
+                                       bool truncate) {
+  if (is_open()) {
+    exception_location().raise<std::logic_error>(
+        "native file is already open");
+  }
+  // the same permissions (modified by umask) as std::ofstream would use
+  static constexpr mode_t default_file_mode{
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH};
+  const int flags{O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0)};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+  const int file_descriptor{::open(path.c_str(), flags, default_file_mode)};
+  if (file_descriptor < 0) {
+    raise_errno_error("cannot open native file", errno);
+  }
+  descriptor_ = file_descriptor;
+
+  // positioning at the end of the file, so that subsequent writes append data
+  const auto end_offset{::lseek(descriptor_, 0, SEEK_END)};
+  if (end_offset < 0) {
+    const auto saved_errno = errno;
+    close();
+    raise_errno_error("cannot determine native file size", saved_errno);
+  }
+  return static_cast<std::uint64_t>(end_offset);
+}
+
+void native_append_file::close() {
+  if (!is_open()) {
+    return;
+  }
+  const int file_descriptor{std::exchange(descriptor_, -1)};
+  const auto preallocated_size{std::exchange(preallocated_size_, 0ULL)};
+
+  // blocks allocated with FALLOC_FL_KEEP_SIZE beyond the end of the file
+  // are released by truncating the file to its current size
+  int trim_errno{0};
+  if (preallocated_size != 0ULL) {
+    struct stat file_stat{};
+    if (::fstat(file_descriptor, &file_stat) != 0) {
+      trim_errno = errno;
+    } else if (static_cast<std::uint64_t>(file_stat.st_size) <
+                   preallocated_size &&
+               ::ftruncate(file_descriptor, file_stat.st_size) != 0) {
+      trim_errno = errno;
+    }
+  }
+
+  if (::close(file_descriptor) != 0) {
+    raise_errno_error("cannot close native file", errno);
+  }
+  if (trim_errno != 0) {
+    raise_errno_error("cannot release preallocated space of native file",
+                      trim_errno);
+  }
+}
+
+void native_append_file::preallocate(std::uint64_t size) {
+  assert(is_open());
+  if (size <= preallocated_size_) {
+    return;
+  }
+#ifdef FALLOC_FL_KEEP_SIZE
+  int result{};
+  do {
+    result = ::fallocate(descriptor_, FALLOC_FL_KEEP_SIZE, 0,
+                         static_cast<off_t>(size));
+  } while (result != 0 && errno == EINTR);
+  if (result != 0) {
+    if (errno == EOPNOTSUPP || errno == ENOSYS) {
+      return;
+    }
+    raise_errno_error("cannot preallocate native file", errno);
+  }
+  preallocated_size_ = size;
+#endif
+}
+
+void native_append_file::write(std::span<const const_byte_span> portions) {
+  assert(is_open());
+  static constexpr std::size_t max_iovecs_per_call{IOV_MAX};
+  std::vector<::iovec> iovecs;
+  iovecs.reserve(std::min(std::size(portions), max_iovecs_per_call));
+  for (const auto &portion : portions) {
+    if (!portion.empty()) {
+      const auto portion_sv{as_string_view(portion)};
+      // iovec interface requires a non-const pointer even for writing
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      iovecs.push_back({.iov_base = const_cast<char *>(std::data(portion_sv)),
+                        .iov_len = std::size(portion_sv)});
+    }
+  }
+
+  std::span<::iovec> remaining{iovecs};
+  while (!remaining.empty()) {
+    const auto current_count{std::min(std::size(remaining),
+                                       max_iovecs_per_call)};
+    const auto written{::writev(descriptor_, std::data(remaining),
+                                static_cast<int>(current_count))};
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      raise_errno_error("cannot write to native file", errno);
+    }
+    // skipping fully written buffers and adjusting a partially written one
+    auto bytes_left{static_cast<std::size_t>(written)};
+    while (!remaining.empty() && bytes_left >= remaining.front().iov_len) {
+      bytes_left -= remaining.front().iov_len;
+      remaining = remaining.subspan(1U);
+    }
+    if (bytes_left != 0U) {
+      auto &partially_written{remaining.front()};
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      partially_written.iov_base =
+          static_cast<char *>(partially_written.iov_base) + bytes_left;
+      partially_written.iov_len -= bytes_left;
+    }
+  }
+}
+
+void native_append_file::write(const_byte_span portion) {
+  write(std::span<const const_byte_span>{&portion, 1U});
+}
+
+void native_append_file::datasync() {
+  assert(is_open());
+  if (::fdatasync(descriptor_) != 0) {
+    raise_errno_error("cannot fdatasync native file", errno);
+  }
+}
+
+void native_append_file::truncate(std::uint64_t size) {
+  assert(is_open());
+  if (::ftruncate(descriptor_, static_cast<off_t>(size)) != 0) {
+    raise_errno_error("cannot truncate native file", errno);
+  }
+  if (::lseek(descriptor_, static_cast<off_t>(size), SEEK_SET) < 0) {
+    raise_errno_error("cannot reposition native file", errno);
+  }
+}
+
+[[nodiscard]] bool native_append_file::try_lock() {
+  assert(is_open());
+  int result{};
+  do {
+    result = ::flock(descriptor_, LOCK_EX | LOCK_NB);
+  } while (result != 0 && errno == EINTR);
+  if (result == 0) {
+    return true;
+  }
+  if (errno == EWOULDBLOCK) {
+    return false;
+  }
+  raise_errno_error("cannot lock native file", errno);
+}
+
+native_file_mapping::native_file_mapping(native_file_mapping &&other) noexcept
+    : address_{std::exchange(other.address_, nullptr)},
+      size_{std::exchange(other.size_, 0U)} {}
+
+native_file_mapping &
+native_file_mapping::operator=(native_file_mapping &&other) noexcept {
+  if (this != &other) {
+    if (address_ != nullptr) {
+      ::munmap(address_, size_);
+    }
+    address_ = std::exchange(other.address_, nullptr);
+    size_ = std::exchange(other.size_, 0U);
+  }
+  return *this;
+}
+
+native_file_mapping::~native_file_mapping() {
+  if (address_ != nullptr) {
+    ::munmap(address_, size_);
+  }
+}
+
+native_file_mapping::native_file_mapping(int file_descriptor,
+                                         std::size_t size) {
+  if (size == 0U) {
+    return;
+  }
+  void *const address{
+      ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file_descriptor, 0)};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+  if (address == MAP_FAILED) {
+    raise_errno_error("cannot map native file into memory", errno);
+  }
+  // the data is usually read from the mapping only once, from beginning to
+  // end
+  static_cast<void>(::madvise(address, size, MADV_SEQUENTIAL));
+  address_ = address;
+  size_ = size;
+}
+
+[[nodiscard]] const_byte_span
+native_file_mapping::get_content() const noexcept {
+  return {static_cast<const std::byte *>(address_), size_};
+}
+
+native_temporary_file::native_temporary_file(
+    native_temporary_file &&other) noexcept
+    : descriptor_{std::exchange(other.descriptor_, -1)},
+      size_{std::exchange(other.size_, 0ULL)} {}
+
+native_temporary_file &
+native_temporary_file::operator=(native_temporary_file &&other) noexcept {
+  if (this != &other) {
+    if (is_open()) {
+      ::close(descriptor_);
+    }
+    descriptor_ = std::exchange(other.descriptor_, -1);
+    size_ = std::exchange(other.size_, 0ULL);
+  }
+  return *this;
+}
+
+native_temporary_file::~native_temporary_file() {
+  if (is_open()) {
+    ::close(descriptor_);
+  }
+}
+
+void native_temporary_file::open(const std::filesystem::path &directory) {
+  if (is_open()) {
+    exception_location().raise<std::logic_error>(
+        "native temporary file is already open");
+  }
+  int file_descriptor{-1};
+#ifdef O_TMPFILE
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+  file_descriptor = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC,
+                           S_IRUSR | S_IWUSR);
+#endif
+  if (file_descriptor < 0) {
+    // falling back to creating a regular file and unlinking it right away
+    auto path_template{(directory / "binsrv_XXXXXX").string()};
+    file_descriptor = ::mkostemp(std::data(path_template), O_CLOEXEC);
+    if (file_descriptor < 0) {
+      raise_errno_error("cannot create native temporary file", errno);
+    }
+    if (::unlink(path_template.c_str()) != 0) {
+      const auto saved_errno = errno;
+      ::close(file_descriptor);
+      raise_errno_error("cannot unlink native temporary file", saved_errno);
+    }
+  }
+  descriptor_ = file_descriptor;
+  size_ = 0ULL;
+}
+
+void native_temporary_file::close() {
+  if (!is_open()) {
+    return;
+  }
+  const int file_descriptor{std::exchange(descriptor_, -1)};
+  size_ = 0ULL;
+  if (::close(file_descriptor) != 0) {
+    raise_errno_error("cannot close native temporary file", errno);
+  }
+}
+
+void native_temporary_file::append(const_byte_span portion) {
+  assert(is_open());
+  while (!portion.empty()) {
+    const auto written{::pwrite(descriptor_, std::data(portion),
+                                std::size(portion),
+                                static_cast<off_t>(size_))};
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      raise_errno_error("cannot write to native temporary file", errno);
+    }
+    const auto written_size{static_cast<std::size_t>(written)};
+    size_ += written_size;
+    portion = portion.subspan(written_size);
+  }
+}
+
+void native_temporary_file::truncate(std::uint64_t size) {
+  assert(is_open());
+  if (::ftruncate(descriptor_, static_cast<off_t>(size)) != 0) {
+    raise_errno_error("cannot truncate native temporary file", errno);
+  }
+  size_ = size;
+}
+
+void native_temporary_file::read(std::uint64_t offset,
+                                 byte_span destination) const {
+  assert(is_open());
+  if (offset + std::size(destination) > size_) {
+    exception_location().raise<std::out_of_range>(
+        "cannot read beyond the end of native temporary file");
+  }
+  while (!destination.empty()) {
+    const auto bytes_read{::pread(descriptor_, std::data(destination),
+                                  std::size(destination),
+                                  static_cast<off_t>(offset))};
+    if (bytes_read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      raise_errno_error("cannot read from native temporary file", errno);
+    }
+    if (bytes_read == 0) {
+      exception_location().raise<std::runtime_error>(
+          "unexpected end of native temporary file");
+    }
+    const auto read_size{static_cast<std::size_t>(bytes_read)};
+    offset += read_size;
+    destination = destination.subspan(read_size);
+  }
+}
+
+[[nodiscard]] native_file_mapping native_temporary_file::map() const {
+  assert(is_open());
+  if (size_ > std::numeric_limits<std::size_t>::max()) {
+    exception_location().raise<std::out_of_range>(
+        "native temporary file is too large to be mapped into memory");
+  }
+  return native_file_mapping{descriptor_, static_cast<std::size_t>(size_)};
+}
+
 } // namespace util
@@ -0,0 +1,123 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include "util/thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace util {
+
+thread_pool::thread_pool(std::size_t max_concurrency) {
+  if (max_concurrency <= 1U) {
+    return;
+  }
+  helper_threads_.reserve(max_concurrency - 1U);
+  for (std::size_t thread_index{1U}; thread_index < max_concurrency;
+       ++thread_index) {
+    helper_threads_.emplace_back([this](const std::stop_token &stoken) {
+      run_helper_thread(stoken);
+    });
+  }
+}
+
+void thread_pool::parallel_for(std::size_t number_of_items,
+                               const item_handler_type &item_handler) {
+  if (helper_threads_.empty() || number_of_items <= 1U) {
+    for (std::size_t index{0U}; index < number_of_items; ++index) {
+      item_handler(index);
+    }
+    return;
+  }
+
+  const std::scoped_lock call_lock{call_mutex_};
+  {
+    const std::scoped_lock lock{mutex_};
+    item_handler_ = &item_handler;
+    number_of_items_ = number_of_items;
+    next_index_.store(0U, std::memory_order_relaxed);
+    failed_.store(false, std::memory_order_relaxed);
+    first_error_ = nullptr;
+    ++batch_number_;
+  }
+  batch_started_.notify_all();
+
+  process_items(item_handler, number_of_items);
+
+  std::exception_ptr error;
+  {
+    std::unique_lock lock{mutex_};
+    // helper threads that have not picked up this batch yet will see that
+    // it is over and will not refer to 'item_handler' any longer
+    batch_finished_.wait(lock, [this] { return busy_helper_threads_ == 0U; });
+    item_handler_ = nullptr;
+    error = std::exchange(first_error_, nullptr);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void thread_pool::run_helper_thread(const std::stop_token &stoken) {
+  std::unique_lock lock{mutex_};
+  std::uint64_t processed_batch_number{batch_number_};
+  while (batch_started_.wait(lock, stoken, [this, &processed_batch_number] {
+    return batch_number_ != processed_batch_number;
+  })) {
+    processed_batch_number = batch_number_;
+    if (item_handler_ == nullptr) {
+      continue;
+    }
+    const auto &item_handler{*item_handler_};
+    const auto number_of_items{number_of_items_};
+    ++busy_helper_threads_;
+    lock.unlock();
+
+    process_items(item_handler, number_of_items);
+
+    lock.lock();
+    --busy_helper_threads_;
+    if (busy_helper_threads_ == 0U) {
+      batch_finished_.notify_all();
+    }
+  }
+}
+
+void thread_pool::process_items(const item_handler_type &item_handler,
+                                std::size_t number_of_items) noexcept {
+  std::size_t index{};
+  while (!failed_.load(std::memory_order_relaxed) &&
+         (index = next_index_.fetch_add(1U, std::memory_order_relaxed)) <
+             number_of_items) {
+    try {
+      item_handler(index);
+    } catch (...) {
+      const std::scoped_lock lock{mutex_};
+      if (!first_error_) {
+        first_error_ = std::current_exception();
+      }
+      failed_.store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace util
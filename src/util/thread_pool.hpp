@@ -0,0 +1,96 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#ifndef UTIL_THREAD_POOL_HPP
+#define UTIL_THREAD_POOL_HPP
+
+#include "util/thread_pool_fwd.hpp" // IWYU pragma: export
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// A fixed set of long-lived threads helping the calling thread to process
+// a number of independent items, so that no threads are started for every
+// such batch.
+// Calls to 'parallel_for()' made from several threads at the same time are
+// serialized.
+class [[nodiscard]] thread_pool {
+public:
+  // 'max_concurrency' includes the calling thread, so the pool starts
+  // 'max_concurrency - 1' helper threads (none if it is 0 or 1)
+  explicit thread_pool(std::size_t max_concurrency);
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+  thread_pool(thread_pool &&) = delete;
+  thread_pool &operator=(thread_pool &&) = delete;
+
+  ~thread_pool() = default;
+
+  [[nodiscard]] std::size_t get_max_concurrency() const noexcept {
+    return std::size(helper_threads_) + 1U;
+  }
+
+  // Calls 'item_handler(index)' for every index in [0, number_of_items)
+  // using the calling thread and the helper threads of this pool. Items are
+  // processed in no particular order. If any of the 'item_handler' calls
+  // throws, no new items are started and the first exception is rethrown
+  // after all running calls are finished.
+  void parallel_for(std::size_t number_of_items,
+                    const std::function<void(std::size_t)> &item_handler);
+
+private:
+  using item_handler_type = std::function<void(std::size_t)>;
+
+  std::mutex call_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable_any batch_started_;
+  std::condition_variable batch_finished_;
+  // the batch currently being processed, 'nullptr' when there is none
+  const item_handler_type *item_handler_{nullptr};
+  std::size_t number_of_items_{0U};
+  // incremented on every batch, so that a helper thread does not process
+  // the same batch twice
+  std::uint64_t batch_number_{0ULL};
+  std::size_t busy_helper_threads_{0U};
+  std::atomic<std::size_t> next_index_{0U};
+  std::atomic<bool> failed_{false};
+  std::exception_ptr first_error_;
+
+  // must be declared last so that the threads are joined before any of the
+  // members above are destroyed
+  std::vector<std::jthread> helper_threads_;
+
+  void run_helper_thread(const std::stop_token &stoken);
+  void process_items(const item_handler_type &item_handler,
+                     std::size_t number_of_items) noexcept;
+};
+
+} // namespace util
+
+#endif // UTIL_THREAD_POOL_HPP
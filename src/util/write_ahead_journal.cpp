@@ -0,0 +1,296 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include "util/write_ahead_journal.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "util/byte_span.hpp"
+#include "util/byte_span_extractors.hpp"
+#include "util/byte_span_inserters.hpp"
+#include "util/crc_helpers.hpp"
+#include "util/exception_location_helpers.hpp"
+#include "util/native_file_operations_helpers.hpp"
+
+namespace util {
+
+namespace {
+
+// "BWAL" followed by the format version
+constexpr std::uint32_t journal_magic{0x4C415742U};
+constexpr std::uint32_t journal_version{1U};
+
+// offset (8 bytes) + size (8 bytes) + CRC32 (4 bytes)
+constexpr std::size_t record_header_size{
+    sizeof(std::uint64_t) + sizeof(std::uint64_t) + sizeof(std::uint32_t)};
+using record_header_buffer = std::array<std::byte, record_header_size>;
+
+[[nodiscard]] std::vector<std::byte>
+read_whole_file(const std::filesystem::path &file_path) {
+  std::ifstream journal_ifs{file_path, std::ios_base::binary};
+  if (!journal_ifs.is_open()) {
+    exception_location().raise<std::runtime_error>(
+        "cannot open write-ahead journal file \"" + file_path.string() +
+        "\"");
+  }
+  std::error_code size_ec;
+  const auto file_size{std::filesystem::file_size(file_path, size_ec)};
+  if (size_ec) {
+    exception_location().raise<std::runtime_error>(
+        "cannot determine the size of write-ahead journal file \"" +
+        file_path.string() + "\"");
+  }
+  std::vector<std::byte> result(file_size);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (!journal_ifs.read(reinterpret_cast<char *>(std::data(result)),
+                        static_cast<std::streamsize>(file_size))) {
+    exception_location().raise<std::runtime_error>(
+        "cannot read write-ahead journal file \"" + file_path.string() +
+        "\"");
+  }
+  return result;
+}
+
+} // anonymous namespace
+
+void write_ahead_journal::open(const std::filesystem::path &directory,
+                               std::string_view object_name,
+                               std::uint64_t offset) {
+  if (is_open()) {
+    exception_location().raise<std::logic_error>(
+        "write-ahead journal is already open");
+  }
+  file_path_ = get_file_path(directory, object_name);
+  object_name_ = object_name;
+  // the file is truncated only after it is locked, so that the content of
+  // a journal being replayed is never destroyed
+  static_cast<void>(file_.open(file_path_, false));
+  if (!file_.try_lock()) {
+    file_.close();
+    exception_location().raise<std::runtime_error>(
+        "write-ahead journal file \"" + file_path_.string() +
+        "\" is used by another process");
+  }
+  file_.truncate(0ULL);
+  begin_offset_ = offset;
+  end_offset_ = offset;
+  write_header();
+  file_.datasync();
+  // making sure that the directory entry of the newly created journal file
+  // survives a crash as well
+  fsync(directory);
+}
+
+void write_ahead_journal::discard() {
+  if (!is_open()) {
+    return;
+  }
+  // the file is removed while it is still locked, so that it cannot be
+  // replayed in between
+  std::error_code remove_ec;
+  std::filesystem::remove(file_path_, remove_ec);
+  if (remove_ec) {
+    exception_location().raise<std::runtime_error>(
+        "cannot remove write-ahead journal file \"" + file_path_.string() +
+        "\"");
+  }
+  file_.close();
+  file_path_.clear();
+  object_name_.clear();
+  begin_offset_ = 0ULL;
+  end_offset_ = 0ULL;
+}
+
+void write_ahead_journal::append(std::span<const const_byte_span> portions) {
+  std::uint64_t region_size{0ULL};
+  for (const auto portion : portions) {
+    region_size += std::size(portion);
+  }
+  if (region_size == 0ULL) {
+    return;
+  }
+
+  record_header_buffer record_header{};
+  byte_span remainder{record_header};
+  insert_fixed_int_to_byte_span(remainder, end_offset_);
+  insert_fixed_int_to_byte_span(remainder, region_size);
+  insert_fixed_int_to_byte_span(remainder, calculate_crc32(portions));
+
+  std::vector<const_byte_span> record_portions;
+  record_portions.reserve(std::size(portions) + 1U);
+  record_portions.emplace_back(record_header);
+  record_portions.insert(std::end(record_portions), std::begin(portions),
+                         std::end(portions));
+  file_.write(record_portions);
+  end_offset_ += region_size;
+}
+
+void write_ahead_journal::sync() { file_.datasync(); }
+
+void write_ahead_journal::reset(std::uint64_t offset) {
+  // all the journaled data is already stored remotely, so a crash at any
+  // point here (leaving an empty file or a partially written header) is
+  // harmless - such a journal simply has nothing to replay
+  file_.truncate(0ULL);
+  begin_offset_ = offset;
+  end_offset_ = offset;
+  write_header();
+}
+
+[[nodiscard]] std::filesystem::path
+write_ahead_journal::get_file_path(const std::filesystem::path &directory,
+                                   std::string_view object_name) {
+  std::string file_name{object_name};
+  file_name += file_extension;
+  return directory / file_name;
+}
+
+[[nodiscard]] std::optional<write_ahead_journal_content>
+write_ahead_journal::load(const std::filesystem::path &file_path) {
+  const auto file_content{read_whole_file(file_path)};
+  const const_byte_span whole{file_content};
+  const_byte_span remainder{whole};
+
+  std::uint32_t magic{0U};
+  std::uint32_t version{0U};
+  std::uint64_t offset{0ULL};
+  std::uint32_t object_name_size{0U};
+  if (!extract_fixed_int_from_byte_span_checked(remainder, magic) ||
+      magic != journal_magic ||
+      !extract_fixed_int_from_byte_span_checked(remainder, version) ||
+      version != journal_version ||
+      !extract_fixed_int_from_byte_span_checked(remainder, offset) ||
+      !extract_fixed_int_from_byte_span_checked(remainder,
+                                                object_name_size) ||
+      std::size(remainder) < object_name_size) {
+    return {};
+  }
+  const auto object_name_portion{remainder.first(object_name_size)};
+  remainder = remainder.subspan(object_name_size);
+  const auto header_crc_portion{
+      whole.first(std::size(whole) - std::size(remainder))};
+  std::uint32_t header_crc{0U};
+  if (!extract_fixed_int_from_byte_span_checked(remainder, header_crc) ||
+      header_crc != calculate_crc32(header_crc_portion)) {
+    return {};
+  }
+
+  write_ahead_journal_content result{
+      .object_name = std::string{as_string_view(object_name_portion)},
+      .offset = offset,
+      .data = {}};
+  auto expected_offset{offset};
+  while (std::size(remainder) >= record_header_size) {
+    std::uint64_t record_offset{0ULL};
+    std::uint64_t record_size{0ULL};
+    std::uint32_t record_crc{0U};
+    extract_fixed_int_from_byte_span(remainder, record_offset);
+    extract_fixed_int_from_byte_span(remainder, record_size);
+    extract_fixed_int_from_byte_span(remainder, record_crc);
+    // stopping at the first torn / corrupted record - none of the records
+    // following it could have been acknowledged
+    if (record_offset != expected_offset ||
+        record_size > std::size(remainder)) {
+      break;
+    }
+    const auto record_data{remainder.first(record_size)};
+    if (record_crc != calculate_crc32(record_data)) {
+      break;
+    }
+    result.data.insert(std::end(result.data), std::begin(record_data),
+                       std::end(record_data));
+    remainder = remainder.subspan(record_size);
+    expected_offset += record_size;
+  }
+  return result;
+}
+
+void write_ahead_journal::replay_all(const std::filesystem::path &directory,
+                                     const replay_handler &handler) {
+  std::vector<std::filesystem::path> file_paths;
+  for (const auto &entry : std::filesystem::directory_iterator{directory}) {
+    if (entry.is_regular_file() && entry.path().extension() == file_extension) {
+      file_paths.push_back(entry.path());
+    }
+  }
+
+  for (const auto &file_path : file_paths) {
+    // the lock is held until the file is removed, so that an open journal
+    // never overwrites the file being replayed
+    native_append_file file;
+    static_cast<void>(file.open(file_path, false));
+    if (!file.try_lock()) {
+      continue;
+    }
+    const auto content{load(file_path)};
+    if (content.has_value()) {
+      handler(*content);
+    }
+    std::error_code remove_ec;
+    std::filesystem::remove(file_path, remove_ec);
+    if (remove_ec) {
+      exception_location().raise<std::runtime_error>(
+          "cannot remove replayed write-ahead journal file \"" +
+          file_path.string() + "\"");
+    }
+  }
+}
+
+void write_ahead_journal::write_header() {
+  const auto object_name_portion{as_const_byte_span(object_name_)};
+  if (!std::in_range<std::uint32_t>(std::size(object_name_portion))) {
+    exception_location().raise<std::invalid_argument>(
+        "write-ahead journal object name is too long");
+  }
+  // magic (4 bytes) + version (4 bytes) + offset (8 bytes) +
+  // object name size (4 bytes)
+  std::array<std::byte, sizeof(std::uint32_t) + sizeof(std::uint32_t) +
+                            sizeof(std::uint64_t) + sizeof(std::uint32_t)>
+      header_prefix{};
+  byte_span remainder{header_prefix};
+  insert_fixed_int_to_byte_span(remainder, journal_magic);
+  insert_fixed_int_to_byte_span(remainder, journal_version);
+  insert_fixed_int_to_byte_span(remainder, begin_offset_);
+  insert_fixed_int_to_byte_span(
+      remainder, static_cast<std::uint32_t>(std::size(object_name_portion)));
+
+  const std::array<const_byte_span, 2U> crc_portions{
+      const_byte_span{header_prefix}, object_name_portion};
+  std::array<std::byte, sizeof(std::uint32_t)> header_suffix{};
+  remainder = header_suffix;
+  insert_fixed_int_to_byte_span(remainder, calculate_crc32(crc_portions));
+
+  const std::array<const_byte_span, 3U> header_portions{
+      const_byte_span{header_prefix}, object_name_portion,
+      const_byte_span{header_suffix}};
+  file_.write(header_portions);
+}
+
+} // namespace util
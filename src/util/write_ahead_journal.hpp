@@ -0,0 +1,128 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#ifndef UTIL_WRITE_AHEAD_JOURNAL_HPP
+#define UTIL_WRITE_AHEAD_JOURNAL_HPP
+
+#include "util/write_ahead_journal_fwd.hpp" // IWYU pragma: export
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/byte_span_fwd.hpp"
+#include "util/native_file_operations_helpers.hpp"
+
+namespace util {
+
+// The data recovered from a journal file: the contiguous region of the
+// object 'object_name' starting at 'offset'.
+struct [[nodiscard]] write_ahead_journal_content {
+  std::string object_name;
+  std::uint64_t offset{0ULL};
+  std::vector<std::byte> data;
+};
+
+// A crash-safe local journal of the data appended to a single remote object.
+// Every region written to the object is first recorded in the journal file
+// (together with its CRC32), so that the data that has not yet reached the
+// remote storage can be replayed from the journal after a crash.
+//
+// The journal file consists of a header (the object name and the offset of
+// the first journaled byte) followed by a sequence of records (the offset of
+// the region, its size, its CRC32 and the data itself). A torn record at the
+// end of the file (the result of a crash in the middle of 'append()') is
+// ignored when the journal is loaded.
+//
+// While a journal is open, its file is exclusively locked (flock(2)), so
+// that it is never replayed by another process (or by another journal of
+// the same process) working with the same directory.
+//
+// All methods raise 'std::runtime_error' on failure.
+class [[nodiscard]] write_ahead_journal {
+public:
+  static constexpr std::string_view file_extension{".wal"};
+  using replay_handler =
+      std::function<void(const write_ahead_journal_content &)>;
+
+  write_ahead_journal() = default;
+  write_ahead_journal(const write_ahead_journal &) = delete;
+  write_ahead_journal &operator=(const write_ahead_journal &) = delete;
+  write_ahead_journal(write_ahead_journal &&) = delete;
+  write_ahead_journal &operator=(write_ahead_journal &&) = delete;
+  ~write_ahead_journal() = default;
+
+  [[nodiscard]] bool is_open() const noexcept { return file_.is_open(); }
+  // the offset of the first journaled byte of the object
+  [[nodiscard]] std::uint64_t get_begin_offset() const noexcept {
+    return begin_offset_;
+  }
+  // the offset of the object the next appended region will start at
+  [[nodiscard]] std::uint64_t get_end_offset() const noexcept {
+    return end_offset_;
+  }
+
+  // creates (overwriting any existing one) the journal file for the object
+  // 'object_name' in 'directory', the first region is expected to be
+  // appended at 'offset'; raises 'std::runtime_error' if the file is locked
+  // by another journal
+  void open(const std::filesystem::path &directory,
+            std::string_view object_name, std::uint64_t offset);
+  // closes and removes the journal file (to be called when all the
+  // journaled data is known to be stored remotely)
+  void discard();
+
+  // records the region consisting of all the 'portions' (written one after
+  // another) at the end offset of the journal, the record becomes durable
+  // only after 'sync()'
+  void append(std::span<const const_byte_span> portions);
+  void sync();
+  // drops all the records (to be called when all the journaled data is known
+  // to be stored remotely), subsequent regions start at 'offset'
+  void reset(std::uint64_t offset);
+
+  [[nodiscard]] static std::filesystem::path
+  get_file_path(const std::filesystem::path &directory,
+                std::string_view object_name);
+  // returns an empty optional if the journal file has no valid header
+  [[nodiscard]] static std::optional<write_ahead_journal_content>
+  load(const std::filesystem::path &file_path);
+  // calls 'handler' for the content of every journal file in 'directory'
+  // and removes the file once 'handler' returns (the files without a valid
+  // header are removed without calling it); the files locked by open
+  // journals are skipped
+  static void replay_all(const std::filesystem::path &directory,
+                         const replay_handler &handler);
+
+private:
+  std::filesystem::path file_path_{};
+  std::string object_name_{};
+  native_append_file file_{};
+  std::uint64_t begin_offset_{0ULL};
+  std::uint64_t end_offset_{0ULL};
+
+  void write_header();
+};
+
+} // namespace util
+
+#endif // UTIL_WRITE_AHEAD_JOURNAL_HPP
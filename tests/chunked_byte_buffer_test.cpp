@@ -0,0 +1,189 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE ChunkedByteBufferTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include "util/byte_span.hpp"
+#include "util/chunked_byte_buffer.hpp"
+
+namespace {
+
+constexpr std::size_t test_chunk_size{8U};
+
+std::string generate_data(std::size_t length, char seed) {
+  std::string result(length, ' ');
+  for (std::size_t index{0U}; index < length; ++index) {
+    result[index] = static_cast<char>(seed + static_cast<char>(index % 26U));
+  }
+  return result;
+}
+
+std::string to_string(const util::chunked_byte_buffer &buffer) {
+  std::string result;
+  for (const auto &portion : buffer.get_portions()) {
+    result += util::as_string_view(portion);
+  }
+  return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ChunkedByteBufferAppend) {
+  util::chunked_byte_buffer buffer{test_chunk_size, 0U};
+  BOOST_CHECK(buffer.empty());
+  BOOST_CHECK(buffer.get_portions().empty());
+
+  std::string expected;
+  for (std::size_t length{0U}; length < 3U * test_chunk_size; ++length) {
+    const auto data{generate_data(length, 'a')};
+    buffer.append(util::as_const_byte_span(data));
+    expected += data;
+    BOOST_CHECK_EQUAL(buffer.size(), std::size(expected));
+    BOOST_CHECK_EQUAL(to_string(buffer), expected);
+  }
+  for (const auto &portion : buffer.get_portions()) {
+    BOOST_CHECK_LE(std::size(portion), test_chunk_size);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ChunkedByteBufferConsumeAndTruncate) {
+  util::chunked_byte_buffer buffer{test_chunk_size, 4U * test_chunk_size};
+  std::string expected;
+  // interleaving appends with removals from both ends so that the data
+  // starts and ends at every possible offset within a chunk
+  for (std::size_t iteration{0U}; iteration < 64U; ++iteration) {
+    const auto data{generate_data(iteration % 13U + 1U, 'A')};
+    buffer.append(util::as_const_byte_span(data));
+    expected += data;
+
+    const auto consumed{iteration % 5U};
+    if (consumed <= std::size(expected)) {
+      buffer.consume(consumed);
+      expected.erase(0U, consumed);
+    }
+    if (iteration % 3U == 0U && !expected.empty()) {
+      const auto new_size{std::size(expected) - 1U};
+      buffer.truncate(new_size);
+      expected.resize(new_size);
+    }
+    BOOST_CHECK_EQUAL(buffer.size(), std::size(expected));
+    BOOST_CHECK_EQUAL(to_string(buffer), expected);
+  }
+
+  BOOST_CHECK_THROW(buffer.consume(buffer.size() + 1U), std::out_of_range);
+  BOOST_CHECK_THROW(buffer.truncate(buffer.size() + 1U), std::out_of_range);
+
+  buffer.clear();
+  BOOST_CHECK(buffer.empty());
+  const auto data{generate_data(3U * test_chunk_size, 'a')};
+  buffer.append(util::as_const_byte_span(data));
+  BOOST_CHECK_EQUAL(to_string(buffer), data);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkedByteBufferDetachFront) {
+  const auto data{generate_data(5U * test_chunk_size, 'a')};
+  // detaching every possible prefix of the data starting at every possible
+  // offset within the first chunk
+  for (std::size_t head{0U}; head < test_chunk_size; ++head) {
+    for (std::size_t length{0U}; length <= std::size(data) - head;
+         ++length) {
+      util::chunked_byte_buffer buffer{test_chunk_size, 0U};
+      buffer.append(util::as_const_byte_span(data));
+      buffer.consume(head);
+
+      const auto detached{buffer.detach_front(length)};
+      BOOST_CHECK_EQUAL(detached.size(), length);
+      BOOST_CHECK_EQUAL(to_string(detached), data.substr(head, length));
+      BOOST_CHECK_EQUAL(buffer.size(), std::size(data) - head - length);
+      BOOST_CHECK_EQUAL(to_string(buffer), data.substr(head + length));
+
+      // the remaining data must still be appendable
+      buffer.append(util::as_const_byte_span(data));
+      BOOST_CHECK_EQUAL(to_string(buffer), data.substr(head + length) + data);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ChunkedByteBufferPartialPortions) {
+  util::chunked_byte_buffer buffer{test_chunk_size, 0U};
+  const auto data{generate_data(3U * test_chunk_size, 'a')};
+  buffer.append(util::as_const_byte_span(data));
+  buffer.consume(test_chunk_size / 2U);
+
+  for (std::size_t length{0U}; length <= buffer.size(); ++length) {
+    std::string joined;
+    for (const auto &portion : buffer.get_portions(length)) {
+      joined += util::as_string_view(portion);
+    }
+    BOOST_CHECK_EQUAL(joined, data.substr(test_chunk_size / 2U, length));
+  }
+  BOOST_CHECK_THROW(static_cast<void>(buffer.get_portions(buffer.size() + 1U)),
+                    std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkedByteBufferPrepareAndCommit) {
+  util::chunked_byte_buffer buffer{test_chunk_size, 4U * test_chunk_size};
+  std::string expected;
+  // lengths that fit into the last chunk, exactly fill it, require a new
+  // chunk and cross chunk boundaries, interleaved with regular appends and
+  // abandoned preparations
+  for (std::size_t iteration{0U}; iteration < 64U; ++iteration) {
+    const auto data{generate_data(iteration % 19U, 'a')};
+    auto prepared{buffer.prepare(std::size(data))};
+    BOOST_REQUIRE_EQUAL(std::size(prepared), std::size(data));
+    std::ranges::copy(util::as_const_byte_span(data), std::begin(prepared));
+    if (iteration % 7U == 3U) {
+      // abandoning the prepared data
+      const auto appended{generate_data(iteration % 5U, 'A')};
+      buffer.append(util::as_const_byte_span(appended));
+      expected += appended;
+      BOOST_CHECK_THROW(buffer.commit(0U), std::logic_error);
+    } else {
+      // partial commits are allowed
+      const auto committed{iteration % 4U == 0U && !data.empty()
+                               ? std::size(data) - 1U
+                               : std::size(data)};
+      BOOST_CHECK_THROW(buffer.commit(std::size(data) + 1U),
+                        std::out_of_range);
+      buffer.commit(committed);
+      expected += data.substr(0U, committed);
+      BOOST_CHECK_THROW(buffer.commit(0U), std::logic_error);
+    }
+    if (iteration % 3U == 0U) {
+      const auto consumed{std::min(std::size(expected), test_chunk_size + 1U)};
+      buffer.consume(consumed);
+      expected.erase(0U, consumed);
+    }
+    BOOST_CHECK_EQUAL(buffer.size(), std::size(expected));
+    BOOST_CHECK_EQUAL(to_string(buffer), expected);
+  }
+  for (const auto &portion : buffer.get_portions()) {
+    BOOST_CHECK_LE(std::size(portion), test_chunk_size);
+  }
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+// A microbenchmark measuring the throughput of every CRC32 kernel supported
+// by the current CPU for typical binlog event sizes, both for calculating the
+// checksum alone and for copying the data while calculating it (separately
+// and fused into a single pass), as well as the throughput of checksumming
+// huge events by several threads (with threads started for every event and
+// with a persistent thread pool). It is built together
+// with the tests but is not registered as one, run it manually:
+// ./crc_benchmark
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/byte_span_fwd.hpp"
+#include "util/crc_helpers.hpp"
+#include "util/thread_pool.hpp"
+
+namespace {
+
+struct event_size_info {
+  std::string_view label;
+  std::size_t size;
+};
+
+constexpr std::array event_sizes{
+    event_size_info{.label = "64 B", .size = 64U},
+    event_size_info{.label = "1 KiB", .size = 1024U},
+    event_size_info{.label = "64 KiB", .size = 64U * 1024U},
+    event_size_info{.label = "16 MiB", .size = 16U * 1024U * 1024U}};
+
+constexpr std::array kernels{
+    util::crc32_kernel_type::generic, util::crc32_kernel_type::pclmulqdq,
+    util::crc32_kernel_type::vpclmulqdq, util::crc32_kernel_type::armv8};
+
+// every measurement processes this many bytes in total
+constexpr std::size_t bytes_per_measurement{512U * 1024U * 1024U};
+
+// the same chunk size the event checksum verification uses
+constexpr std::size_t parallel_chunk_size{1024U * 1024U};
+constexpr std::array parallel_concurrencies{1U, 2U, 4U, 8U};
+
+// 'function' is called for every iteration with the previous result and
+// must return a new one - chaining the results prevents the calls from
+// being optimized out
+template <typename Function>
+void measure(std::string_view kernel_name, std::string_view mode,
+             std::string_view label, std::size_t size, Function function) {
+  const auto iterations{bytes_per_measurement / size};
+  std::uint32_t crc{0U};
+  const auto started{std::chrono::steady_clock::now()};
+  for (std::size_t iteration{0U}; iteration < iterations; ++iteration) {
+    crc = function(crc);
+  }
+  const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() -
+                                              started};
+  const auto gib_per_second{static_cast<double>(iterations * size) /
+                            elapsed.count() / (1024.0 * 1024.0 * 1024.0)};
+  std::cout << std::setw(12) << kernel_name << std::setw(12) << mode
+            << std::setw(8) << label << ": " << std::fixed
+            << std::setprecision(2) << gib_per_second << " GiB/s (crc "
+            << std::hex << crc << std::dec << ")\n";
+}
+
+// what checksumming a huge event in parallel used to cost: new threads
+// were started for every event
+std::uint32_t calculate_crc32_spawning_threads(util::const_byte_span portion,
+                                               std::size_t max_concurrency) {
+  util::thread_pool pool{max_concurrency};
+  return util::calculate_crc32_parallel(portion, parallel_chunk_size, pool);
+}
+
+} // anonymous namespace
+
+int main() {
+  std::vector<std::byte> data(event_sizes.back().size);
+  // NOLINTNEXTLINE(cert-msc32-c,cert-msc51-cpp)
+  std::mt19937 generator{42U};
+  for (auto &element : data) {
+    element = static_cast<std::byte>(generator());
+  }
+  std::vector<std::byte> destination(std::size(data));
+
+  std::cout << "active kernel: "
+            << util::get_crc32_kernel_name(util::get_active_crc32_kernel())
+            << '\n';
+  for (const auto kernel : kernels) {
+    if (!util::is_crc32_kernel_supported(kernel)) {
+      continue;
+    }
+    const auto kernel_name{util::get_crc32_kernel_name(kernel)};
+    for (const auto &[label, size] : event_sizes) {
+      const util::const_byte_span portion{std::data(data), size};
+      const util::byte_span destination_portion{std::data(destination), size};
+      measure(kernel_name, "crc", label, size, [&](std::uint32_t crc) {
+        return util::update_crc32(kernel, crc, portion);
+      });
+      // what materializing an event used to cost: a copy followed by a
+      // separate checksum pass over the copy
+      measure(kernel_name, "copy, crc", label, size, [&](std::uint32_t crc) {
+        std::memcpy(std::data(destination_portion), std::data(portion), size);
+        return util::update_crc32(kernel, crc, destination_portion);
+      });
+      measure(kernel_name, "fused copy", label, size, [&](std::uint32_t crc) {
+        return util::copy_and_update_crc32(kernel, crc, portion,
+                                           destination_portion);
+      });
+    }
+  }
+
+  const auto &[huge_label, huge_size]{event_sizes.back()};
+  static_assert(event_sizes.back().size % parallel_chunk_size == 0U);
+  const util::const_byte_span huge_portion{std::data(data), huge_size};
+  for (const auto concurrency : parallel_concurrencies) {
+    const auto kernel_name{"threads x" + std::to_string(concurrency)};
+    measure(kernel_name, "spawned", huge_label, huge_size,
+            [&](std::uint32_t crc) {
+              return crc + calculate_crc32_spawning_threads(huge_portion,
+                                                            concurrency);
+            });
+    util::thread_pool pool{concurrency};
+    measure(kernel_name, "pool", huge_label, huge_size,
+            [&](std::uint32_t crc) {
+              return crc + util::calculate_crc32_parallel(
+                               huge_portion, parallel_chunk_size, pool);
+            });
+  }
+  return EXIT_SUCCESS;
+}
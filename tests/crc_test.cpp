@@ -0,0 +1,243 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <zconf.h>
+#include <zlib.h>
+
+#define BOOST_TEST_MODULE CrcTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include "util/byte_span_fwd.hpp"
+#include "util/crc_helpers.hpp"
+#include "util/thread_pool.hpp"
+
+namespace {
+
+constexpr std::size_t max_test_offset{64U};
+constexpr std::size_t max_test_length{70000U};
+
+std::vector<std::byte> generate_data(std::size_t length) {
+  // NOLINTNEXTLINE(cert-msc32-c,cert-msc51-cpp)
+  std::mt19937 generator{42U};
+  std::vector<std::byte> result(length);
+  for (auto &element : result) {
+    element = static_cast<std::byte>(generator());
+  }
+  return result;
+}
+
+const std::vector<std::byte> &get_test_data() {
+  static const auto test_data{
+      generate_data(max_test_offset + max_test_length)};
+  return test_data;
+}
+
+std::uint32_t calculate_reference_crc32(std::uint32_t crc,
+                                        util::const_byte_span portion) {
+  return static_cast<std::uint32_t>(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      crc32_z(crc, reinterpret_cast<const Bytef *>(std::data(portion)),
+              std::size(portion)));
+}
+
+// lengths around the block sizes of all the kernels plus some large ones
+const std::vector<std::size_t> test_lengths{
+    0U,    1U,    7U,    15U,   16U,    17U,    31U,    32U,   63U,
+    64U,   65U,   79U,   80U,   127U,   128U,   191U,   255U,  256U,
+    257U,  271U,  319U,  320U,  511U,   512U,   513U,    1000U, 1024U,
+    4095U, 4096U, 4097U, 65535U, 65536U, 65537U, max_test_length};
+
+const std::array test_kernels{
+    util::crc32_kernel_type::generic, util::crc32_kernel_type::pclmulqdq,
+    util::crc32_kernel_type::vpclmulqdq, util::crc32_kernel_type::armv8};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Crc32KnownValue) {
+  // the standard CRC32 check value
+  const std::string data{"123456789"};
+  const util::const_byte_span portion{
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const std::byte *>(std::data(data)), std::size(data)};
+  BOOST_CHECK_EQUAL(util::calculate_crc32(portion), 0xCBF43926U);
+  BOOST_CHECK_EQUAL(util::calculate_crc32(util::const_byte_span{}), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(Crc32ActiveKernelIsSupported) {
+  BOOST_CHECK(
+      util::is_crc32_kernel_supported(util::get_active_crc32_kernel()));
+  BOOST_CHECK(
+      util::is_crc32_kernel_supported(util::crc32_kernel_type::generic));
+  BOOST_TEST_MESSAGE("active CRC32 kernel: " << util::get_crc32_kernel_name(
+                         util::get_active_crc32_kernel()));
+}
+
+BOOST_AUTO_TEST_CASE(Crc32KernelsMatchZlib) {
+  const auto &test_data{get_test_data()};
+  // different misalignments and initial values
+  const std::array<std::uint32_t, 3U> initial_crcs{0U, 0xFFFFFFFFU,
+                                                   0x12345678U};
+  for (const auto kernel : test_kernels) {
+    if (!util::is_crc32_kernel_supported(kernel)) {
+      BOOST_TEST_MESSAGE("CRC32 kernel "
+                         << util::get_crc32_kernel_name(kernel)
+                         << " is not supported on this CPU, skipping");
+      continue;
+    }
+    BOOST_TEST_CONTEXT("kernel " << util::get_crc32_kernel_name(kernel)) {
+      for (const auto length : test_lengths) {
+        for (std::size_t offset{0U}; offset < max_test_offset;
+             offset += 13U) {
+          const util::const_byte_span portion{std::data(test_data) + offset,
+                                              length};
+          for (const auto initial_crc : initial_crcs) {
+            BOOST_CHECK_EQUAL(
+                util::update_crc32(kernel, initial_crc, portion),
+                calculate_reference_crc32(initial_crc, portion));
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Crc32Portions) {
+  const auto &test_data{get_test_data()};
+  const util::const_byte_span whole{std::data(test_data), max_test_length};
+  const std::array<util::const_byte_span, 4U> portions{
+      whole.subspan(0U, 3U), whole.subspan(3U, 1000U),
+      whole.subspan(1003U, 0U), whole.subspan(1003U)};
+  const auto expected{calculate_reference_crc32(0U, whole)};
+  BOOST_CHECK_EQUAL(util::calculate_crc32(portions), expected);
+  BOOST_CHECK_EQUAL(util::calculate_crc32(whole), expected);
+  BOOST_CHECK_EQUAL(
+      util::update_crc32(util::calculate_crc32(whole.subspan(0U, 333U)),
+                         whole.subspan(333U)),
+      expected);
+}
+
+BOOST_AUTO_TEST_CASE(Crc32CopyAndUpdateMatchesZlib) {
+  const auto &test_data{get_test_data()};
+  const std::uint32_t initial_crc{0x12345678U};
+  // one extra byte at the end of the destination buffer makes sure that
+  // nothing is written past the copied portion
+  constexpr auto guard_byte{std::byte{0xA5U}};
+  std::vector<std::byte> destination;
+  for (const auto kernel : test_kernels) {
+    if (!util::is_crc32_kernel_supported(kernel)) {
+      continue;
+    }
+    BOOST_TEST_CONTEXT("kernel " << util::get_crc32_kernel_name(kernel)) {
+      for (const auto length : test_lengths) {
+        for (std::size_t offset{0U}; offset < max_test_offset;
+             offset += 13U) {
+          const util::const_byte_span portion{std::data(test_data) + offset,
+                                              length};
+          destination.assign(offset + length + 1U, std::byte{});
+          destination.back() = guard_byte;
+          const util::byte_span destination_portion{
+              std::data(destination) + offset, length + 1U};
+          BOOST_CHECK_EQUAL(util::copy_and_update_crc32(
+                                kernel, initial_crc, portion,
+                                destination_portion),
+                            calculate_reference_crc32(initial_crc, portion));
+          BOOST_CHECK(std::equal(std::begin(portion), std::end(portion),
+                                 std::begin(destination_portion)));
+          BOOST_CHECK(destination.back() == guard_byte);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Crc32Combine) {
+  const auto &test_data{get_test_data()};
+  const util::const_byte_span whole{std::data(test_data), max_test_length};
+  const auto expected{calculate_reference_crc32(0U, whole)};
+  for (const std::size_t split : {0U, 1U, 19U, 4096U, 65537U}) {
+    const auto first{whole.first(split)};
+    const auto second{whole.subspan(split)};
+    BOOST_CHECK_EQUAL(util::combine_crc32(util::calculate_crc32(first),
+                                          util::calculate_crc32(second),
+                                          std::size(second)),
+                      expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Crc32Patch) {
+  const auto &test_data{get_test_data()};
+  const util::const_byte_span original{std::data(test_data), max_test_length};
+  const auto original_crc{util::calculate_crc32(original)};
+  std::vector<std::byte> updated(std::cbegin(original), std::cend(original));
+  // patched regions at the very beginning, in the middle and at the very
+  // end, including the ones longer than a single internal chunk
+  for (const std::size_t offset : {0U, 1U, 4096U, 65000U}) {
+    for (const std::size_t length : {0U, 1U, 4U, 19U, 64U, 65U, 200U}) {
+      std::copy(std::cbegin(original), std::cend(original),
+                std::begin(updated));
+      for (std::size_t index{offset}; index < offset + length; ++index) {
+        updated[index] = ~updated[index];
+      }
+      const util::const_byte_span updated_portion{std::data(updated),
+                                                  std::size(updated)};
+      BOOST_TEST_CONTEXT("offset " << offset << ", length " << length) {
+        BOOST_CHECK_EQUAL(
+            util::patch_crc32(original_crc, original.subspan(offset, length),
+                              updated_portion.subspan(offset, length),
+                              max_test_length - offset - length),
+            util::calculate_crc32(updated_portion));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Crc32Parallel) {
+  const auto &test_data{get_test_data()};
+  const util::const_byte_span whole{std::data(test_data), max_test_length};
+  for (const std::size_t length : {0U, 1U, 4095U, 4096U, 4097U, 65537U}) {
+    const auto portion{whole.first(length)};
+    const auto expected{calculate_reference_crc32(0U, portion)};
+    for (const std::size_t chunk_size : {1U, 1000U, 4096U, 100000U}) {
+      for (const std::size_t max_concurrency : {0U, 1U, 3U, 8U}) {
+        util::thread_pool pool{max_concurrency};
+        BOOST_TEST_CONTEXT("length " << length << ", chunk size " << chunk_size
+                                     << ", concurrency " << max_concurrency) {
+          // the same pool is reused for several calls
+          for (std::size_t call{0U}; call < 2U; ++call) {
+            BOOST_CHECK_EQUAL(
+                util::calculate_crc32_parallel(portion, chunk_size, pool),
+                expected);
+          }
+        }
+      }
+    }
+  }
+}
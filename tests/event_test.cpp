@@ -13,9 +13,13 @@
 // along with this program; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <stdexcept>
 #include <string_view>
+#include <vector>
 
 #define BOOST_TEST_MODULE EventTests
 // this include is needed as it provides the 'main()' function
@@ -30,6 +34,8 @@
 
 #include "binsrv/gtids/common_types.hpp"
 #include "binsrv/gtids/gtid_set.hpp"
+#include "binsrv/gtids/tag.hpp"
+#include "binsrv/gtids/uuid.hpp"
 
 #include "binsrv/events/checksum_algorithm_type.hpp"
 #include "binsrv/events/code_type.hpp"
@@ -386,3 +392,111 @@ BOOST_AUTO_TEST_CASE(EventMaterialization) {
   const binsrv::events::event_view checked_force_remove_checksum_copied_v{
       context_wo_checksum, util::const_byte_span{materialization_buffer}};
 }
+
+BOOST_AUTO_TEST_CASE(LargeEventMaterialization) {
+  // bodies of large events are checksummed while being copied and checksums
+  // of relocated large events are patched rather than recalculated, make
+  // sure the result is the same as for the regular materialization
+  const util::semantic_version server_version{"8.4.8"};
+  std::uint32_t offset{0U};
+  const binsrv::events::reader_context context_with_checksum{
+      server_version.get_encoded(), true, binsrv::replication_mode_type::gtid,
+      "", offset};
+  const binsrv::events::reader_context context_wo_checksum{
+      server_version.get_encoded(), false, binsrv::replication_mode_type::gtid,
+      "", offset};
+
+  // PREVIOUS_GTIDS_LOG event with a few thousand disjoint intervals (64K+)
+  binsrv::gtids::gtid_set large_gtid_set{};
+  const binsrv::gtids::uuid server_uuid{"11111111-aaaa-1111-aaaa-111111111111"};
+  for (binsrv::gtids::gno_t gno{binsrv::gtids::min_gno}; gno < 8192ULL;
+       gno += 2ULL) {
+    large_gtid_set.add(server_uuid, binsrv::gtids::tag{}, gno);
+  }
+  const binsrv::events::generic_post_header<
+      binsrv::events::code_type::previous_gtids_log>
+      post_header{};
+  const binsrv::events::generic_body<
+      binsrv::events::code_type::previous_gtids_log>
+      body{large_gtid_set};
+
+  binsrv::events::event_storage event_with_footer_buffer;
+  offset = binsrv::events::magic_binlog_offset;
+  const auto generated_event{binsrv::events::event::create_event<
+      binsrv::events::code_type::previous_gtids_log>(
+      offset, util::ctime_timestamp::now(), default_server_id,
+      binsrv::events::common_header_flag_set{}, post_header, body, true,
+      event_with_footer_buffer)};
+  const binsrv::events::event_view generated_event_v{
+      context_with_checksum, util::const_byte_span{event_with_footer_buffer}};
+  BOOST_CHECK_GE(generated_event_v.get_body_size(), 64U * 1024U);
+  BOOST_CHECK(generated_event_v.is_checksum_verified());
+
+  static constexpr std::uint64_t relocation_offset{1024U};
+  binsrv::events::event_storage materialization_buffer;
+
+  // relocating an event that has checksum
+  const binsrv::events::event_view relocated_generated_v{
+      binsrv::events::rewriter::materialize_and_relocate(
+          generated_event_v, materialization_buffer,
+          binsrv::events::materialization_type::leave_checksum_as_is,
+          relocation_offset)};
+  BOOST_CHECK(relocated_generated_v.has_footer());
+  BOOST_CHECK(relocated_generated_v.get_footer_view().get_crc_raw() ==
+              relocated_generated_v.calculate_crc());
+  BOOST_CHECK(relocated_generated_v.get_common_header_view()
+                  .get_next_event_position_raw() ==
+              relocation_offset + relocated_generated_v.get_total_size());
+  BOOST_CHECK(std::ranges::equal(relocated_generated_v.get_body_raw(),
+                                 generated_event_v.get_body_raw()));
+  const binsrv::events::event_view checked_relocated_generated_v{
+      context_with_checksum, util::const_byte_span{materialization_buffer}};
+  BOOST_CHECK(checked_relocated_generated_v.is_checksum_verified());
+
+  // adding checksum to an event that does not have it
+  const binsrv::events::event_view force_remove_checksum_generated_v{
+      binsrv::events::rewriter::materialize(
+          generated_event_v, materialization_buffer,
+          binsrv::events::materialization_type::force_remove_checksum)};
+  BOOST_CHECK(!force_remove_checksum_generated_v.has_footer());
+  const binsrv::events::event_storage event_wo_footer_buffer{
+      materialization_buffer};
+  const binsrv::events::event_view copied_event_v{
+      context_wo_checksum, util::const_byte_span{event_wo_footer_buffer}};
+
+  const binsrv::events::event_view force_add_checksum_copied_v{
+      binsrv::events::rewriter::materialize(
+          copied_event_v, materialization_buffer,
+          binsrv::events::materialization_type::force_add_checksum)};
+  BOOST_CHECK(force_add_checksum_copied_v.has_footer());
+  BOOST_CHECK(force_add_checksum_copied_v.get_footer_view().get_crc_raw() ==
+              force_add_checksum_copied_v.calculate_crc());
+  BOOST_CHECK(force_add_checksum_copied_v.get_common_header_view()
+                  .get_event_size_raw() ==
+              force_add_checksum_copied_v.get_total_size());
+  BOOST_CHECK(std::ranges::equal(materialization_buffer,
+                                 event_with_footer_buffer));
+
+  // rewriting into a caller-provided destination (e.g. the space reserved in
+  // the storage event buffer) must give the same result as rewriting into
+  // an event storage
+  const auto rewritten_size{
+      binsrv::events::rewriter::get_rewritten_size(0ULL, copied_event_v)};
+  BOOST_CHECK_EQUAL(rewritten_size, std::size(event_with_footer_buffer));
+  std::vector<std::byte> destination(rewritten_size);
+  const binsrv::events::event_view rewritten_in_place_v{
+      binsrv::events::rewriter::rewrite(0ULL, copied_event_v,
+                                        util::byte_span{destination},
+                                        relocation_offset)};
+  BOOST_CHECK(rewritten_in_place_v.get_footer_view().get_crc_raw() ==
+              rewritten_in_place_v.calculate_crc());
+  static_cast<void>(binsrv::events::rewriter::rewrite(
+      0ULL, copied_event_v, materialization_buffer, relocation_offset));
+  BOOST_CHECK(std::ranges::equal(destination, materialization_buffer));
+  BOOST_CHECK_THROW(
+      static_cast<void>(binsrv::events::rewriter::rewrite(
+          0ULL, copied_event_v,
+          util::byte_span{destination}.first(rewritten_size - 1U),
+          relocation_offset)),
+      std::invalid_argument);
+}
@@ -0,0 +1,208 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#define BOOST_TEST_MODULE IoUringFilesystemStorageBackendTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/assertion_result.hpp>
+#include <boost/test/tools/old/interface.hpp>
+
+#include <boost/test/tree/decorator.hpp>
+#include <boost/test/tree/test_unit.hpp>
+
+#include "binsrv/io_uring_filesystem_storage_backend.hpp"
+#include "binsrv/storage_backend_type.hpp"
+#include "binsrv/storage_config.hpp"
+
+#include "util/byte_span.hpp"
+#include "util/io_uring_queue.hpp"
+
+namespace {
+
+constexpr std::string_view binlog_name{"binlog.000001"};
+constexpr std::string_view metadata_name{"binlog.000001.json"};
+
+// io_uring may be unavailable (an old kernel, the
+// 'kernel.io_uring_disabled' sysctl or a container seccomp profile)
+boost::test_tools::assertion_result
+is_io_uring_available(boost::unit_test::test_unit_id /*unused*/) {
+  try {
+    const util::io_uring_queue queue{1U};
+  } catch (const std::runtime_error &) {
+    return false;
+  }
+  return true;
+}
+
+struct storage_directory_fixture {
+  std::filesystem::path directory{
+      std::filesystem::temp_directory_path() /
+      boost::uuids::to_string(boost::uuids::random_generator{}())};
+  binsrv::storage_config config{};
+
+  storage_directory_fixture() {
+    std::filesystem::create_directories(directory);
+    config.get<"backend">() = binsrv::storage_backend_type::io_uring;
+    config.get<"uri">() = "file://" + directory.generic_string();
+  }
+  storage_directory_fixture(const storage_directory_fixture &) = delete;
+  storage_directory_fixture &
+  operator=(const storage_directory_fixture &) = delete;
+  storage_directory_fixture(storage_directory_fixture &&) = delete;
+  storage_directory_fixture &operator=(storage_directory_fixture &&) = delete;
+  ~storage_directory_fixture() {
+    std::error_code remove_ec;
+    std::filesystem::remove_all(directory, remove_ec);
+  }
+
+  [[nodiscard]] std::string read_file(std::string_view name) const {
+    std::ifstream file_ifs{directory / name, std::ios_base::binary};
+    return std::string{std::istreambuf_iterator<char>{file_ifs},
+                       std::istreambuf_iterator<char>{}};
+  }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(IoUringStreamRoundTrip, storage_directory_fixture,
+                        *boost::unit_test::precondition(
+                            is_io_uring_available)) {
+  // larger than 'max_write_slot_size', so that the data is split into
+  // several write slots
+  const std::string large_portion(
+      binsrv::io_uring_filesystem_storage_backend::max_write_slot_size * 2U +
+          42U,
+      'x');
+  std::string expected_content;
+  {
+    binsrv::io_uring_filesystem_storage_backend backend{config};
+    BOOST_CHECK_EQUAL(
+        backend.open_stream(binlog_name,
+                            binsrv::storage_backend_open_stream_mode::create),
+        0U);
+    backend.write_data_to_stream(util::as_const_byte_span("header"));
+    const std::array<util::const_byte_span, 3U> portions{
+        util::as_const_byte_span("-first"), util::as_const_byte_span(""),
+        util::as_const_byte_span(large_portion)};
+    backend.write_data_portions_to_stream(portions);
+    expected_content = "header-first" + large_portion;
+
+    // the metadata update may be deferred until the checkpoint
+    // 'fdatasync()' is finished, but reading it must always wait for it
+    backend.sync_stream();
+    backend.put_object(metadata_name, util::as_const_byte_span("{}"));
+    backend.append_to_object(metadata_name, util::as_const_byte_span("\n"));
+    BOOST_CHECK_EQUAL(backend.get_object(metadata_name), "{}\n");
+
+    backend.write_data_to_stream(util::as_const_byte_span("-tail"));
+    expected_content += "-tail";
+    backend.close_stream();
+  }
+  BOOST_CHECK(read_file(binlog_name) == expected_content);
+
+  binsrv::io_uring_filesystem_storage_backend backend{config};
+  const auto objects{backend.list_objects()};
+  BOOST_REQUIRE(objects.contains(std::string{binlog_name}));
+  BOOST_CHECK_EQUAL(objects.at(std::string{binlog_name}),
+                    std::size(expected_content));
+  BOOST_CHECK(objects.contains(std::string{metadata_name}));
+
+  // reopening the stream for appending continues at the end of the object
+  BOOST_CHECK_EQUAL(
+      backend.open_stream(binlog_name,
+                          binsrv::storage_backend_open_stream_mode::append),
+      std::size(expected_content));
+  backend.write_data_to_stream(util::as_const_byte_span("-appended"));
+  backend.sync_stream();
+  backend.remove_object(metadata_name);
+  backend.close_stream();
+  expected_content += "-appended";
+  BOOST_CHECK(read_file(binlog_name) == expected_content);
+  BOOST_CHECK(!std::filesystem::exists(directory / metadata_name));
+}
+
+BOOST_FIXTURE_TEST_CASE(IoUringFailedObjectModification,
+                        storage_directory_fixture,
+                        *boost::unit_test::precondition(
+                            is_io_uring_available)) {
+  constexpr std::string_view blocked_name{"blocked.json"};
+  constexpr std::string_view next_name{"next.json"};
+  // a directory in place of the tmp file makes putting the object fail
+  const auto blocker_path{directory / (std::string{blocked_name} + ".tmp")};
+  std::filesystem::create_directory(blocker_path);
+
+  binsrv::io_uring_filesystem_storage_backend backend{config};
+  static_cast<void>(backend.open_stream(
+      binlog_name, binsrv::storage_backend_open_stream_mode::create));
+  backend.write_data_to_stream(util::as_const_byte_span("data"));
+  backend.sync_stream();
+
+  // depending on whether the 'fdatasync()' is still in flight, these are
+  // either applied right away or deferred - in the latter case the failure
+  // is raised by one of the operations that follow, and neither the failed
+  // modification nor the ones after it may be lost
+  std::size_t number_of_errors{0U};
+  bool blocked_accepted{true};
+  try {
+    backend.put_object(blocked_name, util::as_const_byte_span("blocked"));
+  } catch (const std::runtime_error &) {
+    blocked_accepted = false;
+    ++number_of_errors;
+  }
+  bool next_accepted{true};
+  try {
+    backend.put_object(next_name, util::as_const_byte_span("next"));
+  } catch (const std::runtime_error &) {
+    next_accepted = false;
+    ++number_of_errors;
+  }
+  try {
+    backend.close_stream();
+  } catch (const std::runtime_error &) {
+    ++number_of_errors;
+  }
+  BOOST_CHECK_NE(number_of_errors, 0U);
+  // a modification never overtakes an earlier deferred one that failed
+  if (blocked_accepted) {
+    BOOST_CHECK(!std::filesystem::exists(directory / next_name));
+  }
+
+  std::filesystem::remove(blocker_path);
+  const auto objects{backend.list_objects()};
+  BOOST_CHECK_EQUAL(objects.contains(std::string{blocked_name}),
+                    blocked_accepted);
+  BOOST_CHECK_EQUAL(objects.contains(std::string{next_name}), next_accepted);
+  if (blocked_accepted) {
+    BOOST_CHECK_EQUAL(read_file(blocked_name), "blocked");
+  }
+}
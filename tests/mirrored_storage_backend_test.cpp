@@ -0,0 +1,184 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#define BOOST_TEST_MODULE MirroredStorageBackendTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include "binsrv/basic_storage_backend.hpp"
+#include "binsrv/storage_backend_factory.hpp"
+#include "binsrv/storage_backend_type.hpp"
+#include "binsrv/storage_config.hpp"
+#include "binsrv/storage_mirror_config.hpp"
+
+#include "util/byte_span.hpp"
+
+namespace {
+
+constexpr std::string_view binlog_name{"binlog.000001"};
+constexpr std::string_view index_name{"binlog.index"};
+
+// the primary storage backend and its only mirror are local filesystem
+// storage backends in separate directories
+struct mirrored_directories_fixture {
+  std::filesystem::path root{
+      std::filesystem::temp_directory_path() /
+      boost::uuids::to_string(boost::uuids::random_generator{}())};
+  std::filesystem::path primary_directory{root / "primary"};
+  std::filesystem::path mirror_directory{root / "mirror"};
+  binsrv::storage_config config{};
+
+  mirrored_directories_fixture() {
+    std::filesystem::create_directories(primary_directory);
+    std::filesystem::create_directories(mirror_directory);
+    config.get<"backend">() = binsrv::storage_backend_type::file;
+    config.get<"uri">() = "file://" + primary_directory.generic_string();
+    config.get<"fs_buffer_directory">() = root.generic_string();
+    auto &mirror_config{config.get<"mirrors">().emplace().emplace_back()};
+    mirror_config.get<"backend">() = binsrv::storage_backend_type::file;
+    mirror_config.get<"uri">() = "file://" + mirror_directory.generic_string();
+  }
+  mirrored_directories_fixture(const mirrored_directories_fixture &) = delete;
+  mirrored_directories_fixture &
+  operator=(const mirrored_directories_fixture &) = delete;
+  mirrored_directories_fixture(mirrored_directories_fixture &&) = delete;
+  mirrored_directories_fixture &
+  operator=(mirrored_directories_fixture &&) = delete;
+  ~mirrored_directories_fixture() {
+    std::error_code remove_ec;
+    std::filesystem::remove_all(root, remove_ec);
+  }
+
+  void set_mirror_required() {
+    config.get<"mirrors">()->front().get<"required">() = true;
+  }
+
+  [[nodiscard]] static std::string
+  read_file(const std::filesystem::path &path) {
+    std::ifstream file_ifs{path, std::ios_base::binary};
+    return std::string{std::istreambuf_iterator<char>{file_ifs},
+                       std::istreambuf_iterator<char>{}};
+  }
+  static void write_file(const std::filesystem::path &path,
+                         std::string_view content) {
+    std::ofstream file_ofs{path, std::ios_base::binary};
+    file_ofs << content;
+  }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(MirroredModifications,
+                        mirrored_directories_fixture) {
+  {
+    const auto backend{binsrv::storage_backend_factory::create(config)};
+    backend->prepare_for_streaming();
+    static_cast<void>(backend->open_stream(
+        binlog_name, binsrv::storage_backend_open_stream_mode::create));
+    backend->write_data_to_stream(util::as_const_byte_span("binlog "));
+    backend->sync_stream();
+    backend->write_data_to_stream(util::as_const_byte_span("data"));
+    backend->close_stream();
+    backend->put_object(index_name, util::as_const_byte_span("first\n"));
+    backend->append_to_object(index_name, util::as_const_byte_span("second\n"));
+    backend->put_object("removed", util::as_const_byte_span("removed"));
+    backend->remove_object("removed");
+    BOOST_CHECK(backend->extract_warnings().empty());
+    // the destructor waits for the pending mirror operations
+  }
+  BOOST_CHECK_EQUAL(read_file(mirror_directory / binlog_name), "binlog data");
+  BOOST_CHECK_EQUAL(read_file(mirror_directory / index_name),
+                    "first\nsecond\n");
+  BOOST_CHECK(!std::filesystem::exists(mirror_directory / "removed"));
+}
+
+BOOST_FIXTURE_TEST_CASE(MirrorResyncOnStart, mirrored_directories_fixture) {
+  write_file(primary_directory / binlog_name, "binlog data");
+  write_file(primary_directory / index_name, "primary\n");
+  // the same size, but a different content
+  write_file(mirror_directory / index_name, "mirror!\n");
+  write_file(mirror_directory / "purged", "purged");
+
+  const auto backend{binsrv::storage_backend_factory::create(config)};
+  // the storages opened for querying never modify the mirrors
+  BOOST_CHECK(!std::filesystem::exists(mirror_directory / binlog_name));
+
+  backend->prepare_for_streaming();
+  BOOST_CHECK_EQUAL(read_file(mirror_directory / binlog_name), "binlog data");
+  BOOST_CHECK_EQUAL(read_file(mirror_directory / index_name), "primary\n");
+  BOOST_CHECK(!std::filesystem::exists(mirror_directory / "purged"));
+  BOOST_CHECK(backend->extract_warnings().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(NonRequiredMirrorDisabled,
+                        mirrored_directories_fixture) {
+  const auto source_path{root / "source"};
+  write_file(source_path, "content");
+
+  const auto backend{binsrv::storage_backend_factory::create(config)};
+  backend->prepare_for_streaming();
+  std::filesystem::remove_all(mirror_directory);
+
+  // 'put_object_from_file()' waits for the mirror to finish reading the
+  // file, so the mirror error is known when it returns
+  backend->put_object_from_file(index_name, source_path);
+  const auto warnings{backend->extract_warnings()};
+  BOOST_CHECK_EQUAL(std::size(warnings), 1U);
+  BOOST_CHECK(backend->extract_warnings().empty());
+  BOOST_CHECK(backend->get_description().find("disabled") !=
+              std::string::npos);
+
+  // the primary is not affected and the mirror is no longer fed
+  std::filesystem::create_directories(mirror_directory);
+  backend->put_object(binlog_name, util::as_const_byte_span("data"));
+  backend->put_object_from_file(index_name, source_path);
+  BOOST_CHECK_EQUAL(read_file(primary_directory / binlog_name), "data");
+  BOOST_CHECK_EQUAL(read_file(primary_directory / index_name), "content");
+  BOOST_CHECK(!std::filesystem::exists(mirror_directory / binlog_name));
+  BOOST_CHECK(backend->extract_warnings().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(RequiredMirrorFailure, mirrored_directories_fixture) {
+  set_mirror_required();
+  const auto source_path{root / "source"};
+  write_file(source_path, "content");
+
+  const auto backend{binsrv::storage_backend_factory::create(config)};
+  backend->prepare_for_streaming();
+  std::filesystem::remove_all(mirror_directory);
+
+  // the error of a required mirror is reported from the next operation
+  backend->put_object_from_file(index_name, source_path);
+  BOOST_CHECK_THROW(
+      backend->put_object(binlog_name, util::as_const_byte_span("data")),
+      std::runtime_error);
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#define BOOST_TEST_MODULE NativeFileOperationsTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include "util/byte_span.hpp"
+#include "util/native_file_operations_helpers.hpp"
+
+namespace {
+
+struct directory_fixture {
+  std::filesystem::path directory{
+      std::filesystem::temp_directory_path() /
+      boost::uuids::to_string(boost::uuids::random_generator{}())};
+
+  directory_fixture() { std::filesystem::create_directories(directory); }
+  directory_fixture(const directory_fixture &) = delete;
+  directory_fixture &operator=(const directory_fixture &) = delete;
+  directory_fixture(directory_fixture &&) = delete;
+  directory_fixture &operator=(directory_fixture &&) = delete;
+  ~directory_fixture() {
+    std::error_code remove_ec;
+    std::filesystem::remove_all(directory, remove_ec);
+  }
+
+  [[nodiscard]] bool is_empty() const {
+    return std::filesystem::is_empty(directory);
+  }
+};
+
+std::string generate_data(std::size_t length, char seed) {
+  std::string result(length, ' ');
+  for (std::size_t index{0U}; index < length; ++index) {
+    result[index] = static_cast<char>(seed + static_cast<char>(index % 26U));
+  }
+  return result;
+}
+
+std::string read_range(const util::native_temporary_file &file,
+                       std::uint64_t offset, std::size_t size) {
+  std::vector<std::byte> buffer(size);
+  file.read(offset, util::byte_span{buffer});
+  return std::string{util::as_string_view(util::const_byte_span{buffer})};
+}
+
+std::string read_back(const util::native_temporary_file &file) {
+  return read_range(file, 0ULL, static_cast<std::size_t>(file.get_size()));
+}
+
+std::string to_string(const util::native_file_mapping &mapping) {
+  return std::string{util::as_string_view(mapping.get_content())};
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(NativeTemporaryFileAppendAndRead, directory_fixture) {
+  util::native_temporary_file file;
+  BOOST_CHECK(!file.is_open());
+  file.open(directory);
+  BOOST_CHECK(file.is_open());
+  BOOST_CHECK_EQUAL(file.get_size(), 0U);
+  // the file must never be visible in the filesystem namespace
+  BOOST_CHECK(is_empty());
+  BOOST_CHECK_THROW(file.open(directory), std::logic_error);
+
+  std::string expected;
+  for (std::size_t length{0U}; length < 64U; length += 7U) {
+    const auto data{generate_data(length, 'a')};
+    file.append(util::as_const_byte_span(data));
+    expected += data;
+  }
+  BOOST_CHECK_EQUAL(file.get_size(), std::size(expected));
+  BOOST_CHECK_EQUAL(read_back(file), expected);
+
+  BOOST_CHECK_EQUAL(read_range(file, 3ULL, 5U), expected.substr(3U, 5U));
+  BOOST_CHECK_THROW(
+      static_cast<void>(read_range(file, std::size(expected) - 2U, 5U)),
+      std::out_of_range);
+
+  file.close();
+  BOOST_CHECK(!file.is_open());
+  BOOST_CHECK_EQUAL(file.get_size(), 0U);
+  BOOST_CHECK(is_empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(NativeTemporaryFileDiscard, directory_fixture) {
+  // the storage spill file is reused across transactions: its content is
+  // discarded (after being flushed or when the transaction is rolled back)
+  // by truncating it to zero
+  util::native_temporary_file file;
+  file.open(directory);
+  const auto first{generate_data(100U, 'a')};
+  file.append(util::as_const_byte_span(first));
+  file.truncate(0ULL);
+  BOOST_CHECK_EQUAL(file.get_size(), 0U);
+  BOOST_CHECK(read_back(file).empty());
+  BOOST_CHECK(file.map().get_content().empty());
+
+  const auto second{generate_data(30U, 'k')};
+  file.append(util::as_const_byte_span(second));
+  BOOST_CHECK_EQUAL(file.get_size(), std::size(second));
+  BOOST_CHECK_EQUAL(read_back(file), second);
+  BOOST_CHECK_EQUAL(to_string(file.map()), second);
+
+  // truncating to a non-zero size keeps the beginning of the data
+  file.truncate(10ULL);
+  BOOST_CHECK_EQUAL(read_back(file), second.substr(0U, 10U));
+}
+
+BOOST_FIXTURE_TEST_CASE(NativeTemporaryFileMap, directory_fixture) {
+  util::native_temporary_file file;
+  file.open(directory);
+  // larger than a memory page, so that the mapping spans several of them
+  const auto data{generate_data(3U * 4096U + 123U, 'a')};
+  file.append(util::as_const_byte_span(data));
+
+  auto mapping{file.map()};
+  BOOST_CHECK_EQUAL(to_string(mapping), data);
+
+  // moving transfers the ownership of the mapped region
+  util::native_file_mapping moved{std::move(mapping)};
+  // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved)
+  BOOST_CHECK(mapping.get_content().empty());
+  BOOST_CHECK_EQUAL(to_string(moved), data);
+
+  // the mapping stays valid after the file is closed
+  file.close();
+  BOOST_CHECK_EQUAL(to_string(moved), data);
+
+  const util::native_file_mapping empty{};
+  BOOST_CHECK(empty.get_content().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(NativeAppendFileWritePortions, directory_fixture) {
+  const auto path{directory / "object"};
+  std::string expected;
+  {
+    util::native_append_file file;
+    BOOST_CHECK_EQUAL(file.open(path, true), 0U);
+    BOOST_CHECK(file.is_open());
+
+    // more portions than a single writev(2) call accepts
+    std::vector<std::string> portion_data;
+    for (std::size_t index{0U}; index < 3000U; ++index) {
+      portion_data.push_back(generate_data(index % 13U, 'a'));
+    }
+    std::vector<util::const_byte_span> portions;
+    for (const auto &data : portion_data) {
+      portions.push_back(util::as_const_byte_span(data));
+      expected += data;
+    }
+    file.write(portions);
+    file.write(util::as_const_byte_span(std::string{"tail"}));
+    expected += "tail";
+    file.datasync();
+    file.close();
+    BOOST_CHECK(!file.is_open());
+  }
+  {
+    util::native_append_file file;
+    BOOST_CHECK_EQUAL(file.open(path, false), std::size(expected));
+    file.write(util::as_const_byte_span(std::string{"more"}));
+    expected += "more";
+  }
+
+  std::ifstream input{path, std::ios_base::binary};
+  const std::string content{std::istreambuf_iterator<char>{input},
+                            std::istreambuf_iterator<char>{}};
+  BOOST_CHECK_EQUAL(content, expected);
+}
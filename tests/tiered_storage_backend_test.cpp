@@ -0,0 +1,173 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#define BOOST_TEST_MODULE TieredStorageBackendTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include "binsrv/basic_storage_backend.hpp"
+#include "binsrv/filesystem_storage_backend.hpp"
+#include "binsrv/size_unit.hpp"
+#include "binsrv/storage_backend_type.hpp"
+#include "binsrv/storage_config.hpp"
+#include "binsrv/tiered_storage_backend.hpp"
+#include "binsrv/tiered_storage_config.hpp"
+
+#include "util/byte_span.hpp"
+
+namespace {
+
+constexpr std::string_view binlog_name{"binlog.000001"};
+constexpr std::string_view index_name{"binlog.index"};
+
+// the cold tier is emulated by a local filesystem storage backend in a
+// separate directory
+struct tiered_directories_fixture {
+  std::filesystem::path root{
+      std::filesystem::temp_directory_path() /
+      boost::uuids::to_string(boost::uuids::random_generator{}())};
+  std::filesystem::path hot_directory{root / "hot"};
+  std::filesystem::path cold_directory{root / "cold"};
+  binsrv::storage_config config{};
+
+  tiered_directories_fixture() {
+    std::filesystem::create_directories(hot_directory);
+    std::filesystem::create_directories(cold_directory);
+    config.get<"backend">() = binsrv::storage_backend_type::tiered;
+    config.get<"uri">() = "file://" + hot_directory.generic_string();
+    auto &tiered_config{config.get<"tiered">().emplace()};
+    tiered_config.get<"cold_uri">() =
+        "file://" + cold_directory.generic_string();
+  }
+  tiered_directories_fixture(const tiered_directories_fixture &) = delete;
+  tiered_directories_fixture &
+  operator=(const tiered_directories_fixture &) = delete;
+  tiered_directories_fixture(tiered_directories_fixture &&) = delete;
+  tiered_directories_fixture &
+  operator=(tiered_directories_fixture &&) = delete;
+  ~tiered_directories_fixture() {
+    std::error_code remove_ec;
+    std::filesystem::remove_all(root, remove_ec);
+  }
+
+  void set_max_local_size(std::string_view value) {
+    config.get<"tiered">()->get<"max_local_size">().emplace(value);
+  }
+
+  [[nodiscard]] std::unique_ptr<binsrv::tiered_storage_backend>
+  create_backend() const {
+    auto cold_config{config};
+    cold_config.get<"backend">() = binsrv::storage_backend_type::file;
+    cold_config.get<"uri">() = config.get<"tiered">()->get<"cold_uri">();
+    return std::make_unique<binsrv::tiered_storage_backend>(
+        config,
+        std::make_unique<binsrv::filesystem_storage_backend>(cold_config));
+  }
+
+  [[nodiscard]] static std::string
+  read_file(const std::filesystem::path &path) {
+    std::ifstream file_ifs{path, std::ios_base::binary};
+    return std::string{std::istreambuf_iterator<char>{file_ifs},
+                       std::istreambuf_iterator<char>{}};
+  }
+};
+
+void stream_binlog(binsrv::basic_storage_backend &backend,
+                   std::string_view data) {
+  static_cast<void>(backend.open_stream(
+      binlog_name, binsrv::storage_backend_open_stream_mode::create));
+  backend.write_data_to_stream(util::as_const_byte_span(data));
+  backend.sync_stream();
+  backend.close_stream();
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(TieredMigrationWithoutEviction,
+                        tiered_directories_fixture) {
+  {
+    const auto backend{create_backend()};
+    backend->prepare_for_streaming();
+    stream_binlog(*backend, "binlog data");
+    backend->put_object(index_name, util::as_const_byte_span("first\n"));
+    backend->append_to_object(index_name, util::as_const_byte_span("second\n"));
+    // the destructor waits for the pending migrations
+  }
+  // without the eviction policy, the hot copies are kept
+  BOOST_CHECK_EQUAL(read_file(hot_directory / binlog_name), "binlog data");
+  BOOST_CHECK_EQUAL(read_file(cold_directory / binlog_name), "binlog data");
+  BOOST_CHECK_EQUAL(read_file(hot_directory / index_name), "first\nsecond\n");
+  BOOST_CHECK_EQUAL(read_file(cold_directory / index_name), "first\nsecond\n");
+
+  // removals are applied to both tiers
+  const auto backend{create_backend()};
+  backend->remove_object(index_name);
+  BOOST_CHECK(!std::filesystem::exists(hot_directory / index_name));
+  BOOST_CHECK(!std::filesystem::exists(cold_directory / index_name));
+  const auto objects{backend->list_objects()};
+  BOOST_CHECK(objects.contains(std::string{binlog_name}));
+  BOOST_CHECK(!objects.contains(std::string{index_name}));
+}
+
+BOOST_FIXTURE_TEST_CASE(TieredEvictionAndRestore,
+                        tiered_directories_fixture) {
+  set_max_local_size("1");
+  {
+    const auto backend{create_backend()};
+    backend->prepare_for_streaming();
+    stream_binlog(*backend, "binlog data");
+    backend->put_object(index_name, util::as_const_byte_span("first\n"));
+  }
+  // every hot copy is evicted once its migration is finished
+  BOOST_CHECK(!std::filesystem::exists(hot_directory / binlog_name));
+  BOOST_CHECK(!std::filesystem::exists(hot_directory / index_name));
+  BOOST_CHECK_EQUAL(read_file(cold_directory / binlog_name), "binlog data");
+  BOOST_CHECK_EQUAL(read_file(cold_directory / index_name), "first\n");
+
+  const auto backend{create_backend()};
+  // evicted objects are listed and read from the cold tier
+  const auto objects{backend->list_objects()};
+  BOOST_CHECK(objects.contains(std::string{binlog_name}));
+  BOOST_CHECK(objects.contains(std::string{index_name}));
+  BOOST_CHECK_EQUAL(backend->get_object(index_name), "first\n");
+
+  // evicted objects are restored into the hot tier before being modified
+  backend->append_to_object(index_name, util::as_const_byte_span("second\n"));
+  BOOST_CHECK_EQUAL(backend->get_object(index_name), "first\nsecond\n");
+  BOOST_CHECK_EQUAL(
+      backend->open_stream(binlog_name,
+                           binsrv::storage_backend_open_stream_mode::append),
+      std::size(std::string_view{"binlog data"}));
+  backend->write_data_to_stream(util::as_const_byte_span(" appended"));
+  backend->close_stream();
+  BOOST_CHECK_EQUAL(backend->get_object(binlog_name), "binlog data appended");
+}
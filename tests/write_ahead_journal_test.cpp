@@ -0,0 +1,257 @@
+// Copyright (c) 2023-2024 Percona and/or its affiliates.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0,
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#define BOOST_TEST_MODULE WriteAheadJournalTests
+// this include is needed as it provides the 'main()' function
+// NOLINTNEXTLINE(misc-include-cleaner)
+#include <boost/test/unit_test.hpp>
+
+#include <boost/test/unit_test_suite.hpp>
+
+#include <boost/test/tools/old/interface.hpp>
+
+#include "util/byte_span.hpp"
+#include "util/write_ahead_journal.hpp"
+
+namespace {
+
+constexpr std::string_view object_name{"binlog.000001"};
+
+struct journal_directory_fixture {
+  std::filesystem::path directory{
+      std::filesystem::temp_directory_path() /
+      boost::uuids::to_string(boost::uuids::random_generator{}())};
+
+  journal_directory_fixture() {
+    std::filesystem::create_directories(directory);
+  }
+  journal_directory_fixture(const journal_directory_fixture &) = delete;
+  journal_directory_fixture &
+  operator=(const journal_directory_fixture &) = delete;
+  journal_directory_fixture(journal_directory_fixture &&) = delete;
+  journal_directory_fixture &operator=(journal_directory_fixture &&) = delete;
+  ~journal_directory_fixture() {
+    std::error_code remove_ec;
+    std::filesystem::remove_all(directory, remove_ec);
+  }
+
+  [[nodiscard]] std::filesystem::path get_file_path() const {
+    return util::write_ahead_journal::get_file_path(directory, object_name);
+  }
+};
+
+void append_string(util::write_ahead_journal &journal, std::string_view data) {
+  const std::array<util::const_byte_span, 1U> portions{
+      util::as_const_byte_span(data)};
+  journal.append(portions);
+}
+
+std::string to_string(const util::write_ahead_journal_content &content) {
+  return std::string{
+      util::as_string_view(util::const_byte_span{content.data})};
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(WriteAheadJournalRoundTrip,
+                        journal_directory_fixture) {
+  util::write_ahead_journal journal;
+  journal.open(directory, object_name, 4U);
+  BOOST_CHECK(journal.is_open());
+  BOOST_CHECK_EQUAL(journal.get_begin_offset(), 4U);
+
+  append_string(journal, "first");
+  const std::array<util::const_byte_span, 3U> portions{
+      util::as_const_byte_span("-sec"), util::as_const_byte_span(""),
+      util::as_const_byte_span("ond")};
+  journal.append(portions);
+  journal.sync();
+  BOOST_CHECK_EQUAL(journal.get_end_offset(), 4U + 12U);
+
+  const auto content{util::write_ahead_journal::load(get_file_path())};
+  BOOST_REQUIRE(content.has_value());
+  BOOST_CHECK_EQUAL(content->object_name, object_name);
+  BOOST_CHECK_EQUAL(content->offset, 4U);
+  BOOST_CHECK_EQUAL(to_string(*content), "first-second");
+
+  journal.discard();
+  BOOST_CHECK(!journal.is_open());
+  BOOST_CHECK(!std::filesystem::exists(get_file_path()));
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteAheadJournalTornRecord,
+                        journal_directory_fixture) {
+  util::write_ahead_journal journal;
+  journal.open(directory, object_name, 0U);
+  append_string(journal, "complete");
+  append_string(journal, "torn record");
+  journal.sync();
+
+  // simulating a crash in the middle of writing the last record
+  std::filesystem::resize_file(get_file_path(),
+                               std::filesystem::file_size(get_file_path()) -
+                                   3U);
+  auto content{util::write_ahead_journal::load(get_file_path())};
+  BOOST_REQUIRE(content.has_value());
+  BOOST_CHECK_EQUAL(to_string(*content), "complete");
+
+  // corrupting the last byte of the first record (followed by the 20-byte
+  // header and the first 8 bytes of the data of the torn one)
+  {
+    std::fstream journal_fs{get_file_path(), std::ios_base::in |
+                                                 std::ios_base::out |
+                                                 std::ios_base::binary};
+    journal_fs.seekp(-29, std::ios_base::end);
+    journal_fs.put('X');
+  }
+  content = util::write_ahead_journal::load(get_file_path());
+  BOOST_REQUIRE(content.has_value());
+  BOOST_CHECK(content->data.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteAheadJournalReset, journal_directory_fixture) {
+  util::write_ahead_journal journal;
+  journal.open(directory, object_name, 0U);
+  append_string(journal, "uploaded");
+  journal.sync();
+
+  journal.reset(journal.get_end_offset());
+  BOOST_CHECK_EQUAL(journal.get_begin_offset(), 8U);
+  append_string(journal, "pending");
+  journal.sync();
+
+  const auto content{util::write_ahead_journal::load(get_file_path())};
+  BOOST_REQUIRE(content.has_value());
+  BOOST_CHECK_EQUAL(content->offset, 8U);
+  BOOST_CHECK_EQUAL(to_string(*content), "pending");
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteAheadJournalInvalidHeader,
+                        journal_directory_fixture) {
+  {
+    std::ofstream journal_ofs{get_file_path(), std::ios_base::binary};
+    journal_ofs << "BWAL";
+  }
+  BOOST_CHECK(!util::write_ahead_journal::load(get_file_path()).has_value());
+
+  util::write_ahead_journal journal;
+  journal.open(directory, object_name, 0U);
+  journal.sync();
+  std::filesystem::resize_file(get_file_path(),
+                               std::filesystem::file_size(get_file_path()) -
+                                   1U);
+  BOOST_CHECK(!util::write_ahead_journal::load(get_file_path()).has_value());
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteAheadJournalLocking, journal_directory_fixture) {
+  util::write_ahead_journal journal;
+  journal.open(directory, object_name, 0U);
+  append_string(journal, "acknowledged");
+  journal.sync();
+
+  // the file of an open journal can be neither reopened by another journal
+  // nor replayed
+  util::write_ahead_journal other;
+  BOOST_CHECK_THROW(other.open(directory, object_name, 0U),
+                    std::runtime_error);
+  BOOST_CHECK(!other.is_open());
+  std::size_t number_of_replayed{0U};
+  util::write_ahead_journal::replay_all(
+      directory, [&number_of_replayed](
+                     const util::write_ahead_journal_content & /*content*/) {
+        ++number_of_replayed;
+      });
+  BOOST_CHECK_EQUAL(number_of_replayed, 0U);
+  const auto content{util::write_ahead_journal::load(get_file_path())};
+  BOOST_REQUIRE(content.has_value());
+  BOOST_CHECK_EQUAL(to_string(*content), "acknowledged");
+
+  // the lock is kept after the journal is reset
+  journal.reset(journal.get_end_offset());
+  BOOST_CHECK_THROW(other.open(directory, object_name, 0U),
+                    std::runtime_error);
+
+  journal.discard();
+  other.open(directory, object_name, 0U);
+  BOOST_CHECK(other.is_open());
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteAheadJournalReplayAll,
+                        journal_directory_fixture) {
+  constexpr std::string_view other_object_name{"binlog.000002"};
+  {
+    // simulating a crash: the file of this journal is left behind
+    util::write_ahead_journal journal;
+    journal.open(directory, object_name, 4U);
+    append_string(journal, "pending");
+    journal.sync();
+  }
+  util::write_ahead_journal active;
+  active.open(directory, other_object_name, 0U);
+  append_string(active, "in use");
+  active.sync();
+  const auto invalid_file_path{directory / "invalid.wal"};
+  {
+    std::ofstream journal_ofs{invalid_file_path, std::ios_base::binary};
+    journal_ofs << "BWAL";
+  }
+
+  std::vector<util::write_ahead_journal_content> replayed;
+  util::write_ahead_journal::replay_all(
+      directory, [&replayed](const util::write_ahead_journal_content &content) {
+        replayed.push_back(content);
+      });
+  BOOST_REQUIRE_EQUAL(std::size(replayed), 1U);
+  BOOST_CHECK_EQUAL(replayed.front().object_name, object_name);
+  BOOST_CHECK_EQUAL(replayed.front().offset, 4U);
+  BOOST_CHECK_EQUAL(to_string(replayed.front()), "pending");
+  BOOST_CHECK(!std::filesystem::exists(get_file_path()));
+  BOOST_CHECK(!std::filesystem::exists(invalid_file_path));
+  // the journal still in use is left intact
+  BOOST_CHECK(std::filesystem::exists(util::write_ahead_journal::get_file_path(
+      directory, other_object_name)));
+
+  // a journal whose replay fails is kept for the next attempt
+  active.discard();
+  {
+    util::write_ahead_journal journal;
+    journal.open(directory, object_name, 0U);
+    append_string(journal, "pending");
+    journal.sync();
+  }
+  BOOST_CHECK_THROW(util::write_ahead_journal::replay_all(
+                        directory,
+                        [](const util::write_ahead_journal_content &) {
+                          throw std::runtime_error{"upload failed"};
+                        }),
+                    std::runtime_error);
+  BOOST_CHECK(std::filesystem::exists(get_file_path()));
+}